@@ -83,9 +83,9 @@ Vec& Vec::operator=(const Vec& right) {
 
 double axilrod_teller(system_t* system) {
     double potential = 0.0, c9, rij, rik, rjk, cos_part;
+    double r, dimg[3];
     molecule_t *molecule1, *molecule2, *molecule3;
     atom_t *atom1, *atom2, *atom3;
-    pair_t temp;
     Vec ij, ik, jk, a, b;
 
     for (molecule1 = system->molecules; molecule1; molecule1 = molecule1->next) {
@@ -125,26 +125,17 @@ double axilrod_teller(system_t* system) {
 
                                     c9 *= 0.0032539449 / (3.166811429 * 0.000001);  // convert H*Bohr^9 to K*Angstrom^9
 
-                                    // reset fake pair ptr
-                                    temp.d_prev[0] = temp.d_prev[1] = temp.d_prev[2] = -999999999999.;
                                     // get minimum image distance
-                                    minimum_image(system, atom1, atom2, &temp);
-                                    rij = temp.rimg;
-                                    ij.set(temp.dimg[0], temp.dimg[1], temp.dimg[2]);
+                                    minimum_image_separation(system, atom1, atom2, &r, &rij, dimg);
+                                    ij.set(dimg[0], dimg[1], dimg[2]);
 
-                                    // reset fake pair ptr
-                                    temp.d_prev[0] = temp.d_prev[1] = temp.d_prev[2] = -999999999999.;
                                     // get minimum image distance
-                                    minimum_image(system, atom1, atom3, &temp);
-                                    rik = temp.rimg;
-                                    ik.set(temp.dimg[0], temp.dimg[1], temp.dimg[2]);
+                                    minimum_image_separation(system, atom1, atom3, &r, &rik, dimg);
+                                    ik.set(dimg[0], dimg[1], dimg[2]);
 
-                                    // reset fake pair ptr
-                                    temp.d_prev[0] = temp.d_prev[1] = temp.d_prev[2] = -999999999999.;
                                     // get minimum image distance
-                                    minimum_image(system, atom2, atom3, &temp);
-                                    rjk = temp.rimg;
-                                    jk.set(temp.dimg[0], temp.dimg[1], temp.dimg[2]);
+                                    minimum_image_separation(system, atom2, atom3, &r, &rjk, dimg);
+                                    jk.set(dimg[0], dimg[1], dimg[2]);
 
                                     cos_part = 3;
 
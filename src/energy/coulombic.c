@@ -28,7 +28,10 @@ double coulombic(system_t *system) {
         potential = coulombic_wolf(system);
     else {
         real = coulombic_real(system);
-        reciprocal = coulombic_reciprocal(system);
+        if (system->spme)
+            reciprocal = spme_reciprocal(system);
+        else
+            reciprocal = coulombic_reciprocal(system);
         self = coulombic_self(system);
 
         /* return the total electrostatic energy */
@@ -38,56 +41,66 @@ double coulombic(system_t *system) {
     return (potential);
 }
 
+/* the term of the i-th k-vector, added to potential */
+static void coulombic_reciprocal_k(system_t *system, int i, void *arg, double *potential) {
+    kspace_t *ks = system->kspace;
+    double SF_re, SF_im; /* structure factor */
+
+    kspace_charges(ks, i, &SF_re, &SF_im);
+    *potential += kspace_energy(ks, i, SF_re, SF_im);
+}
+
 /* fourier space sum */
 double coulombic_reciprocal(system_t *system) {
-    molecule_t *molecule_ptr;
-    atom_t *atom_ptr;
-    int p, q, kmax, l[3];
-    double alpha;
-    double k[3], k_squared, position_product;  //, gaussian (unused variable)
-    double SF_re, SF_im;                       /* structure factor */
-    // double multiplier; //geometric multiplier (unused variable)
-    double potential = 0;
+    double potential;
 
-    alpha = system->ewald_alpha;
-    kmax = system->ewald_kmax;
-
-    // perform the fourier sum over a hemisphere (skipping certain points to avoid overcounting the face)
-    for (l[0] = 0; l[0] <= kmax; l[0]++) {
-        for (l[1] = (!l[0] ? 0 : -kmax); l[1] <= kmax; l[1]++) {
-            for (l[2] = ((!l[0] && !l[1]) ? 1 : -kmax); l[2] <= kmax; l[2]++) {
-                //if norm is out of the sphere, skip
-                if (iidotprod(l, l) > kmax * kmax) continue;
-
-                /* get the reciprocal lattice vectors */
-                for (p = 0; p < 3; p++) {
-                    for (q = 0, k[p] = 0; q < 3; q++)
-                        k[p] += 2.0 * M_PI * system->pbc->reciprocal_basis[p][q] * l[q];
-                }
-                k_squared = dddotprod(k, k);
+    /* inside the mc loop, only the moved molecule's terms of the structure factor need updating */
+    if (system->ewald_sf_cache && system->track_dirty) return (ewald_sf_reciprocal(system));
 
-                /* structure factor */
-                SF_re = 0;
-                SF_im = 0;
-                for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
-                    for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-                        if (atom_ptr->frozen) continue;         //skip frozen
-                        if (atom_ptr->charge == 0.0) continue;  //skip if no charge
+    /* exp(ik.r) of the mobile charged atoms */
+    kspace_atoms(system, 1);
 
-                        /* the inner product of the position vector and the k vector */
-                        position_product = dddotprod(k, atom_ptr->pos);
+    potential = thread_sum(system, system->kspace->nk, coulombic_reciprocal_k, NULL);
 
-                        SF_re += atom_ptr->charge * cos(position_product);
-                        SF_im += atom_ptr->charge * sin(position_product);
+    potential *= 4.0 * M_PI / system->pbc->volume;
 
-                    } /* atom */
-                }     /* molecule */
+    return (potential);
+}
 
-                potential += exp(-k_squared / (4.0 * alpha * alpha)) / k_squared * (SF_re * SF_re + SF_im * SF_im);
+/* change in the term of the i-th k-vector, the added and removed atoms are in the moved tables */
+static void coulombic_reciprocal_delta_k(system_t *system, int i, void *arg, double *potential) {
+    kspace_t *ks = system->kspace;
+    double SF_re, SF_im;   /* structure factor after the move */
+    double dSF_re, dSF_im; /* contribution of the altered molecules */
+    double old_re, old_im; /* structure factor before the move */
 
-            } /* end for n */
-        }     /* end for m */
-    }         /* end for l */
+    kspace_charges(ks, i, &SF_re, &SF_im);
+    kspace_moved_charges(ks, i, &dSF_re, &dSF_im);
+
+    old_re = SF_re - dSF_re;
+    old_im = SF_im - dSF_im;
+    *potential += kspace_energy(ks, i, SF_re, SF_im) - kspace_energy(ks, i, old_re, old_im);
+}
+
+/* change in the fourier space sum when the atoms of "added" enter the system and those of "removed" leave it */
+/* added must already be in the molecule list and removed must already be out of it - either may be NULL */
+double coulombic_reciprocal_delta(system_t *system, molecule_t *added, molecule_t *removed) {
+    double potential;
+    int cached;
+
+    if (system->spme) return (spme_reciprocal_delta(system, added, removed));
+
+    if (system->ewald_sf_cache && system->track_dirty) {
+        potential = ewald_sf_reciprocal_delta(system, &cached);
+        if (cached) return (potential);
+    }
+
+    /* no accepted structure factor to build on (delta_energy turns on ewald_sf_cache, so only at the first */
+    /* move and after a volume move) - the structure factor after the move, and the moved atoms' part of it */
+    kspace_atoms(system, 1);
+    kspace_molecules(system, added, removed);
+
+    potential = thread_sum(system, system->kspace->nk, coulombic_reciprocal_delta_k, NULL);
 
     potential *= 4.0 * M_PI / system->pbc->volume;
 
@@ -112,10 +125,9 @@ double coulombic_self(system_t *system) {
 }
 
 /* feynman-hibbs for real space */
-double coulombic_real_FH(molecule_t *molecule_ptr, pair_t *pair_ptr, double gaussian_term, double erfc_term, system_t *system) {
+double coulombic_real_FH(molecule_t *molecule_ptr, pair_t *pair_ptr, double r, double gaussian_term, double erfc_term, system_t *system) {
     double du, d2u, d3u, d4u;  //derivatives of the pair term
     double fh_2nd_order, fh_4th_order;
-    double r = pair_ptr->rimg;
     double rr = r * r;
     // double rrr = rr*r;  (unused variable)
     double ir = 1.0 / r;
@@ -135,7 +147,7 @@ double coulombic_real_FH(molecule_t *molecule_ptr, pair_t *pair_ptr, double gaus
     fh_2nd_order = (M2A2) * (HBAR2 / (24.0 * KB * system->temperature * reduced_mass)) * (d2u + 2.0 * du / r);
 
     if (order >= 4) {
-        d3u = (gaussian_term / sqrt(M_PI)) * (-8.0 * (a3 * a2) * r - 8.0 * (a3) / r - 12.0 * alpha * ir3) - 6.0 * erfc(alpha * r) * ir4;
+        d3u = (gaussian_term / sqrt(M_PI)) * (-8.0 * (a3 * a2) * r - 8.0 * (a3) / r - 12.0 * alpha * ir3) - 6.0 * erfc_term * ir4;
         d4u = (gaussian_term / sqrt(M_PI)) * (8.0 * a3 * a2 + 16.0 * a3 * a4 * rr + 32.0 * a3 * ir2 + 48.0 * ir4) + 24.0 * erfc_term * (ir4 * ir);
 
         fh_4th_order = M2A4 * (HBAR4 / (1152.0 * (KB * KB * system->temperature * system->temperature * reduced_mass * reduced_mass))) * (15.0 * du * ir3 + 4.0 * d3u / r + d4u);
@@ -145,52 +157,65 @@ double coulombic_real_FH(molecule_t *molecule_ptr, pair_t *pair_ptr, double gaus
     return fh_2nd_order + fh_4th_order;
 }
 
-/* real space sum */
-double coulombic_real(system_t *system) {
-    molecule_t *molecule_ptr;
-    atom_t *atom_ptr;
-    pair_t *pair_ptr;
-    double alpha, r, erfc_term, gaussian_term;
-    double potential, potential_classical;
+/* real space term of a single pair at separation r (rimg with the nearest image) */
+/* if the pair is excluded, its charge-to-screen term is stored in es_self_intra_energy instead */
+double coulombic_real_pair(system_t *system, molecule_t *molecule_ptr, atom_t *atom_ptr, pair_t *pair_ptr, double r, double rimg, double *es_self_intra_energy) {
+    double alpha, erfc_term, gaussian_term;
+    double potential_classical;
+    double es_real_energy = 0;
 
     alpha = system->ewald_alpha;
 
-    potential = 0;
-    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
-        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
-                if (pair_ptr->recalculate_energy) {
-                    pair_ptr->es_real_energy = 0;
+    if (!pair_ptr->frozen) {
+        if (!((rimg > system->pbc->cutoff) || pair_ptr->es_excluded)) { /* unit cell part */
+
+            //calculate potential contribution
+            if (system->ewald_lookup)
+                ewald_table_lookup(system, rimg, &erfc_term, &gaussian_term);
+            else {
+                erfc_term = erfc(alpha * rimg);
+                gaussian_term = exp(-alpha * alpha * rimg * rimg);
+            }
+            potential_classical = atom_ptr->charge * pair_ptr->atom->charge * erfc_term / rimg;
+            es_real_energy += potential_classical;
 
-                    if (!pair_ptr->frozen) {
-                        r = pair_ptr->rimg;
-                        if (!((r > system->pbc->cutoff) || pair_ptr->es_excluded)) { /* unit cell part */
+            if (system->feynman_hibbs)
+                es_real_energy += coulombic_real_FH(molecule_ptr, pair_ptr, rimg, gaussian_term, erfc_term, system);
 
-                            //calculate potential contribution
-                            erfc_term = erfc(alpha * r);
-                            gaussian_term = exp(-alpha * alpha * r * r);
-                            potential_classical = atom_ptr->charge * pair_ptr->atom->charge * erfc_term / r;
-                            //store for pair pointer, so we don't always have to recalculate
-                            pair_ptr->es_real_energy += potential_classical;
+        } else if (pair_ptr->es_excluded) /* calculate the charge-to-screen interaction */
+            *es_self_intra_energy = atom_ptr->charge * pair_ptr->atom->charge * erf(alpha * r) / r;
 
-                            if (system->feynman_hibbs)
-                                pair_ptr->es_real_energy += coulombic_real_FH(molecule_ptr, pair_ptr, gaussian_term, erfc_term, system);
+    } /* frozen */
 
-                        } else if (pair_ptr->es_excluded) /* calculate the charge-to-screen interaction */
-                            pair_ptr->es_self_intra_energy = atom_ptr->charge * pair_ptr->atom->charge * erf(alpha * pair_ptr->r) / pair_ptr->r;
+    return es_real_energy;
+}
 
-                    } /* frozen */
+/* the real space terms of atom i, added to potential */
+static void coulombic_real_atom(system_t *system, int i, void *arg, double *potential) {
+    molecule_t *molecule_ptr = system->molecule_array[i];
+    atom_t *atom_ptr = system->atom_array[i];
+    int n, k, npairs = PAIR_COUNT(system, atom_ptr);
+    double sum = *potential;
 
-                } /* recalculate */
+    for (n = 0; n < npairs; n++) {
+        k = PAIR_INDEX(system, atom_ptr, n);
+        if (atom_ptr->pair_recalculate_energy[k])
+            atom_ptr->pair_es_real_energy[k] = coulombic_real_pair(system, molecule_ptr, atom_ptr, &atom_ptr->pairs[k], atom_ptr->pair_r[k], atom_ptr->pair_rimg[k], &atom_ptr->pair_es_self_intra_energy[k]);
 
-                /* sum all of the pairwise terms */
-                potential += pair_ptr->es_real_energy - pair_ptr->es_self_intra_energy;
+        /* sum all of the pairwise terms */
+        sum += atom_ptr->pair_es_real_energy[k] - atom_ptr->pair_es_self_intra_energy[k];
 
-            } /* pair */
-        }     /* atom */
-    }         /* molecule */
+    } /* pair */
 
-    return (potential);
+    *potential = sum;
+}
+
+/* real space sum */
+double coulombic_real(system_t *system) {
+    /* the lookup table must be current before the threads read it */
+    if (system->ewald_lookup) update_ewald_table(system);
+
+    return (thread_sum(system, system->natoms, coulombic_real_atom, NULL));
 }
 
 /* no ewald summation - regular accumulation of Coulombic terms without out consideration of PBC */
@@ -200,13 +225,15 @@ double coulombic_nopbc(molecule_t *molecules) {
     atom_t *atom_ptr;
     pair_t *pair_ptr;
     double pe, total_pe;
+    int k;
 
     total_pe = 0;
     for (molecule_ptr = molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
                 if (!pair_ptr->es_excluded) {
-                    pe = atom_ptr->charge * pair_ptr->atom->charge / pair_ptr->r;
+                    pe = atom_ptr->charge * pair_ptr->atom->charge / atom_ptr->pair_r[k];
                     total_pe += pe;
                 }
             }
@@ -233,7 +260,7 @@ double coulombic_wolf(system_t * system ) {
 
 	for(molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
 		for(atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-			for(pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
+			for(pair_ptr = atom_ptr->pairs; pair_ptr < atom_ptr->pairs + atom_ptr->npairs; pair_ptr++) {
 
 				if ( pair_ptr->recalculate_energy ) {
 					pair_ptr->es_real_energy = 0;
@@ -266,40 +293,47 @@ double coulombic_wolf(system_t * system ) {
 }
 */
 
+/* wolf term of a single pair at nearest image separation r */
+/* erfaRoverR = erf(alpha*R)/R is constant over the pairs, so the caller supplies it */
+double coulombic_wolf_pair(system_t *system, atom_t *aptr, pair_t *pptr, double r, double erfaRoverR) {
+    double R = system->pbc->cutoff;
+    double iR = 1.0 / R;
+
+    double ir;
+    double es_real_energy = 0;
+
+    ir = 1.0 / r;
+    if ((!pptr->frozen) && (!pptr->es_excluded) && (r < R)) {
+        es_real_energy =
+            aptr->charge * pptr->atom->charge * (ir - erfaRoverR - iR * iR * (R - r));
+
+        // get feynman-hibbs contribution
+        if (system->feynman_hibbs) {
+            error(
+                "COULOMBIC: FH + es_wolf is not implemented\n");
+            die(-1);
+        }  // FH
+    }      // r<cutoff
+
+    return es_real_energy;
+}
+
 double coulombic_wolf(system_t *system) {
     molecule_t *mptr;
     atom_t *aptr;
-    pair_t *pptr;
+    int n, k;
     double pot = 0;
     double alpha = system->ewald_alpha;
     double R = system->pbc->cutoff;
-    double iR = 1.0 / R;
     double erfaRoverR = erf(alpha * R) / R;
 
-    double r, ir;
-
     for (mptr = system->molecules; mptr; mptr = mptr->next) {
         for (aptr = mptr->atoms; aptr; aptr = aptr->next) {
-            for (pptr = aptr->pairs; pptr; pptr = pptr->next) {
-                if (pptr->recalculate_energy) {
-                    pptr->es_real_energy = 0;
-
-                    r = pptr->rimg;
-                    ir = 1.0 / r;
-                    if ((!pptr->frozen) && (!pptr->es_excluded) && (r < R)) {
-                        pptr->es_real_energy =
-                            aptr->charge * pptr->atom->charge * (ir - erfaRoverR - iR * iR * (R - r));
-
-                        // get feynman-hibbs contribution
-                        if (system->feynman_hibbs) {
-                            error(
-                                "COULOMBIC: FH + es_wolf is not implemented\n");
-                            die(-1);
-                        }  // FH
-                    }      // r<cutoff
-
-                }  //recalculate
-                pot += pptr->es_real_energy;
+            for (n = 0; n < PAIR_COUNT(system, aptr); n++) {
+                k = PAIR_INDEX(system, aptr, n);
+                if (aptr->pair_recalculate_energy[k])
+                    aptr->pair_es_real_energy[k] = coulombic_wolf_pair(system, aptr, &aptr->pairs[k], aptr->pair_rimg[k], erfaRoverR);
+                pot += aptr->pair_es_real_energy[k];
             }  //pair
         }      //atom
     }          //molecule
@@ -320,7 +354,7 @@ void test_q(system_t *system) {
 
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next)
+            for (pair_ptr = atom_ptr->pairs; pair_ptr < atom_ptr->pairs + atom_ptr->npairs; pair_ptr++)
                 if (pair_ptr->es_excluded && (molecule_ptr->id != pair_ptr->molecule->id) && atom_ptr->charge != 0 && pair_ptr->atom->charge != 0)
                     fprintf(fp,
                             "DEBUG_LJ: m_id %d %d a_id %d %d %s %s\n", molecule_ptr->id, pair_ptr->molecule->id, atom_ptr->id, pair_ptr->atom->id, atom_ptr->atomtype, pair_ptr->atom->atomtype);
@@ -85,6 +85,7 @@ double coulombic_real_gwp(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
     pair_t *pair_ptr;
+    int k;
     double alpha, r, erfc_term, gaussian_term;
     double potential;
     double potential_classical, potential_fh_second_order, potential_fh_fourth_order;
@@ -96,12 +97,13 @@ double coulombic_real_gwp(system_t *system) {
     potential = 0;
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
-                if (pair_ptr->recalculate_energy) {
-                    pair_ptr->es_real_energy = 0;
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
+                if (atom_ptr->pair_recalculate_energy[k]) {
+                    atom_ptr->pair_es_real_energy[k] = 0;
 
                     if (!pair_ptr->frozen) {
-                        r = pair_ptr->rimg;
+                        r = atom_ptr->pair_rimg[k];
 
                         if (!((r > system->pbc->cutoff) || pair_ptr->es_excluded)) { /* unit cell part */
 
@@ -109,7 +111,7 @@ double coulombic_real_gwp(system_t *system) {
                             gaussian_term = exp(-alpha * alpha * r * r);
 
                             potential_classical = atom_ptr->charge * pair_ptr->atom->charge * erfc_term / r;
-                            pair_ptr->es_real_energy += potential_classical;
+                            atom_ptr->pair_es_real_energy[k] += potential_classical;
 
                             if (system->feynman_hibbs) {
                                 reduced_mass = AMU2KG * molecule_ptr->mass * pair_ptr->molecule->mass / (molecule_ptr->mass + pair_ptr->molecule->mass);
@@ -122,7 +124,7 @@ double coulombic_real_gwp(system_t *system) {
                                 second_derivative += 2.0 * erfc_term / pow(r, 3);
 
                                 potential_fh_second_order = pow(METER2ANGSTROM, 2) * (HBAR * HBAR / (24.0 * KB * system->temperature * reduced_mass)) * (second_derivative + 2.0 * first_derivative / r);
-                                pair_ptr->es_real_energy += potential_fh_second_order;
+                                atom_ptr->pair_es_real_energy[k] += potential_fh_second_order;
 
                                 if (system->feynman_hibbs_order >= 4) {
                                     /* THIRD DERIVATIVE */
@@ -134,19 +136,19 @@ double coulombic_real_gwp(system_t *system) {
                                     fourth_derivative += 24.0 * erfc_term / pow(r, 5);
 
                                     potential_fh_fourth_order = pow(METER2ANGSTROM, 4) * (pow(HBAR, 4) / (1152.0 * pow(KB * system->temperature * reduced_mass, 2))) * (15.0 * first_derivative / pow(r, 3) + 4.0 * third_derivative / r + fourth_derivative);
-                                    pair_ptr->es_real_energy += potential_fh_fourth_order;
+                                    atom_ptr->pair_es_real_energy[k] += potential_fh_fourth_order;
                                 }
                             }
 
                         } else if (pair_ptr->es_excluded) /* calculate the self-intra part */
-                            pair_ptr->es_self_intra_energy = atom_ptr->charge * pair_ptr->atom->charge * erf(alpha * pair_ptr->r) / pair_ptr->r;
+                            atom_ptr->pair_es_self_intra_energy[k] = atom_ptr->charge * pair_ptr->atom->charge * erf(alpha * atom_ptr->pair_r[k]) / atom_ptr->pair_r[k];
 
                     } /* frozen */
 
                 } /* recalculate */
 
                 /* sum all of the pairwise terms */
-                potential += pair_ptr->es_real_energy - pair_ptr->es_self_intra_energy;
+                potential += atom_ptr->pair_es_real_energy[k] - atom_ptr->pair_es_self_intra_energy[k];
 
             } /* pair */
         }     /* atom */
@@ -176,14 +178,16 @@ double coulombic_nopbc_gwp(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
     pair_t *pair_ptr;
+    int k;
     double pe, total_pe;
     double qi, qj, ai, aj, r;
 
     total_pe = 0;
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
-                r = pair_ptr->rimg;
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
+                r = atom_ptr->pair_rimg[k];
                 qi = atom_ptr->charge;
                 qj = pair_ptr->atom->charge;
                 ai = atom_ptr->gwp_alpha;
@@ -22,11 +22,11 @@ double de_fx(double r, double b, double sigma, double c6, double c8, double c10,
     return energy;
 }
 
-double disp_expansion_fh_corr(system_t *system, molecule_t *molecule_ptr, pair_t *pair_ptr, int order) {
+double disp_expansion_fh_corr(system_t *system, molecule_t *molecule_ptr, pair_t *pair_ptr, double rimg, int order) {
     double reduced_mass;
     double dE, d2E, d3E, d4E;  //energy derivatives
     double corr;
-    double ir = 1.0 / pair_ptr->rimg;
+    double ir = 1.0 / rimg;
     double ir2 = ir * ir;
     double ir3 = ir2 * ir;
 
@@ -37,9 +37,9 @@ double disp_expansion_fh_corr(system_t *system, molecule_t *molecule_ptr, pair_t
 
     // I don't really feel like doing the analytical derivatives for this because there will be a million terms in the damping function
     double h = 0.001;                                                                                                                                // this seems to work fine and have atleast an order of magnitude on both sides
-    double pm1 = de_fx(pair_ptr->rimg - h, pair_ptr->epsilon, pair_ptr->sigma, pair_ptr->c6, pair_ptr->c8, pair_ptr->c10, system->damp_dispersion);  // back one
-    double p0 = de_fx(pair_ptr->rimg, pair_ptr->epsilon, pair_ptr->sigma, pair_ptr->c6, pair_ptr->c8, pair_ptr->c10, system->damp_dispersion);       // center
-    double pp1 = de_fx(pair_ptr->rimg + h, pair_ptr->epsilon, pair_ptr->sigma, pair_ptr->c6, pair_ptr->c8, pair_ptr->c10, system->damp_dispersion);  // forward one
+    double pm1 = de_fx(rimg - h, pair_ptr->epsilon, pair_ptr->sigma, pair_ptr->c6, pair_ptr->c8, pair_ptr->c10, system->damp_dispersion);  // back one
+    double p0 = de_fx(rimg, pair_ptr->epsilon, pair_ptr->sigma, pair_ptr->c6, pair_ptr->c8, pair_ptr->c10, system->damp_dispersion);       // center
+    double pp1 = de_fx(rimg + h, pair_ptr->epsilon, pair_ptr->sigma, pair_ptr->c6, pair_ptr->c8, pair_ptr->c10, system->damp_dispersion);  // forward one
 
     dE = (-0.5 * pm1 + 0.5 * pp1) / h;
     d2E = (pm1 - 2.0 * p0 + pp1) / (h * h);
@@ -47,11 +47,11 @@ double disp_expansion_fh_corr(system_t *system, molecule_t *molecule_ptr, pair_t
     //2nd order correction
     corr = M2A2 *
            (HBAR2 / (24.0 * KB * system->temperature * reduced_mass)) *
-           (d2E + 2.0 * dE / pair_ptr->rimg);
+           (d2E + 2.0 * dE / rimg);
 
     if (order >= 4) {
-        double pm2 = de_fx(pair_ptr->rimg - 2.0 * h, pair_ptr->epsilon, pair_ptr->sigma, pair_ptr->c6, pair_ptr->c8, pair_ptr->c10, system->damp_dispersion);  // back two
-        double pp2 = de_fx(pair_ptr->rimg + 2.0 * h, pair_ptr->epsilon, pair_ptr->sigma, pair_ptr->c6, pair_ptr->c8, pair_ptr->c10, system->damp_dispersion);  // forward two
+        double pm2 = de_fx(rimg - 2.0 * h, pair_ptr->epsilon, pair_ptr->sigma, pair_ptr->c6, pair_ptr->c8, pair_ptr->c10, system->damp_dispersion);  // back two
+        double pp2 = de_fx(rimg + 2.0 * h, pair_ptr->epsilon, pair_ptr->sigma, pair_ptr->c6, pair_ptr->c8, pair_ptr->c10, system->damp_dispersion);  // forward two
 
         d3E = (-0.5 * pm2 + pm1 - pp1 + 0.5 * pp2) / (h * h * h);
         d4E = (pm2 - 4.0 * pm1 + 6.0 * p0 - 4.0 * pp1 + pp2) / (h * h * h * h);
@@ -65,10 +65,10 @@ double disp_expansion_fh_corr(system_t *system, molecule_t *molecule_ptr, pair_t
     return corr;
 }
 
-double disp_expansion_lrc(const system_t *system, pair_t *pair_ptr, const double cutoff) /* ignoring the exponential repulsion bit because it decays exponentially */
+double disp_expansion_lrc(const system_t *system, pair_t *pair_ptr, double lrc, const double cutoff) /* ignoring the exponential repulsion bit because it decays exponentially */
 {
     if (!(pair_ptr->frozen) &&                                                      /* disqualify frozen pairs */
-        ((pair_ptr->lrc == 0.0) || pair_ptr->last_volume != system->pbc->volume)) { /* LRC only changes if the volume change */
+        ((lrc == 0.0) || pair_ptr->last_volume != system->pbc->volume)) {           /* LRC only changes if the volume change */
 
         pair_ptr->last_volume = system->pbc->volume;
 
@@ -76,7 +76,7 @@ double disp_expansion_lrc(const system_t *system, pair_t *pair_ptr, const double
     }
 
     else
-        return pair_ptr->lrc; /* use stored value */
+        return lrc; /* use stored value */
 }
 
 double disp_expansion_lrc_self(const system_t *system, atom_t *atom_ptr, const double cutoff) {
@@ -100,61 +100,71 @@ double disp_expansion_lrc_self(const system_t *system, atom_t *atom_ptr, const d
     return atom_ptr->lrc_self; /* use stored value */
 }
 
+/* the pair terms of atom i, added to potential */
+static void disp_expansion_atom(system_t *system, int i, void *arg, double *potential) {
+    molecule_t *molecule_ptr = system->molecule_array[i];
+    atom_t *atom_ptr = system->atom_array[i];
+    pair_t *pair_ptr;
+    int k;
+    double sum = *potential;
+
+    for (k = 0; k < atom_ptr->npairs; k++) {
+        pair_ptr = &atom_ptr->pairs[k];
+        if (atom_ptr->pair_recalculate_energy[k]) {
+            /* pair LRC */
+            if (system->rd_lrc)
+                atom_ptr->pair_lrc[k] = disp_expansion_lrc(system, pair_ptr, atom_ptr->pair_lrc[k], system->pbc->cutoff);
+
+            /* make sure we're not excluded or beyond the cutoff */
+            if (!(pair_ptr->rd_excluded || pair_ptr->frozen)) {
+                const double r = atom_ptr->pair_rimg[k];
+                const double r2 = r * r;
+                const double r4 = r2 * r2;
+                const double r6 = r4 * r2;
+                const double r8 = r6 * r2;
+                const double r10 = r8 * r2;
+
+                double c6 = pair_ptr->c6;
+                const double c8 = pair_ptr->c8;
+                const double c10 = pair_ptr->c10;
+
+                if (system->disp_expansion_mbvdw == 1)
+                    c6 = 0.0;
+
+                double repulsion = 0.0;
+
+                // F0 = 0.001 Eh/bohr aka a.u.
+                // .001/3.166811429E-6*1.8897161646321 = 596.725194095
+                if (pair_ptr->epsilon != 0.0 && pair_ptr->sigma != 0.0)
+                    repulsion = 596.725194095 * 1.0 / pair_ptr->epsilon * exp(-pair_ptr->epsilon * (r - pair_ptr->sigma));
+
+                if (system->damp_dispersion)
+                    atom_ptr->pair_rd_energy[k] = -tt_damping(6, pair_ptr->epsilon * r) * c6 / r6 - tt_damping(8, pair_ptr->epsilon * r) * c8 / r8 - tt_damping(10, pair_ptr->epsilon * r) * c10 / r10 + repulsion;
+                else
+                    atom_ptr->pair_rd_energy[k] = -c6 / r6 - c8 / r8 - c10 / r10 + repulsion;
+
+                if (system->feynman_hibbs)
+                    atom_ptr->pair_rd_energy[k] += disp_expansion_fh_corr(system, molecule_ptr, pair_ptr, atom_ptr->pair_rimg[k], system->feynman_hibbs_order);
+
+                if (system->cavity_autoreject_repulsion != 0.0)
+                    if (repulsion > system->cavity_autoreject_repulsion)
+                        atom_ptr->pair_rd_energy[k] = MAXVALUE;
+            }
+        }
+        sum += atom_ptr->pair_rd_energy[k] + atom_ptr->pair_lrc[k];
+    }
+
+    *potential = sum;
+}
+
 double disp_expansion(system_t *system) {
     double potential = 0.0;
 
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
-    pair_t *pair_ptr;
-
-    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
-        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
-                if (pair_ptr->recalculate_energy) {
-                    /* pair LRC */
-                    if (system->rd_lrc)
-                        pair_ptr->lrc = disp_expansion_lrc(system, pair_ptr, system->pbc->cutoff);
-
-                    /* make sure we're not excluded or beyond the cutoff */
-                    if (!(pair_ptr->rd_excluded || pair_ptr->frozen)) {
-                        const double r = pair_ptr->rimg;
-                        const double r2 = r * r;
-                        const double r4 = r2 * r2;
-                        const double r6 = r4 * r2;
-                        const double r8 = r6 * r2;
-                        const double r10 = r8 * r2;
-
-                        double c6 = pair_ptr->c6;
-                        const double c8 = pair_ptr->c8;
-                        const double c10 = pair_ptr->c10;
-
-                        if (system->disp_expansion_mbvdw == 1)
-                            c6 = 0.0;
-
-                        double repulsion = 0.0;
-
-                        // F0 = 0.001 Eh/bohr aka a.u.
-                        // .001/3.166811429E-6*1.8897161646321 = 596.725194095
-                        if (pair_ptr->epsilon != 0.0 && pair_ptr->sigma != 0.0)
-                            repulsion = 596.725194095 * 1.0 / pair_ptr->epsilon * exp(-pair_ptr->epsilon * (r - pair_ptr->sigma));
-
-                        if (system->damp_dispersion)
-                            pair_ptr->rd_energy = -tt_damping(6, pair_ptr->epsilon * r) * c6 / r6 - tt_damping(8, pair_ptr->epsilon * r) * c8 / r8 - tt_damping(10, pair_ptr->epsilon * r) * c10 / r10 + repulsion;
-                        else
-                            pair_ptr->rd_energy = -c6 / r6 - c8 / r8 - c10 / r10 + repulsion;
-
-                        if (system->feynman_hibbs)
-                            pair_ptr->rd_energy += disp_expansion_fh_corr(system, molecule_ptr, pair_ptr, system->feynman_hibbs_order);
 
-                        if (system->cavity_autoreject_repulsion != 0.0)
-                            if (repulsion > system->cavity_autoreject_repulsion)
-                                pair_ptr->rd_energy = MAXVALUE;
-                    }
-                }
-                potential += pair_ptr->rd_energy + pair_ptr->lrc;
-            }
-        }
-    }
+    /* the pair sum, split over the atoms */
+    potential = thread_sum(system, system->natoms, disp_expansion_atom, NULL);
 
     if (system->disp_expansion_mbvdw == 1) {
         thole_amatrix(system);
@@ -180,14 +190,16 @@ double disp_expansion_nopbc(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
     pair_t *pair_ptr;
+    int k;
 
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
-                if (pair_ptr->recalculate_energy) {
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
+                if (atom_ptr->pair_recalculate_energy[k]) {
                     /* make sure we're not excluded or beyond the cutoff */
                     if (!(pair_ptr->rd_excluded || pair_ptr->frozen)) {
-                        const double r = pair_ptr->rimg;
+                        const double r = atom_ptr->pair_rimg[k];
                         const double r2 = r * r;
                         const double r4 = r2 * r2;
                         const double r6 = r4 * r2;
@@ -207,12 +219,12 @@ double disp_expansion_nopbc(system_t *system) {
                             repulsion = 596.725194095 * 1.0 / pair_ptr->epsilon * exp(-pair_ptr->epsilon * (r - pair_ptr->sigma));
 
                         if (system->damp_dispersion)
-                            pair_ptr->rd_energy = -tt_damping(6, pair_ptr->epsilon * r) * c6 / r6 - tt_damping(8, pair_ptr->epsilon * r) * c8 / r8 - tt_damping(10, pair_ptr->epsilon * r) * c10 / r10 + repulsion;
+                            atom_ptr->pair_rd_energy[k] = -tt_damping(6, pair_ptr->epsilon * r) * c6 / r6 - tt_damping(8, pair_ptr->epsilon * r) * c8 / r8 - tt_damping(10, pair_ptr->epsilon * r) * c10 / r10 + repulsion;
                         else
-                            pair_ptr->rd_energy = -c6 / r6 - c8 / r8 - c10 / r10 + repulsion;
+                            atom_ptr->pair_rd_energy[k] = -c6 / r6 - c8 / r8 - c10 / r10 + repulsion;
                     }
                 }
-                potential += pair_ptr->rd_energy;
+                potential += atom_ptr->pair_rd_energy[k];
             }
         }
     }
@@ -49,13 +49,14 @@ int countNatoms(system_t *system) {
 double cavity_absolute_check(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
-    pair_t *pair_ptr;
+    int n, k;
 
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
-                if (molecule_ptr == pair_ptr->molecule) continue;  //skip if on the same molecule
-                if (pair_ptr->rimg < system->cavity_autoreject_scale)
+            for (n = 0; n < PAIR_COUNT(system, atom_ptr); n++) {
+                k = PAIR_INDEX(system, atom_ptr, n);
+                if (molecule_ptr == atom_ptr->pairs[k].molecule) continue;  //skip if on the same molecule
+                if (atom_ptr->pair_rimg[k] < system->cavity_autoreject_scale)
                     return MAXVALUE;
             }
         }
@@ -67,7 +68,7 @@ double cavity_absolute_check(system_t *system) {
 double energy(system_t *system) {
     // molecule_t *molecule_ptr;  (unused variable)
     double potential_energy, rd_energy, coulombic_energy, polar_energy, vdw_energy, three_body_energy;
-    double kinetic_energy;
+    double kinetic_energy, framework_rd, framework_es;
     // struct timeval old_time, new_time;  (unused variable)
     // char linebuf[MAXLINE];   (unused variable)
 
@@ -85,8 +86,6 @@ double energy(system_t *system) {
     vdw_energy = 0;
     three_body_energy = 0;
 
-    system->natoms = countNatoms(system);
-
     /* get the pairwise terms necessary for the energy calculation */
     pairs(system);
 
@@ -138,6 +137,11 @@ double energy(system_t *system) {
             rd_energy = exp_repulsion(system);
         else if (!system->gwp)
             rd_energy = lj(system);
+
+        /* the interactions with the frozen atoms are read off the framework grid */
+        framework_rd = framework_es = 0;
+        if (system->framework_grid) framework_grid_energy(system, &framework_rd, &framework_es);
+        rd_energy += framework_rd;
         system->observables->rd_energy = rd_energy;
 
         if (system->axilrod_teller) {
@@ -155,6 +159,7 @@ double energy(system_t *system) {
                 system->observables->kinetic_energy = kinetic_energy;
             } else
                 coulombic_energy = coulombic(system);
+            coulombic_energy += framework_es;
             system->observables->coulombic_energy = coulombic_energy;
 
             if (system->polarvdw) {
@@ -225,6 +230,7 @@ double energy(system_t *system) {
 /* routines, widom insertion, etc. */
 double energy_no_observables(system_t *system) {
     double potential_energy, rd_energy, coulombic_energy, polar_energy, vdw_energy, three_body_energy;
+    double framework_rd, framework_es;
 
     /* zero the initial values */
     potential_energy = 0;
@@ -303,6 +309,12 @@ double energy_no_observables(system_t *system) {
     if (system->axilrod_teller)
         three_body_energy = axilrod_teller(system);
 
+    if (system->framework_grid) {
+        framework_grid_energy(system, &framework_rd, &framework_es);
+        rd_energy += framework_rd;
+        coulombic_energy += framework_es;
+    }
+
     /* sum the total potential energy */
     potential_energy = rd_energy + coulombic_energy + polar_energy + vdw_energy + three_body_energy;
 
@@ -0,0 +1,160 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* incremental energy - rather than summing every pair after a single-molecule move, */
+/* only the interactions of the altered molecule with the rest of the system are computed */
+/* the pair caches are left untouched, so a later call to energy() picks up where it left off */
+
+/* accumulate the energy of a single pair, using a scratch pair set up exactly as pairs() would */
+static void pair_interaction(system_t *system, molecule_t *molecule_i, atom_t *atom_i, molecule_t *molecule_j, atom_t *atom_j, int lrc, double cutoff, double erfaRoverR, double *rd_energy, double *es_energy, int *contact) {
+    pair_t pair;
+    double r, rimg, dimg[3], es_self_intra_energy = 0;
+
+    memset(&pair, 0, sizeof(pair_t));
+    pair.atom = atom_j;
+    pair.molecule = molecule_j;
+    pair_exclusions(system, molecule_i, molecule_j, atom_i, atom_j, &pair);
+    if (pair.frozen) return;
+    minimum_image_separation(system, atom_i, atom_j, &r, &rimg, dimg);
+
+    if (system->cavity_autoreject_absolute && (molecule_i != molecule_j) && (rimg < system->cavity_autoreject_scale))
+        *contact = 1;
+
+    if (!system->gwp) {
+        *rd_energy += lj_pair(system, molecule_i, atom_i, &pair, rimg, cutoff);
+        if (lrc) *rd_energy += lj_lrc_corr(system, atom_i, &pair, 0, cutoff);
+    }
+
+    if (!(system->sg || system->rd_only)) {
+        if (system->wolf)
+            *es_energy += coulombic_wolf_pair(system, atom_i, &pair, rimg, erfaRoverR);
+        else
+            *es_energy += coulombic_real_pair(system, molecule_i, atom_i, &pair, r, rimg, &es_self_intra_energy) - es_self_intra_energy;
+    }
+}
+
+/* repulsion/dispersion and electrostatic interaction of molecule_ptr with every other molecule in the list, except skip */
+/* if whole is set, the terms that appear or vanish with the molecule are included as well: */
+/* its intra-molecular pairs, the pair and self LRC, and the ewald self energy */
+static void molecule_interaction(system_t *system, molecule_t *molecule_ptr, molecule_t *skip, int whole, double *rd_energy, double *es_energy, int *contact) {
+    molecule_t *molecule_j;
+    atom_t *atom_ptr, *atom_j;
+    double cutoff, erfaRoverR;
+    int lrc;
+
+    cutoff = lj_cutoff(system);
+    erfaRoverR = erf(system->ewald_alpha * system->pbc->cutoff) / system->pbc->cutoff;
+    lrc = whole && system->rd_lrc;
+
+    *rd_energy = 0;
+    *es_energy = 0;
+    *contact = 0;
+
+    for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
+        for (molecule_j = system->molecules; molecule_j; molecule_j = molecule_j->next) {
+            if ((molecule_j == molecule_ptr) || (molecule_j == skip)) continue;
+            for (atom_j = molecule_j->atoms; atom_j; atom_j = atom_j->next)
+                pair_interaction(system, molecule_ptr, atom_ptr, molecule_j, atom_j, lrc, cutoff, erfaRoverR, rd_energy, es_energy, contact);
+        }
+
+        /* the frozen atoms' part is on the framework grid */
+        if (system->framework_grid) framework_grid_site(system, molecule_ptr, atom_ptr, rd_energy, es_energy);
+
+        if (whole) {
+            /* count each intra-molecular pair once */
+            for (atom_j = atom_ptr->next; atom_j; atom_j = atom_j->next)
+                pair_interaction(system, molecule_ptr, atom_ptr, molecule_ptr, atom_j, lrc, cutoff, erfaRoverR, rd_energy, es_energy, contact);
+
+            if (system->rd_lrc) *rd_energy += lj_lrc_self(system, atom_ptr, cutoff);
+            if (!(system->sg || system->rd_only || system->wolf || atom_ptr->frozen))
+                *es_energy -= system->ewald_alpha * atom_ptr->charge * atom_ptr->charge / sqrt(M_PI);
+        }
+    }
+}
+
+/* returns the energy change of the move that was just made, and updates our observables */
+double energy_delta(system_t *system) {
+    checkpoint_t *checkpoint = system->checkpoint;
+    double rd_new, es_new, rd_old, es_old;
+    double rd_delta, es_delta;
+    int contact_new, contact_old;
+
+    rd_new = es_new = rd_old = es_old = 0;
+    contact_new = 0;
+
+    switch (checkpoint->movetype) {
+        case MOVETYPE_INSERT:
+            molecule_interaction(system, checkpoint->molecule_altered, NULL, 1, &rd_new, &es_new, &contact_new);
+            break;
+        case MOVETYPE_REMOVE:
+            /* the backup is no longer in the list, so it sees exactly the molecules that remain */
+            molecule_interaction(system, checkpoint->molecule_backup, NULL, 1, &rd_old, &es_old, &contact_old);
+            break;
+        case MOVETYPE_DISPLACE:
+        case MOVETYPE_ADIABATIC:
+            /* the molecule is rigid, so its intra-molecular terms cancel */
+            /* the backup holds the old coordinates, but the altered molecule is the one in the list */
+            molecule_interaction(system, checkpoint->molecule_altered, NULL, 0, &rd_new, &es_new, &contact_new);
+            molecule_interaction(system, checkpoint->molecule_backup, checkpoint->molecule_altered, 0, &rd_old, &es_old, &contact_old);
+            break;
+        default:
+            error(
+                "ENERGY_DELTA: invalid mc move\n");
+            die(-1);
+    }
+
+    /* number of atoms changed, the pair indices of the neighbor list are stale */
+    if ((checkpoint->movetype == MOVETYPE_INSERT) || (checkpoint->movetype == MOVETYPE_REMOVE)) {
+        system->natoms = countNatoms(system);
+        system->nlist_natoms = -1;
+    }
+
+    /* store wrapped coords, only the altered molecule moved */
+    if (!system->track_dirty)
+        wrapall(system->molecules, system->pbc);
+    else if (checkpoint->molecule_altered)
+        wrap_molecule(checkpoint->molecule_altered, system->pbc);
+
+    countN(system);
+    system->observables->spin_ratio /= system->observables->N;
+
+    /* treat a bad contact just like energy() does */
+    if (contact_new) {
+        system->count_autorejects++;
+        system->observables->energy = MAXVALUE;
+        return (MAXVALUE);
+    }
+
+    rd_delta = rd_new - rd_old;
+    es_delta = es_new - es_old;
+
+    /* the fourier space term changes with every charged, non-frozen atom that moved */
+    if (!(system->sg || system->rd_only || system->wolf)) {
+        switch (checkpoint->movetype) {
+            case MOVETYPE_INSERT:
+                es_delta += coulombic_reciprocal_delta(system, checkpoint->molecule_altered, NULL);
+                break;
+            case MOVETYPE_REMOVE:
+                es_delta += coulombic_reciprocal_delta(system, NULL, checkpoint->molecule_backup);
+                break;
+            default:
+                es_delta += coulombic_reciprocal_delta(system, checkpoint->molecule_altered, checkpoint->molecule_backup);
+        }
+    }
+
+    system->observables->rd_energy += rd_delta;
+    system->observables->coulombic_energy += es_delta;
+    system->observables->energy += rd_delta + es_delta;
+
+    /* need this for the isosteric heat */
+    system->observables->NU = system->observables->N * system->observables->energy;
+
+    return (rd_delta + es_delta);
+}
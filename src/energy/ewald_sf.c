@@ -0,0 +1,196 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* the ewald structure factor S(k) = sum_i q_i exp(ik.r_i) of the accepted configuration is kept between mc steps */
+/* a move only changes the terms of the altered molecule, so S(k) is updated by removing its old */
+/* contribution and adding the new one - a rejected move puts the old S(k) back */
+
+/* (re)allocate for the current k-vectors */
+static void ewald_sf_setup(system_t *system) {
+    ewald_sf_t *sf = system->ewald_sf;
+    int nk = system->kspace->nk;
+
+    free(sf->re);
+    free(sf->im);
+    free(sf->old_re);
+    free(sf->old_im);
+    sf->re = malloc(nk * sizeof(double));
+    memnullcheck(sf->re, nk * sizeof(double), __LINE__ - 1, __FILE__);
+    sf->im = malloc(nk * sizeof(double));
+    memnullcheck(sf->im, nk * sizeof(double), __LINE__ - 1, __FILE__);
+    sf->old_re = malloc(nk * sizeof(double));
+    memnullcheck(sf->old_re, nk * sizeof(double), __LINE__ - 1, __FILE__);
+    sf->old_im = malloc(nk * sizeof(double));
+    memnullcheck(sf->old_im, nk * sizeof(double), __LINE__ - 1, __FILE__);
+
+    sf->nk = nk;
+    sf->version = system->kspace->version;
+    sf->valid = 0;
+}
+
+/* the k-vectors changed after a volume move or a change of the ewald parameters */
+static int ewald_sf_stale(system_t *system) {
+    kspace_update(system);
+
+    return (system->ewald_sf->version != system->kspace->version);
+}
+
+/* tabulate exp(ik.r) of the atoms of the altered molecule, at its new and old positions */
+static void ewald_sf_molecules(system_t *system) {
+    checkpoint_t *checkpoint = system->checkpoint;
+
+    kspace_molecules(system,
+                     (checkpoint->movetype != MOVETYPE_REMOVE) ? checkpoint->molecule_altered : NULL,
+                     (checkpoint->movetype != MOVETYPE_INSERT) ? checkpoint->molecule_backup : NULL);
+}
+
+/* full structure factor of the i-th k-vector, and its term of the fourier sum */
+static void ewald_sf_full_k(system_t *system, int i, void *arg, double *potential) {
+    ewald_sf_t *sf = system->ewald_sf;
+    double re, im;
+
+    kspace_charges(system->kspace, i, &re, &im);
+
+    sf->re[i] = re;
+    sf->im[i] = im;
+    *potential += kspace_energy(system->kspace, i, re, im);
+}
+
+/* move the altered molecule's terms of the i-th structure factor, keeping the old value */
+static void ewald_sf_update_k(system_t *system, int i, void *arg, double *potential) {
+    ewald_sf_t *sf = system->ewald_sf;
+    double re, im;
+
+    sf->old_re[i] = sf->re[i];
+    sf->old_im[i] = sf->im[i];
+    kspace_moved_charges(system->kspace, i, &re, &im);
+    re += sf->re[i];
+    im += sf->im[i];
+
+    sf->re[i] = re;
+    sf->im[i] = im;
+    *potential += kspace_energy(system->kspace, i, re, im);
+}
+
+/* term of the i-th k-vector from the stored structure factor */
+static void ewald_sf_energy_k(system_t *system, int i, void *arg, double *potential) {
+    ewald_sf_t *sf = system->ewald_sf;
+
+    *potential += kspace_energy(system->kspace, i, sf->re[i], sf->im[i]);
+}
+
+/* sum S(k) over all atoms, keeping the accepted one if a move is in progress */
+static double ewald_sf_full(system_t *system) {
+    ewald_sf_t *sf = system->ewald_sf;
+    double potential;
+
+    if (ewald_sf_stale(system))
+        ewald_sf_setup(system);
+    else if (sf->pending && sf->valid) {
+        memcpy(sf->old_re, sf->re, sf->nk * sizeof(double));
+        memcpy(sf->old_im, sf->im, sf->nk * sizeof(double));
+        sf->applied = 1;
+    }
+    if (sf->pending && !sf->applied) sf->rebuilt = 1;
+
+    kspace_atoms(system, 1);
+    potential = thread_sum(system, sf->nk, ewald_sf_full_k, NULL);
+    sf->valid = 1;
+    sf->updates = 0;
+    sf->pending = 0;
+
+    return (potential);
+}
+
+/* fourier space sum of the current configuration, from the cached structure factor */
+double ewald_sf_reciprocal(system_t *system) {
+    ewald_sf_t *sf;
+    double potential;
+
+    if (!system->ewald_sf) {
+        system->ewald_sf = calloc(1, sizeof(ewald_sf_t));
+        memnullcheck(system->ewald_sf, sizeof(ewald_sf_t), __LINE__ - 1, __FILE__);
+        kspace_update(system);
+        ewald_sf_setup(system);
+    }
+    sf = system->ewald_sf;
+
+    if (!sf->valid || ewald_sf_stale(system) || (sf->updates >= system->ewald_sf_refresh))
+        potential = ewald_sf_full(system);
+    else if (sf->pending) {
+        ewald_sf_molecules(system);
+        potential = thread_sum(system, sf->nk, ewald_sf_update_k, NULL);
+        sf->applied = 1;
+        sf->pending = 0;
+    } else
+        potential = thread_sum(system, sf->nk, ewald_sf_energy_k, NULL);
+
+    return (potential * 4.0 * M_PI / system->pbc->volume);
+}
+
+/* change in the fourier space sum over the current move - returns 0 with *ok unset if there is no accepted S(k) to build on */
+double ewald_sf_reciprocal_delta(system_t *system, int *ok) {
+    ewald_sf_t *sf = system->ewald_sf;
+    double old_potential, potential;
+
+    *ok = sf && sf->valid && !ewald_sf_stale(system);
+    if (!*ok) return (0);
+
+    old_potential = thread_sum(system, sf->nk, ewald_sf_energy_k, NULL);
+    if (sf->pending) {
+        ewald_sf_molecules(system);
+        potential = thread_sum(system, sf->nk, ewald_sf_update_k, NULL);
+        sf->applied = 1;
+        sf->pending = 0;
+    } else
+        potential = old_potential;
+
+    return ((potential - old_potential) * 4.0 * M_PI / system->pbc->volume);
+}
+
+/* a move was made, S(k) has yet to see it */
+void ewald_sf_move(system_t *system) {
+    ewald_sf_t *sf = system->ewald_sf;
+
+    /* a spin flip leaves the charges where they are */
+    sf->pending = (system->checkpoint->movetype != MOVETYPE_SPINFLIP);
+    sf->applied = 0;
+    sf->rebuilt = 0;
+}
+
+/* the move was rejected, go back to the accepted S(k) */
+void ewald_sf_restore(system_t *system) {
+    ewald_sf_t *sf = system->ewald_sf;
+
+    if (sf->applied) {
+        memcpy(sf->re, sf->old_re, sf->nk * sizeof(double));
+        memcpy(sf->im, sf->old_im, sf->nk * sizeof(double));
+        sf->valid = 1;
+    } else if (sf->rebuilt)
+        sf->valid = 0; /* nothing to go back to, start over */
+
+    sf->pending = 0;
+    sf->applied = 0;
+    sf->rebuilt = 0;
+}
+
+/* the move was accepted, S(k) as it stands belongs to the new configuration */
+void ewald_sf_accept(system_t *system) {
+    ewald_sf_t *sf = system->ewald_sf;
+
+    /* the move never reached the fourier sum (e.g. a bad contact), so S(k) can't be trusted */
+    if (sf->pending) sf->valid = 0;
+    /* only the accepted updates stay in S(k), so only they count towards the refresh */
+    if (sf->applied) sf->updates++;
+
+    sf->pending = 0;
+    sf->applied = 0;
+    sf->rebuilt = 0;
+}
@@ -0,0 +1,119 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* lookup table for the ewald real-space kernel - erfc(alpha*r) and exp(-alpha^2*r^2) are */
+/* stored on a uniform grid in r together with their derivatives, and interpolated with */
+/* cubic hermite splines, so that no transcendentals are evaluated per pair */
+
+/* the two tabulated functions, and their derivatives with respect to r */
+static void ewald_table_analytic(double alpha, double r, double *f) {
+    double gaussian = exp(-alpha * alpha * r * r);
+
+    f[0] = erfc(alpha * r);
+    f[1] = -2.0 * alpha * gaussian / sqrt(M_PI);
+    f[2] = gaussian;
+    f[3] = -2.0 * alpha * alpha * r * gaussian;
+}
+
+/* (re)build the table for the current ewald_alpha and cutoff */
+void setup_ewald_table(system_t *system) {
+    ewald_table_t *table;
+    int i, first;
+    double f[4], r, erfc_term, gaussian_term, err;
+    char linebuf[MAXLINE];
+
+    first = !system->ewald_table;
+    if (first) {
+        system->ewald_table = calloc(1, sizeof(ewald_table_t));
+        memnullcheck(system->ewald_table, sizeof(ewald_table_t), __LINE__ - 1, __FILE__);
+    } else
+        free(system->ewald_table->values);
+    table = system->ewald_table;
+
+    table->alpha = system->ewald_alpha;
+    table->cutoff = system->pbc->cutoff;
+    table->h = 1.0 / system->ewald_lookup_density;
+    /* one extra interval so that r == cutoff has a right-hand node */
+    table->n = (int)ceil(table->cutoff / table->h) + 2;
+
+    /* per node: erfc, h*d(erfc)/dr, gaussian, h*d(gaussian)/dr */
+    table->values = malloc(4 * table->n * sizeof(double));
+    memnullcheck(table->values, 4 * table->n * sizeof(double), __LINE__ - 1, __FILE__);
+    for (i = 0; i < table->n; i++) {
+        ewald_table_analytic(table->alpha, i * table->h, f);
+        table->values[4 * i] = f[0];
+        table->values[4 * i + 1] = table->h * f[1];
+        table->values[4 * i + 2] = f[2];
+        table->values[4 * i + 3] = table->h * f[3];
+    }
+
+    /* the interpolation error is largest between the nodes */
+    table->max_error = 0;
+    for (i = 0; i < table->n - 1; i++) {
+        r = (i + 0.5) * table->h;
+        ewald_table_analytic(table->alpha, r, f);
+        ewald_table_lookup(system, r, &erfc_term, &gaussian_term);
+        err = fabs(erfc_term - f[0]);
+        if (err > table->max_error) table->max_error = err;
+        err = fabs(gaussian_term - f[2]);
+        if (err > table->max_error) table->max_error = err;
+    }
+
+    if (table->max_error > EWALD_LOOKUP_TOLERANCE) {
+        sprintf(linebuf,
+                "EWALD_TABLE: interpolation error %e exceeds %e, increase ewald_lookup_density\n", table->max_error, EWALD_LOOKUP_TOLERANCE);
+        error(linebuf);
+        die(-1);
+    }
+
+    if (first) {
+        sprintf(linebuf,
+                "EWALD_TABLE: tabulated the real-space kernel at %d points, max interpolation error %e\n", table->n, table->max_error);
+        output(linebuf);
+    }
+}
+
+/* rebuild the table if alpha or the cutoff changed */
+void update_ewald_table(system_t *system) {
+    ewald_table_t *table = system->ewald_table;
+
+    if (!table || (table->alpha != system->ewald_alpha) || (table->cutoff != system->pbc->cutoff))
+        setup_ewald_table(system);
+}
+
+/* interpolate erfc(alpha*r) and exp(-alpha^2*r^2) */
+/* called from the threaded pair sums, so the table is only read here - it is kept current by pbc() */
+/* (at setup and on volume moves) and by coulombic_real() before the threads start */
+void ewald_table_lookup(system_t *system, double r, double *erfc_term, double *gaussian_term) {
+    ewald_table_t *table = system->ewald_table;
+    double t, u, h00, h10, h01, h11;
+    double *v;
+    int i;
+
+    t = r / table->h;
+    i = (int)t;
+    /* beyond the table, fall back to the analytic form */
+    if (i >= table->n - 1) {
+        *erfc_term = erfc(table->alpha * r);
+        *gaussian_term = exp(-table->alpha * table->alpha * r * r);
+        return;
+    }
+    u = t - i;
+
+    /* cubic hermite basis */
+    h01 = u * u * (3.0 - 2.0 * u);
+    h00 = 1.0 - h01;
+    h10 = u * (1.0 - u) * (1.0 - u);
+    h11 = u * u * (u - 1.0);
+
+    v = &table->values[4 * i];
+    *erfc_term = h00 * v[0] + h10 * v[1] + h01 * v[4] + h11 * v[5];
+    *gaussian_term = h00 * v[2] + h10 * v[3] + h01 * v[6] + h11 * v[7];
+}
@@ -0,0 +1,158 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* choose ewald_alpha and ewald_kmax for a requested accuracy - the truncation errors of the two sums are */
+/* estimated as in Kolafa and Perram, Mol. Simul. 9 351, for the actual box and charges, and each way of splitting */
+/* the error between them gives an (alpha, kmax) pair */
+/* the real-space cutoff is shared with repulsion/dispersion, so it is left alone - the real-space sum then */
+/* costs the same for any alpha, while the fourier sum grows as kmax^3, so the split that needs the smallest */
+/* kmax is kept, and of those the most accurate one */
+
+/* estimated real-space energy error */
+static double ewald_tune_real_error(double Q, double cutoff, double volume, double alpha) {
+    return (Q * sqrt(0.5 * cutoff / volume) * exp(-alpha * alpha * cutoff * cutoff) / (alpha * alpha * cutoff * cutoff));
+}
+
+/* estimated fourier space energy error - length is the longest lattice vector, which has the coarsest k-spacing */
+static double ewald_tune_recip_error(double Q, double length, double alpha, int kmax) {
+    double x = M_PI * kmax / (alpha * length);
+
+    return (Q * alpha / (M_PI * M_PI) * pow((double)kmax, -1.5) * exp(-x * x));
+}
+
+/* smallest alpha that keeps the real-space error below tolerance */
+static double ewald_tune_alpha(double Q, double cutoff, double volume, double tolerance) {
+    double lo, hi, mid;
+    int i;
+
+    /* the error falls monotonically once alpha*cutoff > 1 */
+    lo = 1.0 / cutoff;
+    hi = 2.0 / cutoff;
+    while (ewald_tune_real_error(Q, cutoff, volume, hi) > tolerance) hi *= 2.0;
+    if (ewald_tune_real_error(Q, cutoff, volume, lo) <= tolerance) return (lo);
+
+    for (i = 0; i < 100; i++) {
+        mid = 0.5 * (lo + hi);
+        if (ewald_tune_real_error(Q, cutoff, volume, mid) > tolerance)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return (hi);
+}
+
+/* smallest kmax that keeps the fourier space error below tolerance */
+static int ewald_tune_kmax(double Q, double length, double alpha, double tolerance) {
+    int kmax;
+
+    for (kmax = 1; kmax < EWALD_TUNE_MAX_KMAX; kmax++)
+        if (ewald_tune_recip_error(Q, length, alpha, kmax) <= tolerance) break;
+
+    return (kmax);
+}
+
+void ewald_tune(system_t *system) {
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+    int i, p, q, splits, kmax, best_kmax;
+    double Q, Q_all, Q_real, tolerance, length, side, fraction, alpha, error;
+    double best_alpha, best_error;
+    char linebuf[MAXLINE];
+
+    /* frozen atoms only enter through their terms with the mobile ones - in the real-space sum, */
+    /* and in the fourier sum with ewald_framework */
+    Q = Q_all = 0;
+    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
+            if (!atom_ptr->frozen) Q += atom_ptr->charge * atom_ptr->charge;
+            Q_all += atom_ptr->charge * atom_ptr->charge;
+        }
+    }
+    /* a uVT run may start empty, count one of each molecule to be inserted instead */
+    if (Q == 0.0) {
+        for (molecule_ptr = system->insertion_molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
+            for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+                Q += atom_ptr->charge * atom_ptr->charge;
+        Q_all += Q;
+    }
+    if (Q == 0.0) {
+        output(
+            "EWALD_TUNE: no mobile charges, keeping the ewald parameters\n");
+        return;
+    }
+
+    Q_real = sqrt(Q * Q_all);
+    if (system->ewald_framework) Q = Q_real;
+
+    /* requested error relative to the energy of two unit charges 1 A apart */
+    tolerance = system->ewald_precision * E2REDUCED * E2REDUCED;
+
+    for (p = 0, length = 0; p < 3; p++) {
+        for (q = 0, side = 0; q < 3; q++)
+            side += system->pbc->basis[p][q] * system->pbc->basis[p][q];
+        if (sqrt(side) > length) length = sqrt(side);
+    }
+
+    best_alpha = system->ewald_alpha;
+    best_kmax = system->ewald_kmax;
+    best_error = MAXVALUE;
+
+    if (system->spme) {
+        /* the mesh sets the fourier space error, so all of it goes to the real-space sum */
+        if (!system->ewald_alpha_set)
+            best_alpha = ewald_tune_alpha(Q_real, system->pbc->cutoff, system->pbc->volume, tolerance);
+        best_error = ewald_tune_real_error(Q_real, system->pbc->cutoff, system->pbc->volume, best_alpha);
+    } else {
+        /* with alpha given, only kmax is left to choose */
+        splits = system->ewald_alpha_set ? 1 : EWALD_TUNE_SPLITS;
+        for (i = 0; i < splits; i++) {
+            if (system->ewald_alpha_set) {
+                alpha = system->ewald_alpha;
+                error = ewald_tune_real_error(Q_real, system->pbc->cutoff, system->pbc->volume, alpha);
+                fraction = (error < tolerance) ? error * error / (tolerance * tolerance) : 0.5;
+            } else {
+                /* share of the squared error given to the real-space sum */
+                fraction = (i + 1.0) / (splits + 1.0);
+                alpha = ewald_tune_alpha(Q_real, system->pbc->cutoff, system->pbc->volume, tolerance * sqrt(fraction));
+            }
+            kmax = ewald_tune_kmax(Q, length, alpha, tolerance * sqrt(1.0 - fraction));
+            error = sqrt(pow(ewald_tune_real_error(Q_real, system->pbc->cutoff, system->pbc->volume, alpha), 2) + pow(ewald_tune_recip_error(Q, length, alpha, kmax), 2));
+
+            if (!i || (kmax < best_kmax) || ((kmax == best_kmax) && (error < best_error))) {
+                best_alpha = alpha;
+                best_kmax = kmax;
+                best_error = error;
+            }
+        }
+
+        if (best_kmax >= EWALD_TUNE_MAX_KMAX) {
+            sprintf(linebuf,
+                    "EWALD_TUNE: ewald_precision %e is not reached below kmax = %d, consider a larger pbc_cutoff\n", system->ewald_precision, EWALD_TUNE_MAX_KMAX);
+            output(linebuf);
+        }
+    }
+
+    /* keep the tuned values through volume moves */
+    system->ewald_alpha = best_alpha;
+    system->ewald_kmax = best_kmax;
+    system->ewald_alpha_set = 1;
+    if (!system->polar_ewald_alpha_set) {
+        system->polar_ewald_alpha = best_alpha;
+        system->polar_ewald_alpha_set = 1;
+    }
+
+    /* the real-space lookup follows alpha */
+    if (system->ewald_lookup) update_ewald_table(system);
+
+    sprintf(linebuf,
+            "EWALD_TUNE: using alpha = %f kmax = %d, estimated error %e K\n", system->ewald_alpha, system->ewald_kmax, best_error);
+    output(linebuf);
+}
@@ -8,11 +8,11 @@ University of South Florida
 
 #include <mc.h>
 
-double exp_fh_corr(system_t *system, molecule_t *molecule_ptr, pair_t *pair_ptr, int order, double pot) {
+double exp_fh_corr(system_t *system, molecule_t *molecule_ptr, pair_t *pair_ptr, double rimg, int order, double pot) {
     double reduced_mass;
     double dE, d2E, d3E, d4E;  //energy derivatives
     double corr;
-    double ir = 1.0 / pair_ptr->rimg;
+    double ir = 1.0 / rimg;
     double ir2 = ir * ir;
     double ir3 = ir2 * ir;
     // double ir4 = ir3*ir;   (unused variable)
@@ -28,7 +28,7 @@ double exp_fh_corr(system_t *system, molecule_t *molecule_ptr, pair_t *pair_ptr,
     //2nd order correction
     corr = M2A2 *
            (HBAR2 / (24.0 * KB * system->temperature * reduced_mass)) *
-           (d2E + 2.0 * dE / pair_ptr->rimg);
+           (d2E + 2.0 * dE / rimg);
 
     if (order >= 4) {
         d3E = -d2E / (2.0 * pair_ptr->epsilon);
@@ -43,7 +43,7 @@ double exp_fh_corr(system_t *system, molecule_t *molecule_ptr, pair_t *pair_ptr,
     return corr;
 }
 
-double exp_lrc_corr(system_t *system, atom_t *atom_ptr, pair_t *pair_ptr, double cutoff) {
+double exp_lrc_corr(system_t *system, atom_t *atom_ptr, pair_t *pair_ptr, double lrc, double cutoff) {
     double eps = pair_ptr->epsilon;
     double rover2e = cutoff / (2.0 * eps);
 
@@ -53,14 +53,14 @@ double exp_lrc_corr(system_t *system, atom_t *atom_ptr, pair_t *pair_ptr, double
     if ((pair_ptr->epsilon != 0 && pair_ptr->sigma != 0) &&                          //if these are zero, then we won't waste our time
         !(atom_ptr->spectre && pair_ptr->atom->spectre) &&                           //i think we want to disqualify s-s pairs
         !(pair_ptr->frozen) &&                                                       //disqualify frozen pairs
-        ((pair_ptr->lrc == 0.0) || pair_ptr->last_volume != system->pbc->volume)) {  //LRC only changes if the volume change
+        ((lrc == 0.0) || pair_ptr->last_volume != system->pbc->volume)) {            //LRC only changes if the volume change
 
         pair_ptr->last_volume = system->pbc->volume;
 
         return (8.0 * M_PI) * exp(1. - rover2e) * (cutoff * cutoff + 4.0 * eps * cutoff + 8.0 * eps * eps) * pair_ptr->sigma / system->pbc->volume;
 
     } else
-        return pair_ptr->lrc;  //use stored value
+        return lrc;  //use stored value
 }
 
 double exp_lrc_self(system_t *system, atom_t *atom_ptr, double cutoff) {
@@ -105,14 +105,76 @@ double exp_crystal_self(system_t *system, atom_t *aptr, double cutoff) {
     return aptr->sigma * term;
 }
 
-double exp_repulsion(system_t *system) {
-    molecule_t *molecule_ptr;
-    atom_t *atom_ptr;
+/* the pair terms of atom i, added to potential */
+static void exp_repulsion_atom(system_t *system, int i, void *arg, double *potential) {
+    molecule_t *molecule_ptr = system->molecule_array[i];
+    atom_t *atom_ptr = system->atom_array[i];
     pair_t *pair_ptr;
+    int k;
     double r, term;
-    double potential, potential_classical, cutoff;
-    int i[3], p, q;
+    double potential_classical, cutoff = *(double *)arg;
+    int n[3], p, q;
     double a[3];
+    double sum = *potential;
+
+    for (k = 0; k < atom_ptr->npairs; k++) {
+        pair_ptr = &atom_ptr->pairs[k];
+        if (atom_ptr->pair_recalculate_energy[k]) {
+            atom_ptr->pair_rd_energy[k] = 0;
+
+            // pair LRC
+            if (system->rd_lrc) atom_ptr->pair_lrc[k] = exp_lrc_corr(system, atom_ptr, pair_ptr, atom_ptr->pair_lrc[k], cutoff);
+
+            // to include a contribution, we require
+            if ((atom_ptr->pair_rimg[k] - SMALL_dR < cutoff)       //inside cutoff?
+                && (!pair_ptr->rd_excluded || system->rd_crystal)  //either not excluded OR rd_crystal is ON
+                && !pair_ptr->frozen)                              //not frozen
+            {
+                //loop over unit cells
+                if (system->rd_crystal) {
+                    term = 0;
+                    for (n[0] = -(system->rd_crystal_order); n[0] <= system->rd_crystal_order; n[0]++)
+                        for (n[1] = -(system->rd_crystal_order); n[1] <= system->rd_crystal_order; n[1]++)
+                            for (n[2] = -(system->rd_crystal_order); n[2] <= system->rd_crystal_order; n[2]++) {
+                                if (!n[0] && !n[1] && !n[2] && pair_ptr->rd_excluded) continue;  //no i=j=k=0 for excluded pairs (intra-molecular)
+                                //calculate pair separation (atom with it's image)
+                                for (p = 0; p < 3; p++) {
+                                    a[p] = 0;
+                                    for (q = 0; q < 3; q++)
+                                        a[p] += system->pbc->basis[q][p] * n[q];
+                                    a[p] += atom_ptr->pos[p] - pair_ptr->atom->pos[p];
+                                }
+                                r = sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+
+                                if (r + SMALL_dR > cutoff) continue;
+                                term += exp(-r / (2.0 * pair_ptr->epsilon));
+                            }
+                } else  //otherwise, calculate as normal
+                    term = exp(-atom_ptr->pair_rimg[k] / (2.0 * pair_ptr->epsilon));
+
+                potential_classical = pair_ptr->sigma * term;
+                atom_ptr->pair_rd_energy[k] += potential_classical;
+
+                if (system->feynman_hibbs)
+                    atom_ptr->pair_rd_energy[k] +=
+                        exp_fh_corr(system, molecule_ptr, pair_ptr, atom_ptr->pair_rimg[k], system->feynman_hibbs_order, potential_classical);
+
+            }  //count contributions
+
+        } /* if recalculate */
+
+        /* sum all of the pairwise terms */
+        sum += atom_ptr->pair_rd_energy[k] + atom_ptr->pair_lrc[k];
+
+    } /* pair */
+
+    *potential = sum;
+}
+
+double exp_repulsion(system_t *system) {
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+    double potential, cutoff;
 
     //set the cutoff
     if (system->rd_crystal)
@@ -120,60 +182,8 @@ double exp_repulsion(system_t *system) {
     else
         cutoff = system->pbc->cutoff;
 
-    potential = 0;
-    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
-        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
-                if (pair_ptr->recalculate_energy) {
-                    pair_ptr->rd_energy = 0;
-
-                    // pair LRC
-                    if (system->rd_lrc) pair_ptr->lrc = exp_lrc_corr(system, atom_ptr, pair_ptr, cutoff);
-
-                    // to include a contribution, we require
-                    if ((pair_ptr->rimg - SMALL_dR < cutoff)               //inside cutoff?
-                        && (!pair_ptr->rd_excluded || system->rd_crystal)  //either not excluded OR rd_crystal is ON
-                        && !pair_ptr->frozen)                              //not frozen
-                    {
-                        //loop over unit cells
-                        if (system->rd_crystal) {
-                            term = 0;
-                            for (i[0] = -(system->rd_crystal_order); i[0] <= system->rd_crystal_order; i[0]++)
-                                for (i[1] = -(system->rd_crystal_order); i[1] <= system->rd_crystal_order; i[1]++)
-                                    for (i[2] = -(system->rd_crystal_order); i[2] <= system->rd_crystal_order; i[2]++) {
-                                        if (!i[0] && !i[1] && !i[2] && pair_ptr->rd_excluded) continue;  //no i=j=k=0 for excluded pairs (intra-molecular)
-                                        //calculate pair separation (atom with it's image)
-                                        for (p = 0; p < 3; p++) {
-                                            a[p] = 0;
-                                            for (q = 0; q < 3; q++)
-                                                a[p] += system->pbc->basis[q][p] * i[q];
-                                            a[p] += atom_ptr->pos[p] - pair_ptr->atom->pos[p];
-                                        }
-                                        r = sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
-
-                                        if (r + SMALL_dR > cutoff) continue;
-                                        term += exp(-r / (2.0 * pair_ptr->epsilon));
-                                    }
-                        } else  //otherwise, calculate as normal
-                            term = exp(-pair_ptr->rimg / (2.0 * pair_ptr->epsilon));
-
-                        potential_classical = pair_ptr->sigma * term;
-                        pair_ptr->rd_energy += potential_classical;
-
-                        if (system->feynman_hibbs)
-                            pair_ptr->rd_energy +=
-                                exp_fh_corr(system, molecule_ptr, pair_ptr, system->feynman_hibbs_order, potential_classical);
-
-                    }  //count contributions
-
-                } /* if recalculate */
-
-                /* sum all of the pairwise terms */
-                potential += pair_ptr->rd_energy + pair_ptr->lrc;
-
-            } /* pair */
-        }     /* atom */
-    }         /* molecule */
+    /* the pair sum, split over the atoms */
+    potential = thread_sum(system, system->natoms, exp_repulsion_atom, &cutoff);
 
     /* molecule self-energy for rd_crystal -> energy of molecule interacting with its periodic neighbors */
 
@@ -197,14 +207,16 @@ double exp_repulsion_nopbc(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
     pair_t *pair_ptr;
+    int k;
     double potential;
 
     for (molecule_ptr = molecules, potential = 0; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
                 /* make sure we're not excluded or beyond the cutoff */
                 if (!pair_ptr->rd_excluded)
-                    potential += pair_ptr->sigma * exp(-pair_ptr->rimg / (2.0 * pair_ptr->epsilon));
+                    potential += pair_ptr->sigma * exp(-atom_ptr->pair_rimg[k] / (2.0 * pair_ptr->epsilon));
 
             } /* pair */
         }     /* atom */
@@ -218,6 +230,7 @@ void test_exp(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
     pair_t *pair_ptr;
+    int k;
     char poo[MAXLINE];
     sprintf(poo,
             "%d.lj", system->step);
@@ -226,9 +239,11 @@ void test_exp(system_t *system) {
 
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next)
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
                 fprintf(fp,
-                        "DEBUG_LJ: m_id %d %d a_id %d %d rimg %.3lf\n", molecule_ptr->id, pair_ptr->molecule->id, atom_ptr->id, pair_ptr->atom->id, pair_ptr->rimg);
+                        "DEBUG_LJ: m_id %d %d a_id %d %d rimg %.3lf\n", molecule_ptr->id, pair_ptr->molecule->id, atom_ptr->id, pair_ptr->atom->id, atom_ptr->pair_rimg[k]);
+            }
 
     fclose(fp);
 
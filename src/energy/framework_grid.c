@@ -0,0 +1,351 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* framework energy grid - the potential of the frozen atoms is tabulated once, */
+/* for each type of mobile site, on a periodic grid in fractional coordinates */
+/* the mobile-frozen pairs are then excluded from the pair kernels (see pair_exclusions) */
+/* and their energy is read off the grid by tricubic interpolation */
+
+/* do these two sites interact with the framework identically? */
+static int framework_grid_same_site(system_t *system, molecule_t *mi, atom_t *ai, molecule_t *mj, atom_t *aj) {
+    if ((ai->epsilon != aj->epsilon) || (ai->sigma != aj->sigma) || (ai->charge != aj->charge)) return 0;
+    if ((ai->polarizability != aj->polarizability) || (ai->omega != aj->omega)) return 0;
+    if ((ai->c6 != aj->c6) || (ai->c8 != aj->c8) || (ai->c10 != aj->c10)) return 0;
+    if (ai->spectre != aj->spectre) return 0;
+    /* the feynman-hibbs correction depends on the reduced mass of the molecule pair */
+    if (system->feynman_hibbs && (mi->mass != mj->mass)) return 0;
+
+    return 1;
+}
+
+/* find the grid type of a mobile site */
+static int framework_grid_type(system_t *system, molecule_t *molecule_ptr, atom_t *atom_ptr) {
+    framework_grid_t *grid = system->fw_grid;
+    int t;
+
+    for (t = 0; t < grid->ntypes; t++)
+        if (framework_grid_same_site(system, &grid->site_molecules[t], &grid->sites[t], molecule_ptr, atom_ptr)) return t;
+
+    return -1;
+}
+
+/* register the mobile sites of a molecule list */
+static void framework_grid_add_sites(system_t *system, molecule_t *molecules, int *max_types) {
+    framework_grid_t *grid = system->fw_grid;
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+
+    for (molecule_ptr = molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
+        if (molecule_ptr->frozen) continue;
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
+            if (atom_ptr->frozen) continue;
+            if (framework_grid_type(system, molecule_ptr, atom_ptr) >= 0) continue;
+
+            if (grid->ntypes == *max_types) {
+                *max_types *= 2;
+                grid->sites = realloc(grid->sites, *max_types * sizeof(atom_t));
+                memnullcheck(grid->sites, *max_types * sizeof(atom_t), __LINE__ - 1, __FILE__);
+                grid->site_molecules = realloc(grid->site_molecules, *max_types * sizeof(molecule_t));
+                memnullcheck(grid->site_molecules, *max_types * sizeof(molecule_t), __LINE__ - 1, __FILE__);
+            }
+
+            /* keep a detached copy of the site parameters */
+            memset(&grid->sites[grid->ntypes], 0, sizeof(atom_t));
+            memset(&grid->site_molecules[grid->ntypes], 0, sizeof(molecule_t));
+            strcpy(grid->sites[grid->ntypes].atomtype, atom_ptr->atomtype);
+            grid->sites[grid->ntypes].epsilon = atom_ptr->epsilon;
+            grid->sites[grid->ntypes].sigma = atom_ptr->sigma;
+            grid->sites[grid->ntypes].charge = atom_ptr->charge;
+            grid->sites[grid->ntypes].polarizability = atom_ptr->polarizability;
+            grid->sites[grid->ntypes].omega = atom_ptr->omega;
+            grid->sites[grid->ntypes].c6 = atom_ptr->c6;
+            grid->sites[grid->ntypes].c8 = atom_ptr->c8;
+            grid->sites[grid->ntypes].c10 = atom_ptr->c10;
+            grid->sites[grid->ntypes].spectre = atom_ptr->spectre;
+            grid->site_molecules[grid->ntypes].mass = molecule_ptr->mass;
+            grid->site_molecules[grid->ntypes].atoms = &grid->sites[grid->ntypes];
+            grid->ntypes++;
+        }
+    }
+}
+
+/* tabulate the frozen atoms' potential for every mobile site type */
+void setup_framework_grid(system_t *system) {
+    framework_grid_t *grid;
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr, unit_site;
+    molecule_t unit_molecule;
+    pair_t **type_pairs, *unit_pairs, *pair_ptr;
+    double *frozen_x, *frozen_y, *frozen_z, *dx, *dy, *dz, *rimg;
+    int nfrozen, max_types, npoints, nes;
+    int j, t, p, q, g, x[3];
+    double s[3], pos[3], r, cutoff, erfaRoverR, es_self_intra_energy;
+    char linebuf[MAXLINE];
+
+    grid = system->fw_grid = calloc(1, sizeof(framework_grid_t));
+    memnullcheck(grid, sizeof(framework_grid_t), __LINE__ - 1, __FILE__);
+
+    /* collect the site types from the initial configuration and the insertion list */
+    max_types = 4;
+    grid->sites = calloc(max_types, sizeof(atom_t));
+    memnullcheck(grid->sites, max_types * sizeof(atom_t), __LINE__ - 1, __FILE__);
+    grid->site_molecules = calloc(max_types, sizeof(molecule_t));
+    memnullcheck(grid->site_molecules, max_types * sizeof(molecule_t), __LINE__ - 1, __FILE__);
+    framework_grid_add_sites(system, system->molecules, &max_types);
+    if (system->insertion_molecules) framework_grid_add_sites(system, system->insertion_molecules, &max_types);
+    /* realloc moved the sites, so point the molecules at them again */
+    for (t = 0; t < grid->ntypes; t++)
+        grid->site_molecules[t].atoms = &grid->sites[t];
+
+    /* the frozen atoms */
+    for (molecule_ptr = system->molecules, nfrozen = 0; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            if (atom_ptr->frozen) nfrozen++;
+    /* their coordinates and displacements are kept in flat arrays for minimum_image_batch() */
+    frozen_x = calloc(7 * (nfrozen + 1), sizeof(double));
+    memnullcheck(frozen_x, 7 * (nfrozen + 1) * sizeof(double), __LINE__ - 1, __FILE__);
+    frozen_y = frozen_x + (nfrozen + 1);
+    frozen_z = frozen_y + (nfrozen + 1);
+    dx = frozen_z + (nfrozen + 1);
+    dy = dx + (nfrozen + 1);
+    dz = dy + (nfrozen + 1);
+    rimg = dz + (nfrozen + 1);
+
+    /* mixing and exclusions for each (site type, frozen atom) pair, set up once */
+    type_pairs = calloc(grid->ntypes, sizeof(pair_t *));
+    memnullcheck(type_pairs, grid->ntypes * sizeof(pair_t *), __LINE__ - 1, __FILE__);
+    for (t = 0; t < grid->ntypes; t++) {
+        type_pairs[t] = calloc(nfrozen + 1, sizeof(pair_t));
+        memnullcheck(type_pairs[t], (nfrozen + 1) * sizeof(pair_t), __LINE__ - 1, __FILE__);
+    }
+    unit_pairs = calloc(nfrozen + 1, sizeof(pair_t));
+    memnullcheck(unit_pairs, (nfrozen + 1) * sizeof(pair_t), __LINE__ - 1, __FILE__);
+
+    /* without feynman-hibbs, the electrostatics are linear in the site charge, so a unit charge serves every type */
+    memset(&unit_site, 0, sizeof(atom_t));
+    memset(&unit_molecule, 0, sizeof(molecule_t));
+    unit_site.charge = 1.0;
+    unit_molecule.atoms = &unit_site;
+    grid->shared_es = !system->feynman_hibbs;
+
+    grid->lrc = calloc(grid->ntypes, sizeof(double));
+    memnullcheck(grid->lrc, grid->ntypes * sizeof(double), __LINE__ - 1, __FILE__);
+
+    cutoff = lj_cutoff(system);
+    for (molecule_ptr = system->molecules, j = 0; molecule_ptr; molecule_ptr = molecule_ptr->next) {
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
+            if (!atom_ptr->frozen) continue;
+            frozen_x[j] = atom_ptr->pos[0];
+            frozen_y[j] = atom_ptr->pos[1];
+            frozen_z[j] = atom_ptr->pos[2];
+
+            for (t = 0; t < grid->ntypes; t++) {
+                pair_ptr = &type_pairs[t][j];
+                pair_ptr->atom = atom_ptr;
+                pair_ptr->molecule = molecule_ptr;
+                pair_exclusions(system, &grid->site_molecules[t], molecule_ptr, &grid->sites[t], atom_ptr, pair_ptr);
+                pair_ptr->frozen = 0; /* the grid is where these pairs are evaluated */
+                if (system->rd_lrc) grid->lrc[t] += lj_lrc_corr(system, &grid->sites[t], pair_ptr, 0, cutoff);
+            }
+
+            pair_ptr = &unit_pairs[j];
+            pair_ptr->atom = atom_ptr;
+            pair_ptr->molecule = molecule_ptr;
+            pair_exclusions(system, &unit_molecule, molecule_ptr, &unit_site, atom_ptr, pair_ptr);
+            pair_ptr->frozen = 0;
+
+            j++;
+        }
+    }
+
+    /* enough points along each lattice vector for the requested spacing */
+    for (p = 0; p < 3; p++) {
+        for (q = 0, r = 0; q < 3; q++)
+            r += system->pbc->basis[p][q] * system->pbc->basis[p][q];
+        grid->n[p] = (int)ceil(sqrt(r) / system->framework_grid_spacing);
+        if (grid->n[p] < 4) grid->n[p] = 4;
+    }
+    npoints = grid->n[0] * grid->n[1] * grid->n[2];
+
+    nes = grid->shared_es ? 1 : grid->ntypes;
+    grid->rd = calloc(grid->ntypes, sizeof(double *));
+    memnullcheck(grid->rd, grid->ntypes * sizeof(double *), __LINE__ - 1, __FILE__);
+    grid->es = calloc(grid->ntypes, sizeof(double *));
+    memnullcheck(grid->es, grid->ntypes * sizeof(double *), __LINE__ - 1, __FILE__);
+    for (t = 0; t < grid->ntypes; t++) {
+        grid->rd[t] = calloc(npoints, sizeof(double));
+        memnullcheck(grid->rd[t], npoints * sizeof(double), __LINE__ - 1, __FILE__);
+        if (t < nes) {
+            grid->es[t] = calloc(npoints, sizeof(double));
+            memnullcheck(grid->es[t], npoints * sizeof(double), __LINE__ - 1, __FILE__);
+        } else
+            grid->es[t] = grid->es[0];
+    }
+
+    sprintf(linebuf,
+            "INPUT: tabulating the framework potential of %d frozen atoms for %d site types on a %dx%dx%d grid\n",
+            nfrozen, grid->ntypes, grid->n[0], grid->n[1], grid->n[2]);
+    output(linebuf);
+
+    erfaRoverR = erf(system->ewald_alpha * system->pbc->cutoff) / system->pbc->cutoff;
+    for (x[0] = 0, g = 0; x[0] < grid->n[0]; x[0]++) {
+        for (x[1] = 0; x[1] < grid->n[1]; x[1]++) {
+            for (x[2] = 0; x[2] < grid->n[2]; x[2]++, g++) {
+                /* cartesian position of the grid point */
+                for (p = 0; p < 3; p++)
+                    s[p] = (double)x[p] / (double)grid->n[p];
+                for (p = 0; p < 3; p++)
+                    for (q = 0, pos[p] = 0; q < 3; q++)
+                        pos[p] += system->pbc->basis[q][p] * s[q];
+
+                minimum_image_batch(system->pbc, pos, nfrozen, frozen_x, frozen_y, frozen_z, dx, dy, dz, rimg);
+
+                for (j = 0; j < nfrozen; j++) {
+                    /* every kernel vanishes beyond the cutoff */
+                    if (rimg[j] - SMALL_dR >= cutoff && rimg[j] > system->pbc->cutoff) continue;
+
+                    /* only rimg enters the kernels of these (never excluded) pairs */
+                    for (t = 0; t < grid->ntypes; t++) {
+                        pair_ptr = &type_pairs[t][j];
+                        grid->rd[t][g] += lj_pair(system, &grid->site_molecules[t], &grid->sites[t], pair_ptr, rimg[j], cutoff);
+
+                        if (!grid->shared_es && !system->rd_only) {
+                            if (system->wolf)
+                                grid->es[t][g] += coulombic_wolf_pair(system, &grid->sites[t], pair_ptr, rimg[j], erfaRoverR);
+                            else
+                                grid->es[t][g] += coulombic_real_pair(system, &grid->site_molecules[t], &grid->sites[t], pair_ptr, rimg[j], rimg[j], &es_self_intra_energy);
+                        }
+                    }
+
+                    if (grid->shared_es && !system->rd_only) {
+                        pair_ptr = &unit_pairs[j];
+                        if (system->wolf)
+                            grid->es[0][g] += coulombic_wolf_pair(system, &unit_site, pair_ptr, rimg[j], erfaRoverR);
+                        else
+                            grid->es[0][g] += coulombic_real_pair(system, &unit_molecule, &unit_site, pair_ptr, rimg[j], rimg[j], &es_self_intra_energy);
+                    }
+                } /* frozen atom */
+
+                /* keep the overlap region finite so that it can be interpolated */
+                for (t = 0; t < grid->ntypes; t++) {
+                    if (grid->rd[t][g] > FRAMEWORK_GRID_MAX) grid->rd[t][g] = FRAMEWORK_GRID_MAX;
+                    if (t < nes) {
+                        if (grid->es[t][g] > FRAMEWORK_GRID_MAX) grid->es[t][g] = FRAMEWORK_GRID_MAX;
+                        if (grid->es[t][g] < -FRAMEWORK_GRID_MAX) grid->es[t][g] = -FRAMEWORK_GRID_MAX;
+                    }
+                }
+            }
+        }
+    }
+
+    for (t = 0; t < grid->ntypes; t++)
+        free(type_pairs[t]);
+    free(type_pairs);
+    free(unit_pairs);
+    free(frozen_x);
+
+    output(
+        "INPUT: finished tabulating the framework potential\n");
+}
+
+/* catmull-rom weights and periodic indices of the 4 grid points around fractional coordinates s, along each axis */
+void grid_catmull_rom(int *n, double *s, double w[3][4], int idx[3][4]) {
+    int p, a, i0;
+    double u, t;
+
+    for (p = 0; p < 3; p++) {
+        u = s[p] * n[p];
+        i0 = (int)floor(u);
+        t = u - i0;
+        w[p][0] = 0.5 * ((-t + 2.0) * t - 1.0) * t;
+        w[p][1] = 0.5 * ((3.0 * t - 5.0) * t * t + 2.0);
+        w[p][2] = 0.5 * ((-3.0 * t + 4.0) * t + 1.0) * t;
+        w[p][3] = 0.5 * (t - 1.0) * t * t;
+        for (a = 0; a < 4; a++) {
+            idx[p][a] = (i0 + a - 1) % n[p];
+            if (idx[p][a] < 0) idx[p][a] += n[p];
+        }
+    }
+}
+
+/* tricubic (catmull-rom) interpolation on the periodic grid at fractional coordinates s */
+/* the result is bounded by the enclosing cell's corners, so steep walls can't ring into false minima */
+static double framework_grid_interpolate(framework_grid_t *grid, double *values, double *s) {
+    int a, b, c, idx[3][4];
+    double w[3][4], wab, v, sum, vmin, vmax;
+
+    grid_catmull_rom(grid->n, s, w, idx);
+
+    sum = 0;
+    vmin = MAXVALUE;
+    vmax = -MAXVALUE;
+    for (a = 0; a < 4; a++) {
+        for (b = 0; b < 4; b++) {
+            wab = w[0][a] * w[1][b];
+            for (c = 0; c < 4; c++) {
+                v = values[(idx[0][a] * grid->n[1] + idx[1][b]) * grid->n[2] + idx[2][c]];
+                sum += wab * w[2][c] * v;
+                if ((a == 1 || a == 2) && (b == 1 || b == 2) && (c == 1 || c == 2)) {
+                    if (v < vmin) vmin = v;
+                    if (v > vmax) vmax = v;
+                }
+            }
+        }
+    }
+
+    if (sum < vmin) sum = vmin;
+    if (sum > vmax) sum = vmax;
+
+    return (sum);
+}
+
+/* framework energy of a single mobile site */
+void framework_grid_site(system_t *system, molecule_t *molecule_ptr, atom_t *atom_ptr, double *rd_energy, double *es_energy) {
+    framework_grid_t *grid = system->fw_grid;
+    int t, p, q;
+    double s[3];
+    char linebuf[MAXLINE];
+
+    t = framework_grid_type(system, molecule_ptr, atom_ptr);
+    if (t < 0) {
+        sprintf(linebuf,
+                "FRAMEWORK_GRID: site %.32s was not tabulated\n", atom_ptr->atomtype);
+        error(linebuf);
+        die(-1);
+    }
+
+    /* fractional coordinates, wrapped into the unit cell */
+    for (p = 0; p < 3; p++) {
+        for (q = 0, s[p] = 0; q < 3; q++)
+            s[p] += system->pbc->reciprocal_basis[q][p] * atom_ptr->pos[q];
+        s[p] -= floor(s[p]);
+    }
+
+    *rd_energy += framework_grid_interpolate(grid, grid->rd[t], s) + grid->lrc[t];
+
+    if (!system->rd_only) {
+        if (grid->shared_es)
+            *es_energy += atom_ptr->charge * framework_grid_interpolate(grid, grid->es[0], s);
+        else
+            *es_energy += framework_grid_interpolate(grid, grid->es[t], s);
+    }
+}
+
+/* framework energy of every mobile site */
+void framework_grid_energy(system_t *system, double *rd_energy, double *es_energy) {
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+
+    *rd_energy = 0;
+    *es_energy = 0;
+    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            if (!atom_ptr->frozen) framework_grid_site(system, molecule_ptr, atom_ptr, rd_energy, es_energy);
+}
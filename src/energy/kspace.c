@@ -0,0 +1,339 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* k-vectors shared by the ewald fourier sums (electrostatics, static and induced polarization fields) */
+/* for each atom, exp(i l 2pi s_q) is tabulated for every integer l along each lattice direction q, */
+/* where s are the fractional coordinates - exp(ik.r) is then the product of three table entries, */
+/* and no cos/sin is evaluated inside the k-vector loops - one cos/sin per atom and direction builds the table */
+
+/* the k-vectors are stale after a volume move or a change of the ewald parameters */
+static int kspace_stale(system_t *system) {
+    kspace_t *ks = system->kspace;
+
+    return ((ks->kmax != system->ewald_kmax) || (ks->alpha != system->ewald_alpha) || (ks->polar_alpha != system->polar_ewald_alpha) || memcmp(ks->basis, system->pbc->basis, 9 * sizeof(double)));
+}
+
+/* complex entries of the table of one atom - l[0] = 0 .. kmax, l[1] and l[2] = -kmax .. kmax */
+static int kspace_width(int kmax) {
+    return (5 * kmax + 3);
+}
+
+/* tabulate exp(i l 2pi s_q) of one atom into e */
+static void kspace_tabulate(system_t *system, atom_t *atom_ptr, double *e) {
+    int kmax = system->kspace->kmax;
+    int m, p, q;
+    double s, c1, s1, *t;
+
+    for (q = 0; q < 3; q++) {
+        /* fractional coordinate along lattice vector q */
+        for (p = 0, s = 0; p < 3; p++)
+            s += system->pbc->reciprocal_basis[p][q] * atom_ptr->pos[p];
+        c1 = cos(2.0 * M_PI * s);
+        s1 = sin(2.0 * M_PI * s);
+
+        /* exp(i l theta) = exp(i (l-1) theta) * exp(i theta), and the conjugate for -l */
+        if (!q) {
+            t = e;
+            t[0] = 1.0;
+            t[1] = 0.0;
+            for (m = 1; m <= kmax; m++) {
+                t[2 * m] = t[2 * m - 2] * c1 - t[2 * m - 1] * s1;
+                t[2 * m + 1] = t[2 * m - 2] * s1 + t[2 * m - 1] * c1;
+            }
+        } else {
+            t = &e[2 * (kmax + 1 + (q - 1) * (2 * kmax + 1) + kmax)];
+            t[0] = 1.0;
+            t[1] = 0.0;
+            for (m = 1; m <= kmax; m++) {
+                t[2 * m] = t[2 * m - 2] * c1 - t[2 * m - 1] * s1;
+                t[2 * m + 1] = t[2 * m - 2] * s1 + t[2 * m - 1] * c1;
+                t[-2 * m] = t[2 * m];
+                t[-2 * m + 1] = -t[2 * m + 1];
+            }
+        }
+    }
+}
+
+/* exp(ik.r) of the i-th k-vector, from the table e of an atom */
+static inline void kspace_eikr_table(kspace_t *ks, double *e, int i, double *re, double *im) {
+    int *l = &ks->l[3 * i];
+    double *x, *y, *z;
+    double xy_re, xy_im;
+
+    x = &e[2 * l[0]];
+    y = &e[2 * (ks->kmax + 1 + ks->kmax + l[1])];
+    z = &e[2 * (ks->kmax + 1 + 2 * ks->kmax + 1 + ks->kmax + l[2])];
+
+    xy_re = x[0] * y[0] - x[1] * y[1];
+    xy_im = x[0] * y[1] + x[1] * y[0];
+    *re = xy_re * z[0] - xy_im * z[1];
+    *im = xy_re * z[1] + xy_im * z[0];
+}
+
+/* structure factor of the frozen atoms, which only changes with the box */
+static void kspace_frozen(system_t *system) {
+    kspace_t *ks = system->kspace;
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+    int i;
+    double re, im, *e;
+
+    free(ks->frozen_re);
+    free(ks->frozen_im);
+    ks->frozen_re = calloc(ks->nk, sizeof(double));
+    memnullcheck(ks->frozen_re, ks->nk * sizeof(double), __LINE__ - 1, __FILE__);
+    ks->frozen_im = calloc(ks->nk, sizeof(double));
+    memnullcheck(ks->frozen_im, ks->nk * sizeof(double), __LINE__ - 1, __FILE__);
+    e = malloc(2 * kspace_width(ks->kmax) * sizeof(double));
+    memnullcheck(e, 2 * kspace_width(ks->kmax) * sizeof(double), __LINE__ - 1, __FILE__);
+
+    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
+            if (!atom_ptr->frozen) continue;
+            if (atom_ptr->charge == 0.0) continue;
+            kspace_tabulate(system, atom_ptr, e);
+            for (i = 0; i < ks->nk; i++) {
+                kspace_eikr_table(ks, e, i, &re, &im);
+                ks->frozen_re[i] += atom_ptr->charge * re;
+                ks->frozen_im[i] += atom_ptr->charge * im;
+            }
+        }
+    }
+
+    free(e);
+}
+
+/* build the half-sphere of k-vectors, in the same order as the nested l[0], l[1], l[2] loops */
+static void kspace_setup(system_t *system) {
+    kspace_t *ks = system->kspace;
+    int p, q, kmax, nk, l[3];
+    double k[3], k_squared;
+
+    kmax = system->ewald_kmax;
+
+    /* count the k-vectors first */
+    for (l[0] = 0, nk = 0; l[0] <= kmax; l[0]++)
+        for (l[1] = (!l[0] ? 0 : -kmax); l[1] <= kmax; l[1]++)
+            for (l[2] = ((!l[0] && !l[1]) ? 1 : -kmax); l[2] <= kmax; l[2]++)
+                if (iidotprod(l, l) <= kmax * kmax) nk++;
+
+    free(ks->l);
+    free(ks->k);
+    free(ks->weight);
+    free(ks->polar_weight);
+    ks->l = malloc(3 * nk * sizeof(int));
+    memnullcheck(ks->l, 3 * nk * sizeof(int), __LINE__ - 1, __FILE__);
+    ks->k = malloc(3 * nk * sizeof(double));
+    memnullcheck(ks->k, 3 * nk * sizeof(double), __LINE__ - 1, __FILE__);
+    ks->weight = malloc(nk * sizeof(double));
+    memnullcheck(ks->weight, nk * sizeof(double), __LINE__ - 1, __FILE__);
+    ks->polar_weight = malloc(nk * sizeof(double));
+    memnullcheck(ks->polar_weight, nk * sizeof(double), __LINE__ - 1, __FILE__);
+
+    for (l[0] = 0, nk = 0; l[0] <= kmax; l[0]++) {
+        for (l[1] = (!l[0] ? 0 : -kmax); l[1] <= kmax; l[1]++) {
+            for (l[2] = ((!l[0] && !l[1]) ? 1 : -kmax); l[2] <= kmax; l[2]++) {
+                if (iidotprod(l, l) > kmax * kmax) continue;
+
+                for (p = 0; p < 3; p++) {
+                    for (q = 0, k[p] = 0; q < 3; q++)
+                        k[p] += 2.0 * M_PI * system->pbc->reciprocal_basis[p][q] * l[q];
+                    ks->k[3 * nk + p] = k[p];
+                    ks->l[3 * nk + p] = l[p];
+                }
+                k_squared = dddotprod(k, k);
+                ks->weight[nk] = exp(-k_squared / (4.0 * system->ewald_alpha * system->ewald_alpha)) / k_squared;
+                ks->polar_weight[nk] = exp(-k_squared / (4.0 * system->polar_ewald_alpha * system->polar_ewald_alpha)) / k_squared;
+                nk++;
+            }
+        }
+    }
+
+    ks->nk = nk;
+    ks->kmax = kmax;
+    ks->alpha = system->ewald_alpha;
+    ks->polar_alpha = system->polar_ewald_alpha;
+    memcpy(ks->basis, system->pbc->basis, 9 * sizeof(double));
+    ks->version++;
+
+    if (system->ewald_framework) kspace_frozen(system);
+}
+
+/* make sure the k-vectors belong to the current box */
+void kspace_update(system_t *system) {
+    if (!system->kspace) {
+        system->kspace = calloc(1, sizeof(kspace_t));
+        memnullcheck(system->kspace, sizeof(kspace_t), __LINE__ - 1, __FILE__);
+        kspace_setup(system);
+    } else if (kspace_stale(system))
+        kspace_setup(system);
+}
+
+/* tabulate exp(i l 2pi s_q) for the atoms in the list - all of them, or only the mobile charged ones */
+void kspace_atoms(system_t *system, int charged_only) {
+    kspace_t *ks;
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+    int n, width;
+
+    kspace_update(system);
+    ks = system->kspace;
+    width = kspace_width(ks->kmax);
+
+    for (molecule_ptr = system->molecules, n = 0; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            if (!charged_only || !(atom_ptr->frozen || (atom_ptr->charge == 0.0))) n++;
+
+    if ((n > ks->max_natoms) || (width != ks->width)) {
+        free(ks->atoms);
+        free(ks->eikr);
+        ks->max_natoms = n;
+        ks->atoms = malloc(n * sizeof(atom_t *));
+        memnullcheck(ks->atoms, n * sizeof(atom_t *), __LINE__ - 1, __FILE__);
+        ks->eikr = malloc(2 * n * width * sizeof(double));
+        memnullcheck(ks->eikr, 2 * n * width * sizeof(double), __LINE__ - 1, __FILE__);
+    }
+    ks->width = width;
+
+    for (molecule_ptr = system->molecules, n = 0; molecule_ptr; molecule_ptr = molecule_ptr->next) {
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
+            if (charged_only && (atom_ptr->frozen || (atom_ptr->charge == 0.0))) continue;
+            ks->atoms[n] = atom_ptr;
+            kspace_tabulate(system, atom_ptr, &ks->eikr[2 * n * width]);
+            n++;
+        }
+    }
+    ks->natoms = n;
+}
+
+/* sign * the mobile charged atoms of molecule_ptr, into the tables of the moved atoms */
+static void kspace_molecule(system_t *system, molecule_t *molecule_ptr, double sign) {
+    kspace_t *ks = system->kspace;
+    atom_t *atom_ptr;
+
+    for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
+        if (atom_ptr->frozen || (atom_ptr->charge == 0.0)) continue;
+        ks->moved_q[ks->nmoved] = sign * atom_ptr->charge;
+        kspace_tabulate(system, atom_ptr, &ks->moved_eikr[2 * ks->nmoved * ks->moved_width]);
+        ks->nmoved++;
+    }
+}
+
+/* tabulate the atoms a move added and those it removed (either may be NULL), for kspace_moved_charges() */
+void kspace_molecules(system_t *system, molecule_t *added, molecule_t *removed) {
+    kspace_t *ks;
+    atom_t *atom_ptr;
+    int n = 0, width;
+
+    kspace_update(system);
+    ks = system->kspace;
+    width = kspace_width(ks->kmax);
+
+    if (added)
+        for (atom_ptr = added->atoms; atom_ptr; atom_ptr = atom_ptr->next) n++;
+    if (removed)
+        for (atom_ptr = removed->atoms; atom_ptr; atom_ptr = atom_ptr->next) n++;
+
+    if ((n > ks->max_moved) || (width != ks->moved_width)) {
+        free(ks->moved_q);
+        free(ks->moved_eikr);
+        if (n > ks->max_moved) ks->max_moved = (n > 2 * ks->max_moved) ? n : 2 * ks->max_moved;
+        ks->moved_width = width;
+        ks->moved_q = malloc((ks->max_moved + 1) * sizeof(double));
+        memnullcheck(ks->moved_q, (ks->max_moved + 1) * sizeof(double), __LINE__ - 1, __FILE__);
+        ks->moved_eikr = malloc(2 * (ks->max_moved + 1) * width * sizeof(double));
+        memnullcheck(ks->moved_eikr, 2 * (ks->max_moved + 1) * width * sizeof(double), __LINE__ - 1, __FILE__);
+    }
+
+    ks->nmoved = 0;
+    if (added) kspace_molecule(system, added, 1.0);
+    if (removed) kspace_molecule(system, removed, -1.0);
+}
+
+/* exp(ik.r) of the n-th tabulated atom and the i-th k-vector */
+static inline void kspace_eikr(kspace_t *ks, int n, int i, double *re, double *im) {
+    kspace_eikr_table(ks, &ks->eikr[2 * n * ks->width], i, re, im);
+}
+
+/* sum of q_n exp(ik.r_n) over the tabulated atoms, for the i-th k-vector */
+void kspace_charges(kspace_t *ks, int i, double *sum_re, double *sum_im) {
+    int n;
+    double q, re, im, SF_re = 0, SF_im = 0;
+
+    for (n = 0; n < ks->natoms; n++) {
+        q = ks->atoms[n]->charge;
+        kspace_eikr(ks, n, i, &re, &im);
+        SF_re += q * re;
+        SF_im += q * im;
+    }
+
+    *sum_re = SF_re;
+    *sum_im = SF_im;
+}
+
+/* change in the structure factor of the i-th k-vector from the atoms tabulated by kspace_molecules() */
+void kspace_moved_charges(kspace_t *ks, int i, double *sum_re, double *sum_im) {
+    int n;
+    double re, im, SF_re = 0, SF_im = 0;
+
+    for (n = 0; n < ks->nmoved; n++) {
+        kspace_eikr_table(ks, &ks->moved_eikr[2 * n * ks->moved_width], i, &re, &im);
+        SF_re += ks->moved_q[n] * re;
+        SF_im += ks->moved_q[n] * im;
+    }
+
+    *sum_re = SF_re;
+    *sum_im = SF_im;
+}
+
+/* sum of (k.mu_n) exp(ik.r_n) over the tabulated atoms, for the i-th k-vector */
+void kspace_dipoles(kspace_t *ks, int i, double *sum_re, double *sum_im) {
+    int n;
+    double *k = &ks->k[3 * i];
+    double kmu, re, im, P_re = 0, P_im = 0;
+
+    for (n = 0; n < ks->natoms; n++) {
+        kmu = dddotprod(k, ks->atoms[n]->mu);
+        kspace_eikr(ks, n, i, &re, &im);
+        P_re += kmu * re;
+        P_im += kmu * im;
+    }
+
+    *sum_re = P_re;
+    *sum_im = P_im;
+}
+
+/* field[p] += sum_i k_i[p] weight_i (a_i sin(k_i.r_n) + b_i cos(k_i.r_n)) at the n-th tabulated atom */
+void kspace_field(kspace_t *ks, int n, double *weight, double *a, double *b, double *field) {
+    int i;
+    double re, im, term, f[3] = {0, 0, 0};
+
+    for (i = 0; i < ks->nk; i++) {
+        kspace_eikr(ks, n, i, &re, &im);
+        term = weight[i] * (a[i] * im + b[i] * re);
+        f[0] += term * ks->k[3 * i];
+        f[1] += term * ks->k[3 * i + 1];
+        f[2] += term * ks->k[3 * i + 2];
+    }
+
+    field[0] += f[0];
+    field[1] += f[1];
+    field[2] += f[2];
+}
+
+/* weight * |S|^2 of the i-th k-vector for a mobile structure factor S, plus the cross term 2 Re(S F*) */
+/* with the frozen structure factor F if the framework is included - F F* is constant and left out */
+double kspace_energy(kspace_t *ks, int i, double re, double im) {
+    double energy = re * re + im * im;
+
+    if (ks->frozen_re) energy += 2.0 * (re * ks->frozen_re[i] + im * ks->frozen_im[i]);
+
+    return (ks->weight[i] * energy);
+}
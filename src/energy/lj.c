@@ -8,11 +8,11 @@ University of South Florida
 
 #include <mc.h>
 
-double lj_fh_corr(system_t *system, molecule_t *molecule_ptr, pair_t *pair_ptr, int order, double term12, double term6) {
+double lj_fh_corr(system_t *system, molecule_t *molecule_ptr, pair_t *pair_ptr, double rimg, int order, double term12, double term6) {
     double reduced_mass;
     double dE, d2E, d3E, d4E;  //energy derivatives
     double corr;
-    double ir = 1.0 / pair_ptr->rimg;
+    double ir = 1.0 / rimg;
     double ir2 = ir * ir;
     double ir3 = ir2 * ir;
     double ir4 = ir3 * ir;
@@ -33,7 +33,7 @@ double lj_fh_corr(system_t *system, molecule_t *molecule_ptr, pair_t *pair_ptr,
     //2nd order correction
     corr = M2A2 *
            (HBAR2 / (24.0 * KB * system->temperature * reduced_mass)) *
-           (d2E + 2.0 * dE / pair_ptr->rimg);
+           (d2E + 2.0 * dE / rimg);
 
     if (order >= 4) {
         if (system->cdvdw_sig_repulsion) {
@@ -53,7 +53,8 @@ double lj_fh_corr(system_t *system, molecule_t *molecule_ptr, pair_t *pair_ptr,
     return corr;
 }
 
-double lj_lrc_corr(system_t *system, atom_t *atom_ptr, pair_t *pair_ptr, double cutoff) {
+/* lrc is the value stored for this pair, zero if there is none */
+double lj_lrc_corr(system_t *system, atom_t *atom_ptr, pair_t *pair_ptr, double lrc, double cutoff) {
     double sig_cut, sig3, sig_cut3, sig_cut9;
 
     /* include the long-range correction */ /* I'm  not sure that I'm handling spectre pairs correctly */
@@ -62,7 +63,7 @@ double lj_lrc_corr(system_t *system, atom_t *atom_ptr, pair_t *pair_ptr, double
     if ((pair_ptr->epsilon != 0 && pair_ptr->sigma != 0) &&                          //if these are zero, then we won't waste our time
         !(atom_ptr->spectre && pair_ptr->atom->spectre) &&                           //i think we want to disqualify s-s pairs
         !(pair_ptr->frozen) &&                                                       //disqualify frozen pairs
-        ((pair_ptr->lrc == 0.0) || pair_ptr->last_volume != system->pbc->volume)) {  //LRC only changes if the volume change
+        ((lrc == 0.0) || pair_ptr->last_volume != system->pbc->volume)) {            //LRC only changes if the volume change
 
         pair_ptr->last_volume = system->pbc->volume;
 
@@ -79,7 +80,7 @@ double lj_lrc_corr(system_t *system, atom_t *atom_ptr, pair_t *pair_ptr, double
         else  //if polarvdw is off, do the usual thing
             return ((16.0 / 3.0) * M_PI * pair_ptr->epsilon * sig3) * ((1.0 / 3.0) * sig_cut9 - sig_cut3) / system->pbc->volume;
     } else
-        return pair_ptr->lrc;  //use stored value
+        return lrc;  //use stored value
 }
 
 double lj_lrc_self(system_t *system, atom_t *atom_ptr, double cutoff) {
@@ -161,103 +162,125 @@ double rd_crystal_self(system_t *system, atom_t *aptr, double cutoff) {
     return curr_pot;
 }
 
-/* Lennard-Jones repulsion/dispersion */
-double lj(system_t *system) {
-    molecule_t *molecule_ptr;
-    atom_t *atom_ptr;
-    pair_t *pair_ptr;
-    double sigma_over_r, term12, term6, sigma_over_r6, sigma_over_r12, r;  // , sigma6;   (unused variable)
-    double potential, potential_classical, cutoff;
+/* the repulsion/dispersion energy of a single pair at nearest image separation rimg */
+double lj_pair(system_t *system, molecule_t *molecule_ptr, atom_t *atom_ptr, pair_t *pair_ptr, double rimg, double cutoff) {
+    double sigma_over_r, term12, term6, sigma_over_r6, sigma_over_r12, r;
+    double potential_classical;
     int i[3], p, q;
     double a[3];
+    double rd_energy = 0;
+
+    // to include a contribution, we require
+    if ((rimg - SMALL_dR < cutoff) &&                      //inside cutoff?
+        (!pair_ptr->rd_excluded || system->rd_crystal) &&  //either not excluded OR rd_crystal is ON
+        !pair_ptr->frozen) {                               //not frozen
+
+        //loop over unit cells
+        if (system->rd_crystal) {
+            sigma_over_r6 = 0;
+            sigma_over_r12 = 0;
+            for (i[0] = -(system->rd_crystal_order - 1); i[0] <= system->rd_crystal_order - 1; i[0]++)
+                for (i[1] = -(system->rd_crystal_order - 1); i[1] <= system->rd_crystal_order - 1; i[1]++)
+                    for (i[2] = -(system->rd_crystal_order - 1); i[2] <= system->rd_crystal_order - 1; i[2]++) {
+                        if (!i[0] && !i[1] && !i[2] && pair_ptr->rd_excluded) continue;  //no i=j=k=0 for excluded pairs (intra-molecular)
+                        //calculate pair separation (atom with it's image)
+                        for (p = 0; p < 3; p++) {
+                            a[p] = 0;
+                            for (q = 0; q < 3; q++)
+                                a[p] += system->pbc->basis[q][p] * i[q];
+                            a[p] += atom_ptr->pos[p] - pair_ptr->atom->pos[p];
+                        }
+                        r = sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+
+                        if (r > cutoff) continue;
+                        sigma_over_r = fabs(pair_ptr->sigma) / r;
+                        sigma_over_r6 += pow(sigma_over_r, 6);
+                        sigma_over_r12 += pow(sigma_over_r, 12);
+                    }
+        } else {  //otherwise, calculate as normal
+            sigma_over_r = fabs(pair_ptr->sigma) / rimg;
+            sigma_over_r6 = sigma_over_r * sigma_over_r * sigma_over_r;
+            sigma_over_r6 *= sigma_over_r6;
+            sigma_over_r12 = sigma_over_r6 * sigma_over_r6;
+        }
 
-    //set the cutoff
+        /* the LJ potential */
+        if (system->spectre) {
+            term6 = 0;
+            term12 = sigma_over_r12;
+            potential_classical = term12;
+        } else {
+            if (system->polarvdw)
+                term6 = 0;  //vdw calc'd by vdw.c
+            else
+                term6 = sigma_over_r6;
+
+            if (pair_ptr->attractive_only)
+                term12 = 0;
+            else
+                term12 = sigma_over_r12;
+
+            if (system->cdvdw_sig_repulsion)
+                potential_classical = pair_ptr->sigrep * term12;  //C6*sig^6/r^12
+            else
+                potential_classical = 4.0 * pair_ptr->epsilon * (term12 - term6);
+        }
+
+        rd_energy += potential_classical;
+
+        if (system->feynman_hibbs)
+            rd_energy += lj_fh_corr(system, molecule_ptr, pair_ptr, rimg, system->feynman_hibbs_order, term12, term6);
+
+    }  // if qualified contributions
+
+    return rd_energy;
+}
+
+/* the LJ cutoff, extended over the images when rd_crystal is on */
+double lj_cutoff(system_t *system) {
     if (system->rd_crystal)
-        cutoff = 2.0 * system->pbc->cutoff * ((double)system->rd_crystal_order - 0.5);
+        return 2.0 * system->pbc->cutoff * ((double)system->rd_crystal_order - 0.5);
     else
-        cutoff = system->pbc->cutoff;
+        return system->pbc->cutoff;
+}
 
-    potential = 0;
-    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
-        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
-                if (pair_ptr->recalculate_energy) {
-                    pair_ptr->rd_energy = 0;
-
-                    // pair LRC
-                    if (system->rd_lrc) pair_ptr->lrc = lj_lrc_corr(system, atom_ptr, pair_ptr, cutoff);
-
-                    // to include a contribution, we require
-                    if ((pair_ptr->rimg - SMALL_dR < cutoff) &&            //inside cutoff?
-                        (!pair_ptr->rd_excluded || system->rd_crystal) &&  //either not excluded OR rd_crystal is ON
-                        !pair_ptr->frozen) {                               //not frozen
-
-                        //loop over unit cells
-                        if (system->rd_crystal) {
-                            sigma_over_r6 = 0;
-                            sigma_over_r12 = 0;
-                            for (i[0] = -(system->rd_crystal_order - 1); i[0] <= system->rd_crystal_order - 1; i[0]++)
-                                for (i[1] = -(system->rd_crystal_order - 1); i[1] <= system->rd_crystal_order - 1; i[1]++)
-                                    for (i[2] = -(system->rd_crystal_order - 1); i[2] <= system->rd_crystal_order - 1; i[2]++) {
-                                        if (!i[0] && !i[1] && !i[2] && pair_ptr->rd_excluded) continue;  //no i=j=k=0 for excluded pairs (intra-molecular)
-                                        //calculate pair separation (atom with it's image)
-                                        for (p = 0; p < 3; p++) {
-                                            a[p] = 0;
-                                            for (q = 0; q < 3; q++)
-                                                a[p] += system->pbc->basis[q][p] * i[q];
-                                            a[p] += atom_ptr->pos[p] - pair_ptr->atom->pos[p];
-                                        }
-                                        r = sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
-
-                                        if (r > cutoff) continue;
-                                        sigma_over_r = fabs(pair_ptr->sigma) / r;
-                                        sigma_over_r6 += pow(sigma_over_r, 6);
-                                        sigma_over_r12 += pow(sigma_over_r, 12);
-                                    }
-                        } else {  //otherwise, calculate as normal
-                            sigma_over_r = fabs(pair_ptr->sigma) / pair_ptr->rimg;
-                            sigma_over_r6 = sigma_over_r * sigma_over_r * sigma_over_r;
-                            sigma_over_r6 *= sigma_over_r6;
-                            sigma_over_r12 = sigma_over_r6 * sigma_over_r6;
-                        }
+/* the pair terms of atom i, added to potential */
+static void lj_atom(system_t *system, int i, void *arg, double *potential) {
+    molecule_t *molecule_ptr = system->molecule_array[i];
+    atom_t *atom_ptr = system->atom_array[i];
+    int n, k, npairs = PAIR_COUNT(system, atom_ptr);
+    double cutoff = *(double *)arg;
+    double sum = *potential;
 
-                        /* the LJ potential */
-                        if (system->spectre) {
-                            term6 = 0;
-                            term12 = sigma_over_r12;
-                            potential_classical = term12;
-                        } else {
-                            if (system->polarvdw)
-                                term6 = 0;  //vdw calc'd by vdw.c
-                            else
-                                term6 = sigma_over_r6;
-
-                            if (pair_ptr->attractive_only)
-                                term12 = 0;
-                            else
-                                term12 = sigma_over_r12;
-
-                            if (system->cdvdw_sig_repulsion)
-                                potential_classical = pair_ptr->sigrep * term12;  //C6*sig^6/r^12
-                            else
-                                potential_classical = 4.0 * pair_ptr->epsilon * (term12 - term6);
-                        }
+    for (n = 0; n < npairs; n++) {
+        k = PAIR_INDEX(system, atom_ptr, n);
+        if (atom_ptr->pair_recalculate_energy[k]) {
+            // pair LRC, summed by site type when the neighbor list is active
+            if (system->rd_lrc && !system->neighbor_list) atom_ptr->pair_lrc[k] = lj_lrc_corr(system, atom_ptr, &atom_ptr->pairs[k], atom_ptr->pair_lrc[k], cutoff);
 
-                        pair_ptr->rd_energy += potential_classical;
+            atom_ptr->pair_rd_energy[k] = lj_pair(system, molecule_ptr, atom_ptr, &atom_ptr->pairs[k], atom_ptr->pair_rimg[k], cutoff);
 
-                        if (system->feynman_hibbs)
-                            pair_ptr->rd_energy += lj_fh_corr(system, molecule_ptr, pair_ptr, system->feynman_hibbs_order, term12, term6);
+        } /* if recalculate */
 
-                    }  // if qualified contributions
+        /* sum all of the pairwise terms */
+        sum += atom_ptr->pair_rd_energy[k] + atom_ptr->pair_lrc[k];
 
-                } /* if recalculate */
+    } /* pair */
 
-                /* sum all of the pairwise terms */
-                potential += pair_ptr->rd_energy + pair_ptr->lrc;
+    *potential = sum;
+}
 
-            } /* pair */
-        }     /* atom */
-    }         /* molecule */
+/* Lennard-Jones repulsion/dispersion */
+double lj(system_t *system) {
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+    double potential, cutoff;
+
+    //set the cutoff
+    cutoff = lj_cutoff(system);
+
+    /* the pair sum, split over the atoms */
+    potential = thread_sum(system, system->natoms, lj_atom, &cutoff);
 
     /* molecule self-energy for rd_crystal -> energy of molecule interacting with its periodic neighbors */
 
@@ -266,6 +289,9 @@ double lj(system_t *system) {
             for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
                 potential += rd_crystal_self(system, atom_ptr, cutoff);
 
+    /* pair LRC, as counted by the neighbor list */
+    if (system->rd_lrc && system->neighbor_list) potential += system->nlist_lrc;
+
     /* calculate self LRC interaction */
     if (system->rd_lrc)
         for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
@@ -283,13 +309,15 @@ double lj_nopbc(system_t *system) {
     pair_t *pair_ptr;
     double sigma_over_r, term12, term6, sigma_over_r6;
     double potential;
+    int k;
 
     for (molecule_ptr = molecules, potential = 0; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
                 /* make sure we're not excluded or beyond the cutoff */
                 if (!pair_ptr->rd_excluded) {
-                    sigma_over_r = fabs(pair_ptr->sigma) / pair_ptr->r;
+                    sigma_over_r = fabs(pair_ptr->sigma) / atom_ptr->pair_r[k];
                     sigma_over_r6 = sigma_over_r * sigma_over_r * sigma_over_r;
                     sigma_over_r6 *= sigma_over_r6;
 
@@ -321,6 +349,7 @@ void test_lj(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
     pair_t *pair_ptr;
+    int k;
     char poo[MAXLINE];
     sprintf(poo,
             "%d.lj", system->step);
@@ -329,9 +358,11 @@ void test_lj(system_t *system) {
 
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next)
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
                 fprintf(fp,
-                        "DEBUG_LJ: m_id %d %d a_id %d %d rimg %.3lf\n", molecule_ptr->id, pair_ptr->molecule->id, atom_ptr->id, pair_ptr->atom->id, pair_ptr->rimg);
+                        "DEBUG_LJ: m_id %d %d a_id %d %d rimg %.3lf\n", molecule_ptr->id, pair_ptr->molecule->id, atom_ptr->id, pair_ptr->atom->id, atom_ptr->pair_rimg[k]);
+            }
 
     fclose(fp);
 
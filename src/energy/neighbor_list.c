@@ -0,0 +1,268 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* verlet neighbor list - each atom keeps a sub-list of its pairs that */
+/* lie within cutoff + skin, as the ordered pair indices atom_ptr->neighbors */
+/* the list stays valid until some atom has moved more than skin/2 */
+
+/* check whether the current neighbor list can still be used */
+int neighbor_list_expired(system_t *system) {
+    int i, p;
+    double d, dr2, half_skin2;
+    atom_t *atom_ptr;
+
+    /* pair identity is positional, so any change in N invalidates the list */
+    if (system->nlist_natoms != system->natoms) return 1;
+    if (system->nlist_volume != system->pbc->volume) return 1;
+
+    half_skin2 = 0.25 * system->neighbor_skin * system->neighbor_skin;
+    for (i = 0; i < system->natoms; i++) {
+        atom_ptr = system->atom_array[i];
+
+        /* atoms that were created (or restored) since the last build */
+        if (atom_ptr->nlist_id != system->nlist_id) return 1;
+
+        for (p = 0, dr2 = 0; p < 3; p++) {
+            d = atom_ptr->pos[p] - atom_ptr->nlist_pos[p];
+            dr2 += d * d;
+        }
+        if (dr2 > half_skin2) return 1;
+    }
+
+    return 0;
+}
+
+/* the LJ long-range correction of every non-frozen pair, independent of separation */
+/* sites are counted by type, so this costs O(N * ntypes) rather than a walk over all pairs */
+static double neighbor_list_lrc(system_t *system) {
+    int i, a, b, ntypes;
+    int *counts;
+    atom_t **types, *atom_ptr;
+    molecule_t **molecules;
+    pair_t pair;
+    double npairs, lrc;
+
+    types = calloc(system->natoms, sizeof(atom_t *));
+    memnullcheck(types, system->natoms * sizeof(atom_t *), __LINE__ - 1, __FILE__);
+    molecules = calloc(system->natoms, sizeof(molecule_t *));
+    memnullcheck(molecules, system->natoms * sizeof(molecule_t *), __LINE__ - 1, __FILE__);
+    counts = calloc(system->natoms, sizeof(int));
+    memnullcheck(counts, system->natoms * sizeof(int), __LINE__ - 1, __FILE__);
+
+    /* group the sites by every parameter that enters the mixing rules */
+    for (i = 0, ntypes = 0; i < system->natoms; i++) {
+        atom_ptr = system->atom_array[i];
+        for (a = 0; a < ntypes; a++)
+            if ((types[a]->epsilon == atom_ptr->epsilon) && (types[a]->sigma == atom_ptr->sigma) &&
+                (types[a]->frozen == atom_ptr->frozen) && (types[a]->omega == atom_ptr->omega) &&
+                (types[a]->polarizability == atom_ptr->polarizability) && (types[a]->c6 == atom_ptr->c6) &&
+                (types[a]->c8 == atom_ptr->c8) && (types[a]->c10 == atom_ptr->c10))
+                break;
+        if (a == ntypes) {
+            types[a] = atom_ptr;
+            molecules[a] = system->molecule_array[i];
+            ntypes++;
+        }
+        counts[a]++;
+    }
+
+    lrc = 0;
+    for (a = 0; a < ntypes; a++) {
+        for (b = a; b < ntypes; b++) {
+            if (a == b)
+                npairs = 0.5 * (double)counts[a] * (double)(counts[a] - 1);
+            else
+                npairs = (double)counts[a] * (double)counts[b];
+            if (npairs == 0) continue;
+
+            memset(&pair, 0, sizeof(pair_t));
+            pair.atom = types[b];
+            pair.molecule = molecules[b];
+            pair_exclusions(system, molecules[a], molecules[b], types[a], types[b], &pair);
+            lrc += npairs * lj_lrc_corr(system, types[a], &pair, 0, system->pbc->cutoff);
+        }
+    }
+
+    free(types);
+    free(molecules);
+    free(counts);
+
+    return lrc;
+}
+
+static int compare_int(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+/* rebuild the neighbor list, binning the atoms into cells at least rlist wide */
+void build_neighbor_list(system_t *system) {
+    int i, j, k, n, p, q, c, cell, ncells, ncandidates, use_cells;
+    int ncell[3], cx[3], off[3];
+    int *head_all, *head_mobile, *next_all, *next_mobile, *atom_cell, *candidates;
+    double s, width, rlist;
+    atom_t **atom_array;
+    molecule_t **molecule_array;
+    pair_t *pair_ptr;
+
+    atom_array = system->atom_array;
+    molecule_array = system->molecule_array;
+    n = system->natoms;
+    rlist = system->pbc->cutoff + system->neighbor_skin + SMALL_dR;
+
+    system->nlist_id++;
+    system->nlist_natoms = n;
+    polar_gs_color_invalidate(system);
+    system->nlist_volume = system->pbc->volume;
+    if (system->rd_lrc) system->nlist_lrc = neighbor_list_lrc(system);
+
+    /* the number of cells that fit between each pair of lattice planes */
+    for (p = 0, use_cells = 1; p < 3; p++) {
+        for (q = 0, width = 0; q < 3; q++)
+            width += system->pbc->reciprocal_basis[q][p] * system->pbc->reciprocal_basis[q][p];
+        ncell[p] = (int)floor(1.0 / (sqrt(width) * rlist));
+        /* with fewer than three cells, the 27 neighbors would alias - just check every pair */
+        if (ncell[p] < 3) use_cells = 0;
+    }
+    ncells = use_cells ? ncell[0] * ncell[1] * ncell[2] : 1;
+
+    head_all = malloc(ncells * sizeof(int));
+    memnullcheck(head_all, ncells * sizeof(int), __LINE__ - 1, __FILE__);
+    head_mobile = malloc(ncells * sizeof(int));
+    memnullcheck(head_mobile, ncells * sizeof(int), __LINE__ - 1, __FILE__);
+    next_all = malloc((n + 1) * sizeof(int));
+    memnullcheck(next_all, (n + 1) * sizeof(int), __LINE__ - 1, __FILE__);
+    next_mobile = malloc((n + 1) * sizeof(int));
+    memnullcheck(next_mobile, (n + 1) * sizeof(int), __LINE__ - 1, __FILE__);
+    atom_cell = malloc((3 * n + 1) * sizeof(int));
+    memnullcheck(atom_cell, (3 * n + 1) * sizeof(int), __LINE__ - 1, __FILE__);
+    candidates = malloc((2 * n + 1) * sizeof(int));
+    memnullcheck(candidates, (2 * n + 1) * sizeof(int), __LINE__ - 1, __FILE__);
+
+    /* bin the atoms by their fractional coordinates, keeping the mobile atoms in their own chains */
+    if (use_cells) {
+        for (c = 0; c < ncells; c++)
+            head_all[c] = head_mobile[c] = -1;
+        for (i = n - 1; i >= 0; i--) {
+            for (p = 0; p < 3; p++) {
+                for (q = 0, s = 0; q < 3; q++)
+                    s += system->pbc->reciprocal_basis[q][p] * atom_array[i]->pos[q];
+                s -= floor(s);
+                cx[p] = (int)(s * ncell[p]);
+                if (cx[p] >= ncell[p]) cx[p] = ncell[p] - 1;
+                atom_cell[3 * i + p] = cx[p];
+            }
+            cell = (cx[0] * ncell[1] + cx[1]) * ncell[2] + cx[2];
+            next_all[i] = head_all[cell];
+            head_all[cell] = i;
+            if (!atom_array[i]->frozen) {
+                next_mobile[i] = head_mobile[cell];
+                head_mobile[cell] = i;
+            }
+        }
+    }
+
+    for (i = 0; i < n; i++) {
+        atom_array[i]->nneighbors = 0;
+        atom_array[i]->nlist_id = system->nlist_id;
+        memcpy(atom_array[i]->nlist_pos, atom_array[i]->pos, 3 * sizeof(double));
+
+        /* gather the candidate partners j > i */
+        ncandidates = 0;
+        if (use_cells) {
+            for (off[0] = -1; off[0] <= 1; off[0]++)
+                for (off[1] = -1; off[1] <= 1; off[1]++)
+                    for (off[2] = -1; off[2] <= 1; off[2]++) {
+                        for (p = 0; p < 3; p++)
+                            cx[p] = (atom_cell[3 * i + p] + off[p] + ncell[p]) % ncell[p];
+                        cell = (cx[0] * ncell[1] + cx[1]) * ncell[2] + cx[2];
+                        /* frozen-frozen pairs never contribute */
+                        if (atom_array[i]->frozen) {
+                            for (j = head_mobile[cell]; j >= 0; j = next_mobile[j])
+                                if (j > i) candidates[ncandidates++] = j;
+                        } else {
+                            for (j = head_all[cell]; j >= 0; j = next_all[j])
+                                if (j > i) candidates[ncandidates++] = j;
+                        }
+                    }
+
+            /* intra-molecular pairs are always kept for the self-interaction terms */
+            for (j = i + 1; (j < n) && (molecule_array[j] == molecule_array[i]); j++)
+                candidates[ncandidates++] = j;
+
+            /* keep the list in pair order, so that the kernels walk the pair arrays forwards */
+            qsort(candidates, ncandidates, sizeof(int), compare_int);
+            for (k = 1, q = (ncandidates > 0); k < ncandidates; k++)
+                if (candidates[k] != candidates[q - 1]) candidates[q++] = candidates[k];
+            ncandidates = q;
+        } else {
+            for (j = i + 1; j < n; j++)
+                if (!(atom_array[i]->frozen && atom_array[j]->frozen)) candidates[ncandidates++] = j;
+        }
+
+        for (c = 0; c < ncandidates; c++) {
+            j = candidates[c];
+            k = j - i - 1;
+            pair_ptr = &atom_array[i]->pairs[k];
+            pair_ptr->atom = atom_array[j];
+            pair_ptr->molecule = molecule_array[j];
+            pair_ptr->atom_index = j;
+
+            pair_exclusions(system, molecule_array[i], molecule_array[j], atom_array[i], atom_array[j], pair_ptr);
+            if (pair_ptr->frozen) continue;
+
+            /* cached energies went stale while the pair was off the list, force a recalc */
+            if (pair_ptr->nlist_id != system->nlist_id - 1) pair_ptr->d_prev[0] = NAN;
+
+            minimum_image(system, atom_array[i], atom_array[j], k);
+
+            if ((molecule_array[i] == molecule_array[j]) || (atom_array[i]->pair_rimg[k] < rlist)) {
+                pair_ptr->nlist_id = system->nlist_id;
+                atom_array[i]->neighbors[atom_array[i]->nneighbors++] = k;
+            }
+        } /* for c */
+    }     /* for i */
+
+    free(head_all);
+    free(head_mobile);
+    free(next_all);
+    free(next_mobile);
+    free(atom_cell);
+    free(candidates);
+}
+
+/* update the pairs on the neighbor list of atom i */
+static void neighbor_list_atom(system_t *system, int i, void *arg, double *unused) {
+    atom_t **atom_array = system->atom_array;
+    molecule_t **molecule_array = system->molecule_array;
+    pair_t *pair_ptr;
+    int n, k;
+
+    for (n = 0; n < atom_array[i]->nneighbors; n++) {
+        k = atom_array[i]->neighbors[n];
+        pair_ptr = &atom_array[i]->pairs[k];
+
+        /* set the link */
+        pair_ptr->atom = atom_array[pair_ptr->atom_index];
+        pair_ptr->molecule = molecule_array[pair_ptr->atom_index];
+
+        pair_exclusions(system, molecule_array[i], pair_ptr->molecule, atom_array[i], pair_ptr->atom, pair_ptr);
+        minimum_image(system, atom_array[i], pair_ptr->atom, k);
+    }
+}
+
+/* update the pairs on the neighbor list, rebuilding it first if necessary */
+void neighbor_list_pairs(system_t *system) {
+    if (neighbor_list_expired(system)) {
+        build_neighbor_list(system);
+        return;
+    }
+
+    thread_sum(system, system->natoms, neighbor_list_atom, NULL);
+}
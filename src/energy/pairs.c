@@ -12,20 +12,24 @@ University of South Florida
 void rebuild_arrays(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
-    int n = system->natoms;
-
-    free(system->atom_array);
-    free(system->molecule_array);
-
-    //allocate the arrays
-    system->molecule_array = malloc(n * sizeof(molecule_t *));
-    memnullcheck(system->molecule_array, n * sizeof(molecule_t *), __LINE__ - 1, __FILE__);
-    system->atom_array = malloc(n * sizeof(atom_t *));
-    memnullcheck(system->atom_array, n * sizeof(atom_t *), __LINE__ - 1, __FILE__);
+    int n = countNatoms(system);
+
+    //grow the arrays, they are kept between calls
+    if (n > system->max_natoms) {
+        free(system->atom_array);
+        free(system->molecule_array);
+        system->max_natoms = (n > 2 * system->max_natoms) ? n : 2 * system->max_natoms;
+
+        system->molecule_array = malloc(system->max_natoms * sizeof(molecule_t *));
+        memnullcheck(system->molecule_array, system->max_natoms * sizeof(molecule_t *), __LINE__ - 1, __FILE__);
+        system->atom_array = malloc(system->max_natoms * sizeof(atom_t *));
+        memnullcheck(system->atom_array, system->max_natoms * sizeof(atom_t *), __LINE__ - 1, __FILE__);
+    }
 
     n = 0;
     //build the arrays
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
+        molecule_ptr->atom_index = n;
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
             system->molecule_array[n] = molecule_ptr;
             system->atom_array[n] = atom_ptr;
@@ -33,10 +37,37 @@ void rebuild_arrays(system_t *system) {
         }
     }
     system->natoms = n;
+    system->arrays_dirty = 0;
+    polar_gs_color_invalidate(system);
 
     return;
 }
 
+/* old was swapped for its copy new (e.g. a rejected displacement), point the slots of old at new */
+void update_molecule_arrays(system_t *system, molecule_t *old, molecule_t *molecule_ptr) {
+    atom_t *atom_ptr;
+    int n;
+
+    if (!system->track_dirty || system->arrays_dirty) return;
+
+    /* old was in the list when the arrays were last built, the copy may be older than that */
+    molecule_ptr->atom_index = old->atom_index;
+    for (atom_ptr = molecule_ptr->atoms, n = molecule_ptr->atom_index; atom_ptr; atom_ptr = atom_ptr->next, n++) {
+        system->molecule_array[n] = molecule_ptr;
+        system->atom_array[n] = atom_ptr;
+    }
+}
+
+/* from now on the mc moves flag what they alter, so the bookkeeping in pairs() can skip the rest */
+void start_dirty_tracking(system_t *system) {
+    molecule_t *molecule_ptr;
+
+    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        molecule_ptr->dirty = 1;
+    system->arrays_dirty = 1;
+    system->track_dirty = 1;
+}
+
 /* flag all pairs to have their energy calculated */
 /* needs to be called at simulation start, or can */
 /* be called to periodically keep the total energy */
@@ -44,12 +75,12 @@ void rebuild_arrays(system_t *system) {
 void flag_all_pairs(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
-    pair_t *pair_ptr;
+    int k;
 
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next)
-                pair_ptr->recalculate_energy = 1;
+            for (k = 0; k < atom_ptr->npairs; k++)
+                atom_ptr->pair_recalculate_energy[k] = 1;
 }
 
 /* set the exclusions and LJ mixing for relevant pairs */
@@ -79,6 +110,8 @@ void pair_exclusions(system_t *system, molecule_t *molecule_i, molecule_t *molec
 
     /* get the frozen interactions */
     pair_ptr->frozen = atom_i->frozen && atom_j->frozen;
+    /* with the framework grid, the frozen atoms' interactions are tabulated instead */
+    if (system->framework_grid && (atom_i->frozen || atom_j->frozen)) pair_ptr->frozen = 1;
 
     /* get the mixed LJ parameters */
     if (!system->sg) {
@@ -189,76 +222,182 @@ void pair_exclusions(system_t *system, molecule_t *molecule_i, molecule_t *molec
     }
 }
 
-/* perform the modulo minimum image for displacements */
-void minimum_image(system_t *system, atom_t *atom_i, atom_t *atom_j, pair_t *pair_ptr) {
+/* separation r, minimum image separation rimg and nearest image displacement dimg of atom_i from atom_j */
+void minimum_image_separation(system_t *system, atom_t *atom_i, atom_t *atom_j, double *r, double *rimg, double *dimg) {
     int p, q;
     double img[3];
-    double d[3], r, r2;
+    double d[3], r2;
     double di[3], ri, ri2;
-    // double rnd;  (unused variable)
 
-    /* get the real displacement */
-    pair_ptr->recalculate_energy = 0; /* reset the recalculate flag */
-    for (p = 0; p < 3; p++) {
+    for (p = 0; p < 3; p++)
         d[p] = atom_i->pos[p] - atom_j->pos[p];
 
-        /* this pair changed and so it will have it's energy recalculated */
-        if (d[p] != pair_ptr->d_prev[p]) {
-            pair_ptr->recalculate_energy = 1;
-            pair_ptr->d_prev[p] = d[p]; /* reset */
+    if (system->pbc->orthorhombic) {
+        /* the lattice vectors lie along the axes, so each component wraps on its own */
+        for (p = 0; p < 3; p++)
+            di[p] = d[p] - system->pbc->basis[p][p] * rint(system->pbc->reciprocal_basis[p][p] * d[p]);
+    } else {
+        for (p = 0; p < 3; p++) {
+            for (q = 0, img[p] = 0; q < 3; q++) {
+                img[p] += system->pbc->reciprocal_basis[q][p] * d[q];
+            }
+            img[p] = rint(img[p]);
         }
-    }
 
-    //relative position didn't change. nothing to do here.
-    if (pair_ptr->recalculate_energy == 0) return;
+        /* matrix multiply to project back into our basis */
+        for (p = 0; p < 3; p++)
+            for (q = 0, di[p] = 0; q < 3; q++)
+                di[p] += system->pbc->basis[q][p] * img[q];
 
-    for (p = 0; p < 3; p++) {
-        for (q = 0, img[p] = 0; q < 3; q++) {
-            img[p] += system->pbc->reciprocal_basis[q][p] * d[q];
-        }
-        img[p] = rint(img[p]);
+        /* now correct the displacement */
+        for (p = 0; p < 3; p++)
+            di[p] = d[p] - di[p];
     }
 
-    /* matrix multiply to project back into our basis */
-    for (p = 0; p < 3; p++)
-        for (q = 0, di[p] = 0; q < 3; q++)
-            di[p] += system->pbc->basis[q][p] * img[q];
-
-    /* now correct the displacement */
-    for (p = 0; p < 3; p++)
-        di[p] = d[p] - di[p];
-
     /* pythagorean terms */
     for (p = 0, r2 = 0, ri2 = 0; p < 3; p++) {
         r2 += d[p] * d[p];
         ri2 += di[p] * di[p];
     }
-    r = sqrt(r2);
+    *r = sqrt(r2);
     ri = sqrt(ri2);
 
-    /* store the results for this pair */
-    pair_ptr->r = r;
-
     if (isnan(ri) != 0) {
-        pair_ptr->rimg = r;
+        *rimg = *r;
         for (p = 0; p < 3; p++)
-            pair_ptr->dimg[p] = d[p];
+            dimg[p] = d[p];
     } else {
-        pair_ptr->rimg = ri;
+        *rimg = ri;
         for (p = 0; p < 3; p++)
-            pair_ptr->dimg[p] = di[p];
+            dimg[p] = di[p];
     }
+}
 
-    return;
+/* perform the modulo minimum image for displacements, for the k-th pair of atom_i (whose partner is atom_j) */
+void minimum_image(system_t *system, atom_t *atom_i, atom_t *atom_j, int k) {
+    int p;
+    double d;
+    pair_t *pair_ptr = &atom_i->pairs[k];
+
+    /* get the real displacement */
+    atom_i->pair_recalculate_energy[k] = 0; /* reset the recalculate flag */
+    for (p = 0; p < 3; p++) {
+        d = atom_i->pos[p] - atom_j->pos[p];
+
+        /* this pair changed and so it will have it's energy recalculated */
+        if (d != pair_ptr->d_prev[p]) {
+            atom_i->pair_recalculate_energy[k] = 1;
+            pair_ptr->d_prev[p] = d; /* reset */
+        }
+    }
+
+    //relative position didn't change. nothing to do here.
+    if (atom_i->pair_recalculate_energy[k] == 0) return;
+
+    /* store the results for this pair */
+    minimum_image_separation(system, atom_i, atom_j, &atom_i->pair_r[k], &atom_i->pair_rimg[k], &atom_i->pair_dimg[3 * k]);
+}
+
+/* minimum image displacements (dx, dy, dz) and distances from pos to n partners at (x, y, z) */
+/* the partners are laid out as flat arrays, and the outputs don't alias them, so that the loops below vectorize */
+void minimum_image_batch(pbc_t *pbc, double *pos, int n, double *x, double *y, double *z, double *restrict dx, double *restrict dy, double *restrict dz, double *restrict rimg) {
+    int j;
+    double px = pos[0], py = pos[1], pz = pos[2];
+    double ax, ay, az, ix, iy, iz;
+    double b00, b01, b02, b10, b11, b12, b20, b21, b22;
+    double r00, r01, r02, r10, r11, r12, r20, r21, r22;
+
+    if (pbc->orthorhombic) {
+        b00 = pbc->basis[0][0];
+        b11 = pbc->basis[1][1];
+        b22 = pbc->basis[2][2];
+        r00 = pbc->reciprocal_basis[0][0];
+        r11 = pbc->reciprocal_basis[1][1];
+        r22 = pbc->reciprocal_basis[2][2];
+
+        for (j = 0; j < n; j++) {
+            ax = px - x[j];
+            ay = py - y[j];
+            az = pz - z[j];
+            ax -= b00 * rint(r00 * ax);
+            ay -= b11 * rint(r11 * ay);
+            az -= b22 * rint(r22 * az);
+            dx[j] = ax;
+            dy[j] = ay;
+            dz[j] = az;
+            rimg[j] = sqrt(ax * ax + ay * ay + az * az);
+        }
+    } else {
+        b00 = pbc->basis[0][0];
+        b01 = pbc->basis[0][1];
+        b02 = pbc->basis[0][2];
+        b10 = pbc->basis[1][0];
+        b11 = pbc->basis[1][1];
+        b12 = pbc->basis[1][2];
+        b20 = pbc->basis[2][0];
+        b21 = pbc->basis[2][1];
+        b22 = pbc->basis[2][2];
+        r00 = pbc->reciprocal_basis[0][0];
+        r01 = pbc->reciprocal_basis[0][1];
+        r02 = pbc->reciprocal_basis[0][2];
+        r10 = pbc->reciprocal_basis[1][0];
+        r11 = pbc->reciprocal_basis[1][1];
+        r12 = pbc->reciprocal_basis[1][2];
+        r20 = pbc->reciprocal_basis[2][0];
+        r21 = pbc->reciprocal_basis[2][1];
+        r22 = pbc->reciprocal_basis[2][2];
+
+        /* same arithmetic as minimum_image() */
+        for (j = 0; j < n; j++) {
+            ax = px - x[j];
+            ay = py - y[j];
+            az = pz - z[j];
+            ix = rint(r00 * ax + r10 * ay + r20 * az);
+            iy = rint(r01 * ax + r11 * ay + r21 * az);
+            iz = rint(r02 * ax + r12 * ay + r22 * az);
+            ax -= b00 * ix + b10 * iy + b20 * iz;
+            ay -= b01 * ix + b11 * iy + b21 * iz;
+            az -= b02 * ix + b12 * iy + b22 * iz;
+            dx[j] = ax;
+            dy[j] = ay;
+            dz[j] = az;
+            rimg[j] = sqrt(ax * ax + ay * ay + az * az);
+        }
+    }
+}
+
+/* set up the pairs of atom i with every atom j > i */
+static void pairs_atom(system_t *system, int i, void *arg, double *unused) {
+    molecule_t **molecule_array = system->molecule_array;
+    atom_t **atom_array = system->atom_array;
+    pair_t *pair_ptr;
+    int j, k, n = system->natoms;
+
+    for (j = (i + 1), k = 0; j < n; j++, k++) {
+        pair_ptr = &atom_array[i]->pairs[k];
+
+        /* set the link */
+        pair_ptr->atom = atom_array[j];
+        pair_ptr->molecule = molecule_array[j];
+
+        //this is dangerous and has already been responsible for numerous bugs, most recently
+        //in UVT runs. after and insert/remove move there is no guarantee that pair_ptr->rd_excluded is properly set
+        //if ( !pair_ptr->frozen && !(pair_ptr->rd_excluded && pair_ptr->es_excluded) )
+        pair_exclusions(system, molecule_array[i], molecule_array[j], atom_array[i], atom_array[j], pair_ptr);
+
+        /* recalc min image */
+        if (!pair_ptr->frozen || system->polarization)  //need induced-induced interaction for frozen atoms
+            minimum_image(system, atom_array[i], atom_array[j], k);
+
+    } /* for j */
 }
 
 /* update everything necessary to describe the complete pairwise system */
 void pairs(system_t *system) {
-    int i, j, n;
-    // molecule_t *molecule_ptr;     (unused variable)
+    int i, k, n;
+    molecule_t *molecule_ptr;
     // atom_t *atom_ptr;    (unused variable)
     pair_t *pair_ptr;
-    molecule_t **molecule_array;
     atom_t **atom_array;
     /* needed for GS ranking metric */
     // int p;   (unused variable)
@@ -266,35 +405,25 @@ void pairs(system_t *system) {
     double rmin;
 
     // get array of atom ptrs
-    rebuild_arrays(system);
+    if (!system->track_dirty || system->arrays_dirty) rebuild_arrays(system);
     atom_array = system->atom_array;
-    molecule_array = system->molecule_array;
     n = system->natoms;
 
-    /* loop over all atoms and pair */
-    for (i = 0; i < (n - 1); i++) {
-        for (j = (i + 1), pair_ptr = atom_array[i]->pairs; j < n; j++, pair_ptr = pair_ptr->next) {
-            /* set the link */
-            pair_ptr->atom = atom_array[j];
-            pair_ptr->molecule = molecule_array[j];
-
-            //this is dangerous and has already been responsible for numerous bugs, most recently
-            //in UVT runs. after and insert/remove move there is no guarantee that pair_ptr->rd_excluded is properly set
-            //if ( !pair_ptr->frozen && !(pair_ptr->rd_excluded && pair_ptr->es_excluded) )
-            pair_exclusions(system, molecule_array[i], molecule_array[j], atom_array[i], atom_array[j], pair_ptr);
-
-            /* recalc min image */
-            if (!pair_ptr->frozen || system->polarization)  //need induced-induced interaction for frozen atoms
-                minimum_image(system, atom_array[i], atom_array[j], pair_ptr);
-
-        } /* for j */
-    }     /* for i */
-
-    /* update the com of each molecule */
-    update_com(system->molecules);
+    if (system->neighbor_list) {
+        /* only walk the pairs near each atom */
+        neighbor_list_pairs(system);
+    } else {
+        /* loop over all atoms and pair */
+        thread_sum(system, n - 1, pairs_atom, NULL);
+    }
 
-    /* store wrapped coords */
-    wrapall(system->molecules, system->pbc);
+    /* update the com and the wrapped coords of each molecule that moved */
+    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
+        if (system->track_dirty && !molecule_ptr->dirty) continue;
+        update_molecule_com(molecule_ptr);
+        wrap_molecule(molecule_ptr, system->pbc);
+        molecule_ptr->dirty = 0;
+    }
 
     /* rank metric */
     if (system->polar_iterative && system->polar_gs_ranked) {
@@ -302,9 +431,9 @@ void pairs(system_t *system) {
         rmin = MAXVALUE;
         for (i = 0; i < n; i++) {
             if (atom_array[i]->polarizability == 0.0) continue;
-            for (pair_ptr = atom_array[i]->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
-                if (pair_ptr->atom->polarizability == 0.0) continue;
-                if (pair_ptr->rimg < rmin) rmin = pair_ptr->rimg;
+            for (k = 0; k < atom_array[i]->npairs; k++) {
+                if (atom_array[i]->pairs[k].atom->polarizability == 0.0) continue;
+                if (atom_array[i]->pair_rimg[k] < rmin) rmin = atom_array[i]->pair_rimg[k];
             }
         }
         //calculate rank shits
@@ -312,9 +441,10 @@ void pairs(system_t *system) {
             atom_array[i]->rank_metric = 0;
         for (i = 0; i < n; i++) {
             if (atom_array[i]->polarizability == 0.0) continue;
-            for (pair_ptr = atom_array[i]->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
+            for (k = 0; k < atom_array[i]->npairs; k++) {
+                pair_ptr = &atom_array[i]->pairs[k];
                 if (pair_ptr->atom->polarizability == 0.0) continue;
-                if (pair_ptr->r <= rmin * 1.5) {
+                if (atom_array[i]->pair_r[k] <= rmin * 1.5) {
                     atom_array[i]->rank_metric += 1.0;
                     pair_ptr->atom->rank_metric += 1.0;
                 }
@@ -323,222 +453,186 @@ void pairs(system_t *system) {
     }
 }
 
-/* molecular center of mass */
-void update_com(molecule_t *molecules) {
+/* center of mass of a single molecule */
+void update_molecule_com(molecule_t *molecule_ptr) {
     int i;
-    molecule_t *molecule_ptr;
     atom_t *atom_ptr;
 
-    for (molecule_ptr = molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
-        for (i = 0; i < 3; i++)
-            molecule_ptr->com[i] = 0;
+    for (i = 0; i < 3; i++)
+        molecule_ptr->com[i] = 0;
 
-        if (!(molecule_ptr->spectre || molecule_ptr->target)) {
-            for (atom_ptr = molecule_ptr->atoms, molecule_ptr->mass = 0; atom_ptr; atom_ptr = atom_ptr->next) {
-                molecule_ptr->mass += atom_ptr->mass;
-
-                for (i = 0; i < 3; i++)
-                    molecule_ptr->com[i] += atom_ptr->mass * atom_ptr->pos[i];
-            }
+    if (!(molecule_ptr->spectre || molecule_ptr->target)) {
+        for (atom_ptr = molecule_ptr->atoms, molecule_ptr->mass = 0; atom_ptr; atom_ptr = atom_ptr->next) {
+            molecule_ptr->mass += atom_ptr->mass;
 
             for (i = 0; i < 3; i++)
-                molecule_ptr->com[i] /= molecule_ptr->mass;
+                molecule_ptr->com[i] += atom_ptr->mass * atom_ptr->pos[i];
         }
+
+        for (i = 0; i < 3; i++)
+            molecule_ptr->com[i] /= molecule_ptr->mass;
+    }
+}
+
+/* molecular center of mass */
+void update_com(molecule_t *molecules) {
+    molecule_t *molecule_ptr;
+
+    for (molecule_ptr = molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        update_molecule_com(molecule_ptr);
+}
+
+/* grow one of the arrays kept parallel to the pair block */
+static void *resize_pair_array(void *array, int n, size_t size) {
+    array = realloc(array, n * size);
+    memnullcheck(array, n * size, __LINE__ - 1, __FILE__);
+    return array;
+}
+
+/* release the pair block of an atom along with its parallel arrays */
+static void free_pair_arrays(atom_t *atom_ptr) {
+    free(atom_ptr->pairs);
+    free(atom_ptr->pair_r);
+    free(atom_ptr->pair_rimg);
+    free(atom_ptr->pair_dimg);
+    free(atom_ptr->pair_rd_energy);
+    free(atom_ptr->pair_es_real_energy);
+    free(atom_ptr->pair_es_self_intra_energy);
+    free(atom_ptr->pair_lrc);
+    free(atom_ptr->pair_recalculate_energy);
+    free(atom_ptr->neighbors);
+    atom_ptr->pairs = NULL;
+    atom_ptr->pair_r = atom_ptr->pair_rimg = atom_ptr->pair_dimg = NULL;
+    atom_ptr->pair_rd_energy = atom_ptr->pair_es_real_energy = atom_ptr->pair_es_self_intra_energy = NULL;
+    atom_ptr->pair_lrc = NULL;
+    atom_ptr->pair_recalculate_energy = NULL;
+    atom_ptr->neighbors = NULL;
+    atom_ptr->npairs = atom_ptr->max_pairs = 0;
+    atom_ptr->nneighbors = 0;
+}
+
+/* resize the contiguous pair block of an atom and its parallel arrays, new pairs are zeroed */
+void resize_pairs(atom_t *atom_ptr, int npairs) {
+    int k;
+
+    if (npairs <= 0) {
+        free_pair_arrays(atom_ptr);
+        return;
+    }
+
+    /* grow geometrically so that repeated insertions are amortized */
+    if (npairs > atom_ptr->max_pairs) {
+        k = (npairs > 2 * atom_ptr->max_pairs) ? npairs : 2 * atom_ptr->max_pairs;
+        atom_ptr->pairs = resize_pair_array(atom_ptr->pairs, k, sizeof(pair_t));
+        atom_ptr->pair_r = resize_pair_array(atom_ptr->pair_r, k, sizeof(double));
+        atom_ptr->pair_rimg = resize_pair_array(atom_ptr->pair_rimg, k, sizeof(double));
+        atom_ptr->pair_dimg = resize_pair_array(atom_ptr->pair_dimg, 3 * k, sizeof(double));
+        atom_ptr->pair_rd_energy = resize_pair_array(atom_ptr->pair_rd_energy, k, sizeof(double));
+        atom_ptr->pair_es_real_energy = resize_pair_array(atom_ptr->pair_es_real_energy, k, sizeof(double));
+        atom_ptr->pair_es_self_intra_energy = resize_pair_array(atom_ptr->pair_es_self_intra_energy, k, sizeof(double));
+        atom_ptr->pair_lrc = resize_pair_array(atom_ptr->pair_lrc, k, sizeof(double));
+        atom_ptr->pair_recalculate_energy = resize_pair_array(atom_ptr->pair_recalculate_energy, k, sizeof(int));
+        atom_ptr->neighbors = resize_pair_array(atom_ptr->neighbors, k, sizeof(int));
+        atom_ptr->max_pairs = k;
+    }
+
+    if (npairs > atom_ptr->npairs) {
+        k = npairs - atom_ptr->npairs;
+        memset(&atom_ptr->pairs[atom_ptr->npairs], 0, k * sizeof(pair_t));
+        memset(&atom_ptr->pair_r[atom_ptr->npairs], 0, k * sizeof(double));
+        memset(&atom_ptr->pair_rimg[atom_ptr->npairs], 0, k * sizeof(double));
+        memset(&atom_ptr->pair_dimg[3 * atom_ptr->npairs], 0, 3 * k * sizeof(double));
+        memset(&atom_ptr->pair_rd_energy[atom_ptr->npairs], 0, k * sizeof(double));
+        memset(&atom_ptr->pair_es_real_energy[atom_ptr->npairs], 0, k * sizeof(double));
+        memset(&atom_ptr->pair_es_self_intra_energy[atom_ptr->npairs], 0, k * sizeof(double));
+        memset(&atom_ptr->pair_lrc[atom_ptr->npairs], 0, k * sizeof(double));
+        memset(&atom_ptr->pair_recalculate_energy[atom_ptr->npairs], 0, k * sizeof(int));
     }
+    atom_ptr->npairs = npairs;
+
+    /* the neighbor list is in pair order, so the truncated pairs are at its end */
+    while ((atom_ptr->nneighbors > 0) && (atom_ptr->neighbors[atom_ptr->nneighbors - 1] >= npairs))
+        atom_ptr->nneighbors--;
 }
 
 /* add new pairs for when a new molecule is created */
 void update_pairs_insert(system_t *system) {
-    int i, n;
+    int n;
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
-    pair_t *pair_ptr;
 
     /* count the number of atoms per molecule */
     for (atom_ptr = system->checkpoint->molecule_altered->atoms, n = 0; atom_ptr; atom_ptr = atom_ptr->next, n++)
         ;
 
-    /* add n number of pairs to altered and all molecules ahead of it in the list */
-    for (molecule_ptr = system->molecules; molecule_ptr != system->checkpoint->tail; molecule_ptr = molecule_ptr->next) {
-        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            /* go to the end of the pair list */
-            if (atom_ptr->pairs) {
-                /* go to the end of the pair list */
-                for (pair_ptr = atom_ptr->pairs; pair_ptr->next; pair_ptr = pair_ptr->next)
-                    ;
-
-                /* tag on the extra pairs */
-                for (i = 0; i < n; i++) {
-                    pair_ptr->next = calloc(1, sizeof(pair_t));
-                    memnullcheck(pair_ptr->next, sizeof(pair_t), __LINE__ - 1, __FILE__);
-                    pair_ptr = pair_ptr->next;
-                }
-
-            } else {
-                /* needs a new list */
-                atom_ptr->pairs = calloc(1, sizeof(pair_t));
-                memnullcheck(atom_ptr->pairs, sizeof(pair_t), __LINE__ - 1, __FILE__);
-                pair_ptr = atom_ptr->pairs;
-                for (i = 0; i < (n - 1); i++) {
-                    pair_ptr->next = calloc(1, sizeof(pair_t));
-                    memnullcheck(pair_ptr->next, sizeof(pair_t), __LINE__ - 1, __FILE__);
-                    pair_ptr = pair_ptr->next;
-                }
-            }
-
-        } /* for atom */
-    }     /* for molecule */
+    /* append n pairs to altered and all molecules ahead of it in the list */
+    for (molecule_ptr = system->molecules; molecule_ptr != system->checkpoint->tail; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            resize_pairs(atom_ptr, atom_ptr->npairs + n);
 }
 
 /* remove pairs when a molecule is deleted */
 void update_pairs_remove(system_t *system) {
-    int i, n, m;
+    int n;
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
-    pair_t *pair_ptr, **pair_array;
 
     /* count the number of atoms per molecule */
     for (atom_ptr = system->checkpoint->molecule_backup->atoms, n = 0; atom_ptr; atom_ptr = atom_ptr->next, n++)
         ;
 
-    /* remove n number of pairs for all molecules ahead of the removal point */
-    pair_array = calloc(1, sizeof(pair_t *));
-    memnullcheck(pair_array, sizeof(pair_t *), __LINE__ - 1, __FILE__);
-    for (molecule_ptr = system->molecules; molecule_ptr != system->checkpoint->tail; molecule_ptr = molecule_ptr->next) {
-        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            /* build the pair pointer array */
-            for (pair_ptr = atom_ptr->pairs, m = 0; pair_ptr; pair_ptr = pair_ptr->next, m++) {
-                pair_array = realloc(pair_array, sizeof(pair_t *) * (m + 1));
-                memnullcheck(pair_array, sizeof(pair_t *) * (m + 1), __LINE__ - 1, __FILE__);
-                pair_array[m] = pair_ptr;
-            }
-
-            for (i = (m - n); i < m; i++)
-                free(pair_array[i]);
-
-            /* handle the end of the list */
-            if ((m - n) > 0)
-                pair_array[(m - n - 1)]->next = NULL;
-            else
-                atom_ptr->pairs = NULL;
-        }
-    }
-
-    /* free our temporary array */
-    free(pair_array);
+    /* truncate n pairs for all molecules ahead of the removal point */
+    for (molecule_ptr = system->molecules; molecule_ptr != system->checkpoint->tail; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            resize_pairs(atom_ptr, atom_ptr->npairs - n);
 }
 
 /* if an insert move is rejected, remove the pairs that were previously added */
 void unupdate_pairs_insert(system_t *system) {
-    int i, n, m;
+    int n;
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
-    pair_t *pair_ptr, **pair_array;
 
     /* count the number of atoms per molecule */
     for (atom_ptr = system->checkpoint->molecule_altered->atoms, n = 0; atom_ptr; atom_ptr = atom_ptr->next)
         ++n;
 
-    /* remove n number of pairs for all molecules ahead of the removal point */
-    pair_array = calloc(1, sizeof(pair_t *));
-    memnullcheck(pair_array, sizeof(pair_t *), __LINE__ - 1, __FILE__);
-    for (molecule_ptr = system->molecules; molecule_ptr != system->checkpoint->tail; molecule_ptr = molecule_ptr->next) {
-        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            /* build the pair pointer array */
-            for (pair_ptr = atom_ptr->pairs, m = 0; pair_ptr; pair_ptr = pair_ptr->next, m++) {
-                pair_array = realloc(pair_array, sizeof(pair_t *) * (m + 1));
-                memnullcheck(pair_array, sizeof(pair_t *) * (m + 1), __LINE__ - 1, __FILE__);
-                pair_array[m] = pair_ptr;
-            }
-
-            for (i = (m - n); i < m; i++)
-                free(pair_array[i]);
-
-            /* handle the end of the list */
-            if ((m - n) > 0)
-                pair_array[(m - n - 1)]->next = NULL;
-            else
-                atom_ptr->pairs = NULL;
-        }
-    }
-
-    /* free our temporary array */
-    free(pair_array);
+    /* truncate n pairs for all molecules ahead of the removal point */
+    for (molecule_ptr = system->molecules; molecule_ptr != system->checkpoint->tail; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            resize_pairs(atom_ptr, atom_ptr->npairs - n);
 }
 
 /* if a remove is rejected, then add back the pairs that were previously deleted */
 void unupdate_pairs_remove(system_t *system) {
-    int i, n;
+    int n;
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
-    pair_t *pair_ptr;
 
     /* count the number of atoms per molecule */
     for (atom_ptr = system->checkpoint->molecule_backup->atoms, n = 0; atom_ptr; atom_ptr = atom_ptr->next)
         ++n;
 
-    /* add n number of pairs to altered and all molecules ahead of it in the list */
-    for (molecule_ptr = system->molecules; molecule_ptr != system->checkpoint->molecule_backup; molecule_ptr = molecule_ptr->next) {
-        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            /* go to the end of the pair list */
-            if (atom_ptr->pairs) {
-                /* go to the end of the pair list */
-                for (pair_ptr = atom_ptr->pairs; pair_ptr->next; pair_ptr = pair_ptr->next)
-                    ;
-
-                /* tag on the extra pairs */
-                for (i = 0; i < n; i++) {
-                    pair_ptr->next = calloc(1, sizeof(pair_t));
-                    memnullcheck(pair_ptr->next, sizeof(pair_t), __LINE__ - 1, __FILE__);
-                    pair_ptr = pair_ptr->next;
-                }
-
-            } else {
-                /* needs a new list */
-                atom_ptr->pairs = calloc(1, sizeof(pair_t));
-                memnullcheck(atom_ptr->pairs, sizeof(pair_t), __LINE__ - 1, __FILE__);
-                pair_ptr = atom_ptr->pairs;
-                for (i = 0; i < (n - 1); i++) {
-                    pair_ptr->next = calloc(1, sizeof(pair_t));
-                    memnullcheck(pair_ptr->next, sizeof(pair_t), __LINE__ - 1, __FILE__);
-                    pair_ptr = pair_ptr->next;
-                }
-            }
-
-        } /* for atom */
-    }     /* for molecule */
+    /* append n pairs to all molecules ahead of the backup in the list */
+    for (molecule_ptr = system->molecules; molecule_ptr != system->checkpoint->molecule_backup; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            resize_pairs(atom_ptr, atom_ptr->npairs + n);
 }
 
 /* allocate the pair lists */
 void setup_pairs(system_t *system) {
-    int i, j, n;
-    // molecule_t *molecule_ptr;  (unused variable)
-    atom_t **atom_array;  //, *atom_ptr;   (unused variable)
-    pair_t *pair_ptr, *prev_pair_ptr;
-
-    system->natoms = countNatoms(system);
+    int i, n;
+    atom_t **atom_array;
 
     //build atom and molecule arrays
     rebuild_arrays(system);
     atom_array = system->atom_array;
     n = system->natoms;
 
-    /* setup the pairs, lower triangular */
-    for (i = 0; i < (n - 1); i++) {
-        atom_array[i]->pairs = calloc(1, sizeof(pair_t));
-        memnullcheck(atom_array[i]->pairs, sizeof(pair_t), __LINE__ - 1, __FILE__);
-        pair_ptr = atom_array[i]->pairs;
-        prev_pair_ptr = pair_ptr;
-
-        for (j = (i + 1); j < n; j++) {
-            pair_ptr->next = calloc(1, sizeof(pair_t));
-            memnullcheck(pair_ptr->next, sizeof(pair_t), __LINE__ - 1, __FILE__);
-            prev_pair_ptr = pair_ptr;
-            pair_ptr = pair_ptr->next;
-        }
-
-        prev_pair_ptr->next = NULL;
-        free(pair_ptr);
+    /* setup the pairs, lower triangular, reusing any existing blocks */
+    for (i = 0; i < n; i++) {
+        atom_array[i]->npairs = 0;
+        resize_pairs(atom_array[i], n - i - 1);
     }
 }
 
@@ -547,15 +641,17 @@ void test_pairs(molecule_t *molecules) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
     pair_t *pair_ptr;
+    int k;
 
     for (molecule_ptr = molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
                 if (!(pair_ptr->frozen || pair_ptr->rd_excluded || pair_ptr->es_excluded))
                     printf(
                         "DEBUG_PAIRS: atomid %d charge = %f, epsilon = %f, sigma = %f, r = %f, rimg = %f\n",
                         atom_ptr->id, pair_ptr->atom->charge, pair_ptr->epsilon,
-                        pair_ptr->sigma, pair_ptr->r, pair_ptr->rimg);
+                        pair_ptr->sigma, atom_ptr->pair_r[k], atom_ptr->pair_rimg[k]);
                 fflush(stdout);
             }
         }
@@ -43,6 +43,17 @@ double pbc_volume(pbc_t *pbc) {
     return (volume);
 }
 
+/* are the lattice vectors along the axes? abcbasis leaves round-off in the off-diagonal terms, so allow for that */
+int pbc_orthorhombic(pbc_t *pbc) {
+    int p, q;
+
+    for (p = 0; p < 3; p++)
+        for (q = 0; q < 3; q++)
+            if ((p != q) && (fabs(pbc->basis[p][q]) > PBC_ORTHORHOMBIC_TOLERANCE * fabs(pbc->basis[p][p]))) return 0;
+
+    return 1;
+}
+
 /* get the reciprocal space basis */
 void pbc_reciprocal(pbc_t *pbc) {
     double inverse_volume;
@@ -76,8 +87,14 @@ void pbc(system_t *system) {
     if (system->polar_ewald_alpha_set != 1)
         system->polar_ewald_alpha = 3.5 / system->pbc->cutoff;
 
+    /* the real-space lookup follows alpha and the cutoff */
+    if (system->ewald_lookup) update_ewald_table(system);
+
     /* get the reciprocal space lattice */
     pbc_reciprocal(pbc);
 
+    /* cubic and orthorhombic cells take a cheaper minimum image */
+    pbc->orthorhombic = pbc_orthorhombic(pbc);
+
     return;
 }
@@ -53,12 +53,16 @@ double polar(system_t *system) {
 
     if (system->polar_ewald_full) {
         //do a full-ewald polarization treatment
-        ewald_full(system);
+        num_iterations = ewald_full(system);
+        system->nodestats->polarization_iterations = (double)num_iterations;  //statistics
 
     } else if (system->polar_iterative) {
         //solve the self-consistent problem
         thole_field(system);                       //calc e-field
-        num_iterations = thole_iterative(system);  //calc dipoles
+        if (system->polar_pcg)
+            num_iterations = thole_pcg(system);  //calc dipoles
+        else
+            num_iterations = thole_iterative(system);
 
         system->nodestats->polarization_iterations = (double)num_iterations;  //statistics
         system->observables->dipole_rrms = get_dipole_rrms(system);
@@ -90,9 +94,13 @@ double polar(system_t *system) {
 
     } else {
         //do matrix inversion
-        thole_field(system);            //calc e-field
-        thole_bmatrix(system);          //matrix inversion
-        thole_bmatrix_dipoles(system);  //get dipoles
+        thole_field(system);  //calc e-field
+        if (system->polar_schur)
+            thole_schur_dipoles(system);  //frozen dipoles eliminated
+        else {
+            thole_bmatrix(system);          //matrix inversion
+            thole_bmatrix_dipoles(system);  //get dipoles
+        }
 
         /* output the 3x3 molecular polarizability tensor */
         if (system->polarizability_tensor) {
@@ -24,7 +24,7 @@ University of South Florida
 double sg(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
-    pair_t *pair_ptr;
+    int k;
     double rimg, r6, r8, r9, r10, r_rm;
     double repulsive_term, multipole_term, exponential_term;
     double first_r_diff_term, second_r_diff_term;
@@ -37,10 +37,10 @@ double sg(system_t *system) {
 
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
-                if (pair_ptr->recalculate_energy) {
-                    pair_ptr->rd_energy = 0;
-                    rimg = pair_ptr->rimg;
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                if (atom_ptr->pair_recalculate_energy[k]) {
+                    atom_ptr->pair_rd_energy[k] = 0;
+                    rimg = atom_ptr->pair_rimg[k];
 
                     if (rimg < system->pbc->cutoff) {
                         /* convert units to Bohr radii */
@@ -62,7 +62,7 @@ double sg(system_t *system) {
                             exponential_term = 1.0;
 
                         potential_classical = (repulsive_term - multipole_term * exponential_term);
-                        pair_ptr->rd_energy += potential_classical;
+                        atom_ptr->pair_rd_energy[k] += potential_classical;
 
                         if (system->feynman_hibbs) {
                             /* FIRST DERIVATIVE */
@@ -80,11 +80,11 @@ double sg(system_t *system) {
                             second_derivative += exponential_term * second_r_diff_term * 2.0 * multipole_term;
 
                             potential_fh_second_order = pow(METER2ANGSTROM, 2) * (HBAR * HBAR / (24.0 * KB * temperature * (AMU2KG * molecule_ptr->mass))) * (second_derivative + 2.0 * first_derivative / rimg);
-                            pair_ptr->rd_energy += potential_fh_second_order;
+                            atom_ptr->pair_rd_energy[k] += potential_fh_second_order;
                         }
 
                         /* convert units from Hartrees back to Kelvin */
-                        pair_ptr->rd_energy *= HARTREE2KELVIN;
+                        atom_ptr->pair_rd_energy[k] *= HARTREE2KELVIN;
                     }
 
                 } /* recalculate */
@@ -95,8 +95,8 @@ double sg(system_t *system) {
     potential = 0;
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next)
-                potential += pair_ptr->rd_energy;
+            for (k = 0; k < atom_ptr->npairs; k++)
+                potential += atom_ptr->pair_rd_energy[k];
 
     return (potential);
 }
@@ -105,7 +105,7 @@ double sg(system_t *system) {
 double sg_nopbc(molecule_t *molecules) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
-    pair_t *pair_ptr;
+    int k;
     double r, r6, r8, r10, r9;
     double r_rm, r_rm_2, r_exp;
     double potential, multipole_term;
@@ -113,9 +113,9 @@ double sg_nopbc(molecule_t *molecules) {
 
     for (molecule_ptr = molecules, potential = 0; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
-                if (pair_ptr->recalculate_energy) {
-                    r = pair_ptr->r / AU2ANGSTROM;
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                if (atom_ptr->pair_recalculate_energy[k]) {
+                    r = atom_ptr->pair_r[k] / AU2ANGSTROM;
 
                     r6 = pow(r, 6);
                     r8 = pow(r, 8);
@@ -138,7 +138,7 @@ double sg_nopbc(molecule_t *molecules) {
 
                     exp_result = exp(result);
                     exp_result -= multipole_term;
-                    pair_ptr->rd_energy = HARTREE2KELVIN * exp_result;
+                    atom_ptr->pair_rd_energy[k] = HARTREE2KELVIN * exp_result;
 
                 } /* recalculate */
             }     /* pair */
@@ -148,8 +148,8 @@ double sg_nopbc(molecule_t *molecules) {
     potential = 0;
     for (molecule_ptr = molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next)
-                potential += pair_ptr->rd_energy;
+            for (k = 0; k < atom_ptr->npairs; k++)
+                potential += atom_ptr->pair_rd_energy[k];
 
     return (potential);
 }
@@ -0,0 +1,330 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* smooth particle mesh ewald (Essmann et al., J. Chem. Phys. 103 8577) - the charges are spread onto a */
+/* mesh along the lattice vectors with cardinal b-splines, the mesh is fourier transformed, and the */
+/* fourier space sum runs over the mesh with the b-spline moduli folded into the influence function */
+/* replaces the O(N kmax^3) k-vector sum of coulombic_reciprocal() with an O(N + M log M) one */
+
+/* M_n(w + j) for j = 0 .. order-1, by the recursion M_k(x) = (x M_k-1(x) + (k-x) M_k-1(x-1)) / (k-1) */
+static void spme_bspline(double w, int order, double *M) {
+    int j, k;
+    double x, a, b;
+
+    M[0] = w;
+    M[1] = 1.0 - w;
+    for (k = 3; k <= order; k++) {
+        for (j = k - 1; j >= 0; j--) {
+            x = w + j;
+            a = (j < k - 1) ? M[j] : 0;
+            b = (j > 0) ? M[j - 1] : 0;
+            M[j] = (x * a + (k - x) * b) / (k - 1);
+        }
+    }
+}
+
+/* in-place radix-2 transform of n complex values, stride complex values apart */
+static void spme_fft(double *data, int n, int stride) {
+    int i, j, m, len;
+    double re, im, w_re, w_im, t_re, t_im, u_re, u_im, theta, tmp;
+    double *a, *b;
+
+    /* bit reversal */
+    for (i = 1, j = 0; i < n; i++) {
+        for (m = n >> 1; j & m; m >>= 1) j ^= m;
+        j |= m;
+        if (i < j) {
+            a = &data[2 * i * stride];
+            b = &data[2 * j * stride];
+            tmp = a[0], a[0] = b[0], b[0] = tmp;
+            tmp = a[1], a[1] = b[1], b[1] = tmp;
+        }
+    }
+
+    /* butterflies */
+    for (len = 2; len <= n; len <<= 1) {
+        theta = -2.0 * M_PI / len;
+        w_re = cos(theta);
+        w_im = sin(theta);
+        for (i = 0; i < n; i += len) {
+            re = 1.0;
+            im = 0.0;
+            for (j = 0; j < len / 2; j++) {
+                a = &data[2 * (i + j) * stride];
+                b = &data[2 * (i + j + len / 2) * stride];
+                t_re = b[0] * re - b[1] * im;
+                t_im = b[0] * im + b[1] * re;
+                u_re = a[0];
+                u_im = a[1];
+                a[0] = u_re + t_re;
+                a[1] = u_im + t_im;
+                b[0] = u_re - t_re;
+                b[1] = u_im - t_im;
+                tmp = re * w_re - im * w_im;
+                im = re * w_im + im * w_re;
+                re = tmp;
+            }
+        }
+    }
+}
+
+/* 3d transform of the mesh, one dimension at a time */
+static void spme_fft3d(spme_t *spme, double *grid) {
+    int *n = spme->n;
+    int i, j;
+
+    for (i = 0; i < n[1]; i++)
+        for (j = 0; j < n[2]; j++)
+            spme_fft(&grid[2 * (i * n[2] + j)], n[0], n[1] * n[2]);
+    for (i = 0; i < n[0]; i++)
+        for (j = 0; j < n[2]; j++)
+            spme_fft(&grid[2 * (i * n[1] * n[2] + j)], n[1], n[2]);
+    for (i = 0; i < n[0]; i++)
+        for (j = 0; j < n[1]; j++)
+            spme_fft(&grid[2 * (i * n[1] + j) * n[2]], n[2], 1);
+}
+
+/* |b(m)|^-2 for m = 0 .. n-1, the b-spline modulus along one mesh dimension */
+static void spme_bspline_moduli(int n, int order, double *bmod) {
+    double M[SPME_MAX_ORDER];
+    double re, im, arg;
+    int m, k;
+
+    spme_bspline(0, order, M);
+    for (m = 0; m < n; m++) {
+        re = im = 0;
+        for (k = 0; k < order - 1; k++) {
+            arg = 2.0 * M_PI * m * k / n;
+            re += M[k + 1] * cos(arg);
+            im += M[k + 1] * sin(arg);
+        }
+        bmod[m] = re * re + im * im;
+    }
+
+    /* odd orders vanish at the nyquist point, interpolate over it */
+    for (m = 0; m < n; m++)
+        if (bmod[m] < 1.0e-7) bmod[m] = 0.5 * (bmod[(m - 1 + n) % n] + bmod[(m + 1) % n]);
+}
+
+/* smallest power of two that gives at most grid_spacing between mesh points */
+static int spme_mesh_size(double length, double spacing) {
+    int n = 1;
+
+    while (n * spacing < length) n <<= 1;
+    if (n < 2) n = 2;
+
+    return (n);
+}
+
+/* the mesh and influence function are stale after a volume move or a change of the ewald parameters */
+static int spme_stale(system_t *system) {
+    spme_t *spme = system->spme_mesh;
+
+    return (!spme || (spme->alpha != system->ewald_alpha) || (spme->order != system->spme_order) || (spme->spacing != system->spme_grid_spacing) || memcmp(spme->basis, system->pbc->basis, 9 * sizeof(double)));
+}
+
+/* (re)build the mesh and the influence function for the current box */
+static void spme_setup(system_t *system) {
+    spme_t *spme;
+    int first, i, p, q, l[3], m[3], index;
+    double *bmod[3], k[3], k_squared, length;
+    char linebuf[MAXLINE];
+
+    first = !system->spme_mesh;
+    if (first) {
+        system->spme_mesh = calloc(1, sizeof(spme_t));
+        memnullcheck(system->spme_mesh, sizeof(spme_t), __LINE__ - 1, __FILE__);
+    }
+    spme = system->spme_mesh;
+
+    spme->alpha = system->ewald_alpha;
+    spme->order = system->spme_order;
+    spme->spacing = system->spme_grid_spacing;
+    memcpy(spme->basis, system->pbc->basis, 9 * sizeof(double));
+
+    /* mesh points along each lattice vector */
+    for (p = 0; p < 3; p++) {
+        for (q = 0, length = 0; q < 3; q++)
+            length += system->pbc->basis[p][q] * system->pbc->basis[p][q];
+        spme->n[p] = spme_mesh_size(sqrt(length), spme->spacing);
+        if (spme->n[p] < spme->order) spme->n[p] = spme_mesh_size(spme->order, 1.0);
+    }
+    spme->size = spme->n[0] * spme->n[1] * spme->n[2];
+
+    free(spme->influence);
+    free(spme->grid);
+    free(spme->old_grid);
+    spme->influence = malloc(spme->size * sizeof(double));
+    memnullcheck(spme->influence, spme->size * sizeof(double), __LINE__ - 1, __FILE__);
+    spme->grid = malloc(2 * spme->size * sizeof(double));
+    memnullcheck(spme->grid, 2 * spme->size * sizeof(double), __LINE__ - 1, __FILE__);
+    spme->old_grid = malloc(2 * spme->size * sizeof(double));
+    memnullcheck(spme->old_grid, 2 * spme->size * sizeof(double), __LINE__ - 1, __FILE__);
+
+    for (p = 0; p < 3; p++) {
+        bmod[p] = malloc(spme->n[p] * sizeof(double));
+        memnullcheck(bmod[p], spme->n[p] * sizeof(double), __LINE__ - 1, __FILE__);
+        spme_bspline_moduli(spme->n[p], spme->order, bmod[p]);
+    }
+
+    /* exp(-k^2/4alpha^2)/k^2 / (|b1|^2 |b2|^2 |b3|^2) over the whole mesh, zero at k = 0 */
+    for (m[0] = 0, index = 0; m[0] < spme->n[0]; m[0]++) {
+        for (m[1] = 0; m[1] < spme->n[1]; m[1]++) {
+            for (m[2] = 0; m[2] < spme->n[2]; m[2]++, index++) {
+                for (p = 0; p < 3; p++)
+                    l[p] = (m[p] < spme->n[p] / 2) ? m[p] : m[p] - spme->n[p];
+                if (!l[0] && !l[1] && !l[2]) {
+                    spme->influence[index] = 0;
+                    continue;
+                }
+
+                for (p = 0; p < 3; p++) {
+                    for (q = 0, k[p] = 0; q < 3; q++)
+                        k[p] += 2.0 * M_PI * system->pbc->reciprocal_basis[p][q] * l[q];
+                }
+                k_squared = dddotprod(k, k);
+
+                spme->influence[index] = exp(-k_squared / (4.0 * spme->alpha * spme->alpha)) / k_squared;
+                for (i = 0; i < 3; i++)
+                    spme->influence[index] /= bmod[i][m[i]];
+            }
+        }
+    }
+
+    for (p = 0; p < 3; p++)
+        free(bmod[p]);
+
+    if (first) {
+        sprintf(linebuf,
+                "SPME: %dx%dx%d mesh, b-spline order %d\n", spme->n[0], spme->n[1], spme->n[2], spme->order);
+        output(linebuf);
+    }
+}
+
+/* spread sign * the charges of atom_ptr onto the mesh */
+static void spme_spread_atom(system_t *system, double *grid, atom_t *atom_ptr, double sign) {
+    spme_t *spme = system->spme_mesh;
+    double M[3][SPME_MAX_ORDER];
+    double s, u, charge;
+    int p, q, i, j, k, base[3], index[3][SPME_MAX_ORDER];
+
+    if (atom_ptr->charge == 0.0) return;
+
+    for (q = 0; q < 3; q++) {
+        /* fractional coordinate along lattice vector q, scaled to the mesh */
+        for (p = 0, s = 0; p < 3; p++)
+            s += system->pbc->reciprocal_basis[p][q] * atom_ptr->pos[p];
+        s -= floor(s);
+        u = s * spme->n[q];
+        base[q] = (int)floor(u);
+
+        /* the point base - j carries M_n(u - base + j) */
+        spme_bspline(u - base[q], spme->order, M[q]);
+        for (j = 0; j < spme->order; j++)
+            index[q][j] = ((base[q] - j) % spme->n[q] + spme->n[q]) % spme->n[q];
+    }
+
+    charge = sign * atom_ptr->charge;
+    for (i = 0; i < spme->order; i++)
+        for (j = 0; j < spme->order; j++)
+            for (k = 0; k < spme->order; k++)
+                grid[2 * ((index[0][i] * spme->n[1] + index[1][j]) * spme->n[2] + index[2][k])] += charge * M[0][i] * M[1][j] * M[2][k];
+}
+
+/* spread sign * the mobile charges of molecule_ptr onto the mesh */
+static void spme_spread_molecule(system_t *system, double *grid, molecule_t *molecule_ptr, double sign) {
+    atom_t *atom_ptr;
+
+    for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+        if (!atom_ptr->frozen) spme_spread_atom(system, grid, atom_ptr, sign);
+}
+
+/* transformed charge mesh of the frozen atoms, which only changes with the box */
+static void spme_frozen(system_t *system) {
+    spme_t *spme = system->spme_mesh;
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+
+    free(spme->frozen_grid);
+    spme->frozen_grid = calloc(2 * spme->size, sizeof(double));
+    memnullcheck(spme->frozen_grid, 2 * spme->size * sizeof(double), __LINE__ - 1, __FILE__);
+
+    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            if (atom_ptr->frozen) spme_spread_atom(system, spme->frozen_grid, atom_ptr, 1.0);
+    spme_fft3d(spme, spme->frozen_grid);
+}
+
+/* charge mesh of every mobile charged atom in the list */
+static void spme_spread(system_t *system, double *grid) {
+    molecule_t *molecule_ptr;
+
+    memset(grid, 0, 2 * system->spme_mesh->size * sizeof(double));
+    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        spme_spread_molecule(system, grid, molecule_ptr, 1.0);
+}
+
+/* term of the i-th mesh point of the transformed charge mesh arg, added to potential */
+/* with the framework included, the cross term with the frozen mesh is added as in kspace_energy() */
+static void spme_energy_k(system_t *system, int i, void *arg, double *potential) {
+    double *grid = arg;
+    double *frozen = system->spme_mesh->frozen_grid;
+    double energy;
+
+    energy = grid[2 * i] * grid[2 * i] + grid[2 * i + 1] * grid[2 * i + 1];
+    if (frozen) energy += 2.0 * (grid[2 * i] * frozen[2 * i] + grid[2 * i + 1] * frozen[2 * i + 1]);
+
+    *potential += system->spme_mesh->influence[i] * energy;
+}
+
+/* fourier space sum of a transformed charge mesh - the whole mesh, not a half-sphere */
+static double spme_energy(system_t *system, double *grid) {
+    double potential;
+
+    potential = thread_sum(system, system->spme_mesh->size, spme_energy_k, grid);
+    potential *= 2.0 * M_PI / system->pbc->volume;
+
+    return (potential);
+}
+
+/* fourier space sum by smooth particle mesh ewald */
+double spme_reciprocal(system_t *system) {
+    if (spme_stale(system)) {
+        spme_setup(system);
+        if (system->ewald_framework) spme_frozen(system);
+    }
+
+    spme_spread(system, system->spme_mesh->grid);
+    spme_fft3d(system->spme_mesh, system->spme_mesh->grid);
+
+    return (spme_energy(system, system->spme_mesh->grid));
+}
+
+/* change in the fourier space sum when "added" entered the list and "removed" left it, as coulombic_reciprocal_delta() */
+/* the charge mesh is linear in the charges, so the mesh before the move is the current one with the moved molecules swapped back */
+double spme_reciprocal_delta(system_t *system, molecule_t *added, molecule_t *removed) {
+    spme_t *spme;
+
+    if (spme_stale(system)) {
+        spme_setup(system);
+        if (system->ewald_framework) spme_frozen(system);
+    }
+    spme = system->spme_mesh;
+
+    spme_spread(system, spme->grid);
+    memcpy(spme->old_grid, spme->grid, 2 * spme->size * sizeof(double));
+    if (added) spme_spread_molecule(system, spme->old_grid, added, -1.0);
+    if (removed) spme_spread_molecule(system, spme->old_grid, removed, 1.0);
+
+    spme_fft3d(spme, spme->grid);
+    spme_fft3d(spme, spme->old_grid);
+
+    return (spme_energy(system, spme->grid) - spme_energy(system, spme->old_grid));
+}
@@ -349,6 +349,7 @@ double lr_vdw_corr(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
     pair_t *pair_ptr;
+    int k;
     double w1, w2;    //omegas
     double a1, a2;    //alphas
     double cC;        //leading coefficient to r^-6
@@ -363,7 +364,8 @@ double lr_vdw_corr(system_t *system) {
 
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
                 //skip if frozen
                 if (pair_ptr->frozen) continue;
                 //skip if same molecule  // don't do this... this DOES contribute to LRC
@@ -432,6 +434,7 @@ double fh_vdw_corr(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
     pair_t *pair_ptr;
+    int k;
     double rm;                 //reduced mass
     double E[5];               //energy at five points, used for finite differencing
     double dv, d2v, d3v, d4v;  //derivatives
@@ -442,23 +445,24 @@ double fh_vdw_corr(system_t *system) {
     //for each pair
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
                 //skip if frozen
                 if (pair_ptr->frozen) continue;
                 //skip if they belong to the same molecule
                 if (molecule_ptr == pair_ptr->molecule) continue;
                 //skip if distance is greater than cutoff
-                if (pair_ptr->rimg > system->pbc->cutoff) continue;
+                if (atom_ptr->pair_rimg[k] > system->pbc->cutoff) continue;
                 //check if fh is non-zero
                 if (atom_ptr->polarizability == 0 || pair_ptr->atom->polarizability == 0 ||
                     atom_ptr->omega == 0 || pair_ptr->atom->omega == 0) continue;  //no vdw energy
 
                 //calculate two-body energies
-                E[0] = e2body(system, atom_ptr, pair_ptr, pair_ptr->rimg - h - h);  //smaller r
-                E[1] = e2body(system, atom_ptr, pair_ptr, pair_ptr->rimg - h);
-                E[2] = e2body(system, atom_ptr, pair_ptr, pair_ptr->rimg);      //current r
-                E[3] = e2body(system, atom_ptr, pair_ptr, pair_ptr->rimg + h);  //larger r
-                E[4] = e2body(system, atom_ptr, pair_ptr, pair_ptr->rimg + h + h);
+                E[0] = e2body(system, atom_ptr, pair_ptr, atom_ptr->pair_rimg[k] - h - h);  //smaller r
+                E[1] = e2body(system, atom_ptr, pair_ptr, atom_ptr->pair_rimg[k] - h);
+                E[2] = e2body(system, atom_ptr, pair_ptr, atom_ptr->pair_rimg[k]);      //current r
+                E[3] = e2body(system, atom_ptr, pair_ptr, atom_ptr->pair_rimg[k] + h);  //larger r
+                E[4] = e2body(system, atom_ptr, pair_ptr, atom_ptr->pair_rimg[k] + h + h);
 
                 //derivatives (Numerical Methods Using Matlab 4E 2004 Mathews/Fink 6.2)
                 dv = (E[3] - E[1]) / (2.0 * h);
@@ -471,11 +475,11 @@ double fh_vdw_corr(system_t *system) {
                      ((molecule_ptr->mass) + (pair_ptr->molecule->mass));
 
                 //2nd order correction
-                corr_single = pow(METER2ANGSTROM, 2) * (HBAR * HBAR / (24.0 * KB * system->temperature * rm)) * (d2v + 2.0 * dv / pair_ptr->rimg);
+                corr_single = pow(METER2ANGSTROM, 2) * (HBAR * HBAR / (24.0 * KB * system->temperature * rm)) * (d2v + 2.0 * dv / atom_ptr->pair_rimg[k]);
                 //4th order correction
                 if (system->feynman_hibbs_order >= 4)
                     corr_single += pow(METER2ANGSTROM, 4) * (pow(HBAR, 4) / (1152.0 * pow(KB * system->temperature * rm, 2))) *
-                                   (15.0 * dv / pow(pair_ptr->rimg, 3) + 4.0 * d3v / pair_ptr->rimg + d4v);
+                                   (15.0 * dv / pow(atom_ptr->pair_rimg[k], 3) + 4.0 * d3v / atom_ptr->pair_rimg[k] + d4v);
 
                 corr += corr_single;
             }
@@ -490,6 +494,7 @@ double fh_vdw_corr_2be(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
     pair_t *pair_ptr;
+    int k;
     double rm;                 //reduced mass
     double w1, w2;             //omegas
     double a1, a2;             //alphas
@@ -501,13 +506,14 @@ double fh_vdw_corr_2be(system_t *system) {
     //for each pair
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
                 //skip if frozen
                 if (pair_ptr->frozen) continue;
                 //skip if they belong to the same molecule
                 if (molecule_ptr == pair_ptr->molecule) continue;
                 //skip if distance is greater than cutoff
-                if (pair_ptr->rimg > system->pbc->cutoff) continue;
+                if (atom_ptr->pair_rimg[k] > system->pbc->cutoff) continue;
                 //fetch alphas and omegas
                 a1 = atom_ptr->polarizability;
                 a2 = pair_ptr->atom->polarizability;
@@ -521,19 +527,19 @@ double fh_vdw_corr_2be(system_t *system) {
                      ((molecule_ptr->mass) + (pair_ptr->molecule->mass));
 
                 //derivatives
-                dv = 6.0 * cC * pow(pair_ptr->rimg, -7);
-                d2v = dv * (-7.0) / pair_ptr->rimg;
+                dv = 6.0 * cC * pow(atom_ptr->pair_rimg[k], -7);
+                d2v = dv * (-7.0) / atom_ptr->pair_rimg[k];
                 if (system->feynman_hibbs_order >= 4) {
-                    d3v = d2v * (-8.0) / pair_ptr->rimg;
-                    d4v = d3v * (-9.0) / pair_ptr->rimg;
+                    d3v = d2v * (-8.0) / atom_ptr->pair_rimg[k];
+                    d4v = d3v * (-9.0) / atom_ptr->pair_rimg[k];
                 }
 
                 //2nd order correction
-                corr_single = pow(METER2ANGSTROM, 2) * (HBAR * HBAR / (24.0 * KB * system->temperature * rm)) * (d2v + 2.0 * dv / pair_ptr->rimg);
+                corr_single = pow(METER2ANGSTROM, 2) * (HBAR * HBAR / (24.0 * KB * system->temperature * rm)) * (d2v + 2.0 * dv / atom_ptr->pair_rimg[k]);
                 //4th order correction
                 if (system->feynman_hibbs_order >= 4)
                     corr_single += pow(METER2ANGSTROM, 4) * (pow(HBAR, 4) / (1152.0 * pow(KB * system->temperature * rm, 2))) *
-                                   (15.0 * dv / pow(pair_ptr->rimg, 3) + 4.0 * d3v / pair_ptr->rimg + d4v);
+                                   (15.0 * dv / pow(atom_ptr->pair_rimg[k], 3) + 4.0 * d3v / atom_ptr->pair_rimg[k] + d4v);
 
                 corr += corr_single;
             }
@@ -548,24 +554,26 @@ double twobody(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
     pair_t *pair_ptr;
+    int k;
     double energy = 0;
 
     //for each pair
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
                 //skip if frozen
                 if (pair_ptr->frozen) continue;
                 //skip if they belong to the same molecule
                 if (molecule_ptr == pair_ptr->molecule) continue;
                 //skip if distance is greater than cutoff
-                if (pair_ptr->rimg > system->pbc->cutoff) continue;
+                if (atom_ptr->pair_rimg[k] > system->pbc->cutoff) continue;
                 //check if fh is non-zero
                 if (atom_ptr->polarizability == 0 || pair_ptr->atom->polarizability == 0 ||
                     atom_ptr->omega == 0 || pair_ptr->atom->omega == 0) continue;  //no vdw energy
 
                 //calculate two-body energies
-                energy += e2body(system, atom_ptr, pair_ptr, pair_ptr->rimg);
+                energy += e2body(system, atom_ptr, pair_ptr, atom_ptr->pair_rimg[k]);
             }
         }
     }
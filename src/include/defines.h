@@ -66,6 +66,40 @@
 #define FEYNMAN_KLEINERT_TOLERANCE 1.0e-12 /* tolerance in A^2 */
 /*tolerance in r and r->img when comparisons are made for system->pbc->cutoff and similar boxsize issues*/
 #define SMALL_dR 1.0e-12
+
+#define THREAD_PAD 8 /* doubles between the partial sums of neighbouring threads, one cache line */
+
+#define NEIGHBOR_SKIN 2.0 /* default verlet skin in angstroms */
+
+#define DELTA_ENERGY_TOLERANCE 1.0e-6 /* relative drift between delta and full energies that gets reported */
+
+#define FRAMEWORK_GRID_SPACING 0.25 /* default framework grid spacing in angstroms */
+#define FRAMEWORK_GRID_MAX 1.0e6    /* framework grid values are capped at this energy (K) */
+
+#define EWALD_LOOKUP_DENSITY 100           /* default ewald real-space table nodes per angstrom */
+#define EWALD_LOOKUP_TOLERANCE 1.0e-10     /* largest interpolation error accepted for the ewald table */
+#define EWALD_SF_REFRESH 1000              /* incremental structure factor updates between full sums */
+#define EWALD_TUNE_SPLITS 50               /* ways of sharing the ewald_precision error between the real and fourier sums */
+#define EWALD_TUNE_MAX_KMAX 40             /* largest kmax ewald_precision will choose */
+#define SPME_ORDER 6                       /* default b-spline order of the particle mesh */
+#define SPME_MAX_ORDER 12                  /* highest b-spline order accepted */
+#define SPME_GRID_SPACING 1.0              /* default largest mesh spacing in angstroms */
+#define LDLT_BLOCK 64                      /* block size of the L D L^T factorization of the A matrix */
+#define POLAR_FIELD_REFRESH 1000           /* incremental static field updates between full sums */
+#define POLAR_FIELD_GRID_SPACING 0.25      /* default static field grid spacing in angstroms */
+#define POLAR_FIELD_GRID_MAX 1.0e3         /* static field grid values are capped at this field (e/A^2) */
+#define POLAR_WOODBURY_REFRESH 100         /* low-rank updates of the inverted A matrix between full inversions */
+#define POLAR_ANDERSON_DEPTH 5             /* default number of dipole passes kept for anderson mixing */
+#define POLAR_ANDERSON_MAX_DEPTH 32        /* upper limit of polar_anderson_depth */
+#define POLAR_ANDERSON_REGULARIZE 1.0e-10  /* relative tikhonov shift of the anderson normal equations */
+#define POLAR_PCG_TOLERANCE 1.0e-8         /* default relative residual of the conjugate gradient dipole solver */
+#define POLAR_PCG_MAX_ITER 500             /* conjugate gradient iterations before giving up, without polar_max_iter */
+#define POLAR_PCG_BLOCK_MAX 32             /* largest molecule given its own block in the conjugate gradient preconditioner */
+#define POLAR_GS_COLOR_CUTOFF 3.0          /* default distance within which polarizable atoms get different gauss-seidel colors */
+
+/* walk either the full pair list of an atom, or its verlet neighbor list - the n-th step of the walk visits pair PAIR_INDEX */
+#define PAIR_COUNT(system, atom) ((system)->neighbor_list ? (atom)->nneighbors : (atom)->npairs)
+#define PAIR_INDEX(system, atom, n) ((system)->neighbor_list ? (atom)->neighbors[n] : (n))
 /*default frequency for parallel tempering bath swaps*/
 #define PTEMP_FREQ_DEFAULT 20
 
@@ -77,6 +111,8 @@ enum { READ,
 enum { DAMPING_OFF,
        DAMPING_LINEAR,
        DAMPING_EXPONENTIAL };
+enum { PCG_PRECOND_ATOM,
+       PCG_PRECOND_MOLECULE };
 enum { NUCLEAR_SPIN_PARA,
        NUCLEAR_SPIN_ORTHO };
 enum {
@@ -143,5 +179,6 @@ enum {
 
 // Maximum coef for each basis vector when searching for shortest vector
 #define MAX_VECT_COEF 5
+#define PBC_ORTHORHOMBIC_TOLERANCE 1.0e-12 /* relative size of off-diagonal basis terms that still count as orthorhombic */
 
 #endif
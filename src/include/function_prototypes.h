@@ -4,16 +4,21 @@
 /* energy */
 double energy(system_t *);
 double energy_no_observables(system_t *);
+double energy_delta(system_t *);
 double cavity_absolute_check(system_t *);
 double lj(system_t *);
 double lj_nopbc(system_t *);
+double lj_lrc_corr(system_t *, atom_t *, pair_t *, double, double);
+double lj_lrc_self(system_t *, atom_t *, double);
+double lj_cutoff(system_t *);
+double lj_pair(system_t *, molecule_t *, atom_t *, pair_t *, double, double);
 double exp_repulsion(system_t *);
 double exp_repulsion_nopbc(system_t *);
 double dreiding(system_t *);
 double dreiding_nopbc(molecule_t *);
 double lj_buffered_14_7(system_t *);
 double lj_buffered_14_7_nopbc(system_t *);
-double disp_expansion_lrc(const system_t *, pair_t *, const double);
+double disp_expansion_lrc(const system_t *, pair_t *, double, const double);
 double disp_expansion_lrc_self(const system_t *, atom_t *, const double);
 double disp_expansion(system_t *);
 double disp_expansion_nopbc(system_t *);
@@ -22,24 +27,60 @@ double factorial(int);
 double tt_damping(int, double);
 void countN(system_t *);
 void update_com(molecule_t *);
+void update_molecule_com(molecule_t *);
+void start_dirty_tracking(system_t *);
+void update_molecule_arrays(system_t *, molecule_t *, molecule_t *);
 void flag_all_pairs(system_t *);
 void pair_exclusions(system_t *, molecule_t *, molecule_t *, atom_t *, atom_t *, pair_t *);
-void minimum_image(system_t *, atom_t *, atom_t *, pair_t *);
+void minimum_image_separation(system_t *, atom_t *, atom_t *, double *, double *, double *);
+void minimum_image(system_t *, atom_t *, atom_t *, int);
+void minimum_image_batch(pbc_t *, double *, int, double *, double *, double *, double *, double *, double *, double *);
 void pairs(system_t *);
+int neighbor_list_expired(system_t *);
+void build_neighbor_list(system_t *);
+void neighbor_list_pairs(system_t *);
+void setup_framework_grid(system_t *);
+void framework_grid_site(system_t *, molecule_t *, atom_t *, double *, double *);
+void framework_grid_energy(system_t *, double *, double *);
+void grid_catmull_rom(int *, double *, double[3][4], int[3][4]);
 void setup_pairs(system_t *);
+void resize_pairs(atom_t *, int);
 void update_pairs_insert(system_t *);
 void update_pairs_remove(system_t *);
 void unupdate_pairs_insert(system_t *);
 void unupdate_pairs_remove(system_t *);
 double pbc_cutoff(pbc_t *);
 double pbc_volume(pbc_t *);
+int pbc_orthorhombic(pbc_t *);
 void pbc(system_t *);
 double sg(system_t *);
 double sg_nopbc(molecule_t *);
 double coulombic(system_t *);
 double coulombic_wolf(system_t *);
+double coulombic_wolf_pair(system_t *, atom_t *, pair_t *, double, double);
 double coulombic_real(system_t *);
+void setup_ewald_table(system_t *);
+void update_ewald_table(system_t *);
+void ewald_table_lookup(system_t *, double, double *, double *);
+void kspace_update(system_t *);
+void kspace_atoms(system_t *, int);
+void kspace_charges(kspace_t *, int, double *, double *);
+void kspace_molecules(system_t *, molecule_t *, molecule_t *);
+void kspace_moved_charges(kspace_t *, int, double *, double *);
+void kspace_dipoles(kspace_t *, int, double *, double *);
+void kspace_field(kspace_t *, int, double *, double *, double *, double *);
+double kspace_energy(kspace_t *, int, double, double);
+double ewald_sf_reciprocal(system_t *);
+double ewald_sf_reciprocal_delta(system_t *, int *);
+void ewald_sf_move(system_t *);
+void ewald_sf_restore(system_t *);
+void ewald_sf_accept(system_t *);
+void ewald_tune(system_t *);
+double spme_reciprocal(system_t *);
+double spme_reciprocal_delta(system_t *, molecule_t *, molecule_t *);
+double coulombic_real_pair(system_t *, molecule_t *, atom_t *, pair_t *, double, double, double *);
 double coulombic_reciprocal(system_t *);
+double coulombic_reciprocal_delta(system_t *, molecule_t *, molecule_t *);
 double coulombic_background(system_t *);
 double coulombic_nopbc(molecule_t *);
 double coulombic_real_gwp(system_t *);
@@ -91,6 +132,7 @@ void update_root_averages(system_t *, observables_t *, avg_observables_t *);
 void update_root_sorb_averages(system_t *, sorbateInfo_t *);
 void update_root_nodestats(system_t *, avg_nodestats_t *, avg_observables_t *);
 int write_performance(int, system_t *);
+double calctimediff(struct timeval, struct timeval);
 int print_observables(system_t *);
 int write_averages(system_t *);
 int write_molecules(system_t *, FILE *);
@@ -101,6 +143,7 @@ void write_field(system_t *);
 void write_states(system_t *);
 void write_surface_traj(FILE *, system_t *);
 int wrapall(molecule_t *, pbc_t *);
+void wrap_molecule(molecule_t *, pbc_t *);
 void spectre_wrapall(system_t *);
 int open_files(system_t *);
 int open_surf_traj_file(system_t *);
@@ -122,17 +165,26 @@ void free_molecules(molecule_t *);
 void free_averages(system_t *system);
 void free_matrices(system_t *system);
 void free_cavity_grid(system_t *system);
+void free_framework_grid(system_t *system);
+void free_polar_field_grid(system_t *system);
+void free_polar_anderson(system_t *system);
+void free_woodbury(system_t *system);
+void free_schur(system_t *system);
+void free_polar_colors(system_t *system);
 void cleanup(system_t *);
 void terminate_handler(int, system_t *);
 int memnullcheck(void *, int, int, char *);
 int filecheck(void *, char *, int);
 void free_all_molecules(molecule_t *);
 void free_all_pairs(system_t *);
+double thread_sum(system_t *, int, void (*)(system_t *, int, void *, double *), void *);
 
 /* mc */
 void temper_system(system_t *, double);
 void enumerate_particles(system_t *);
 void boltzmann_factor(system_t *, double, double, double);
+int delta_energy_move(system_t *, double);
+void check_delta_energy(system_t *);
 void register_accept(system_t *);
 void register_reject(system_t *);
 int mc(system_t *);
@@ -191,8 +243,32 @@ double polar(system_t *);
 void thole_amatrix(system_t *);
 void thole_bmatrix(system_t *);
 void thole_bmatrix_dipoles(system_t *);
+int thole_site(system_t *, atom_t *);
+void thole_ldlt_factor(system_t *, int);
+void thole_ldlt_solve(system_t *, double *);
+void ldlt_factor(system_t *, ldlt_t **, double **, int);
+void ldlt_solve(ldlt_t *, double *);
+void thole_schur_dipoles(system_t *);
+void thole_schur_move(system_t *);
+void thole_schur_restore(system_t *);
+void thole_schur_accept(system_t *);
 void thole_polarizability_tensor(system_t *);
 void thole_field(system_t *);
+void thole_field_move(system_t *);
+void thole_field_restore(system_t *);
+void thole_field_accept(system_t *);
+void polar_anderson_reset(system_t *);
+void thole_woodbury(system_t *, int);
+void thole_woodbury_move(system_t *);
+void thole_woodbury_restore(system_t *);
+void thole_woodbury_accept(system_t *);
+void polar_anderson_mix(system_t *);
+void polar_gs_color_setup(system_t *, int *);
+void polar_gs_color_invalidate(system_t *);
+double thole_field_kernel(system_t *, double);
+void setup_polar_field_grid(system_t *);
+void polar_field_grid_site(system_t *, atom_t *);
+void polar_field_grid_field(system_t *);
 void thole_field_wolf(system_t *);
 void thole_field_nopbc(system_t *);
 void thole_field_real(system_t *);
@@ -201,12 +277,16 @@ void thole_field_self(system_t *);
 double *polar_wolf_alpha_lookup_init(system_t *);
 double polar_wolf_alpha_getval(system_t *, double);
 int thole_iterative(system_t *);
+void polar_warm_start_accept(system_t *);
+int thole_pcg(system_t *);
+void LU_decomp(double **, int, int *, double *);
+void LU_bksb(double **, int, int *, double[]);
 void invert_matrix(int, double **, double **);
 int countNatoms(system_t *);
 void thole_resize_matrices(system_t *);
 void print_matrix(int N, double **matrix);
 void ewald_estatic(system_t *);
-void ewald_full(system_t *);
+int ewald_full(system_t *);
 void calc_dipole_rrms(system_t *);
 int are_we_done_yet(system_t *, int);
 
@@ -18,18 +18,15 @@ typedef struct _pair {
     int frozen;  //are they both MOF atoms, for instance
     int rd_excluded, es_excluded;
     int attractive_only;
-    int recalculate_energy;
-    double lrc;               //LJ long-range correction
-    double last_volume;       //what was the volume when we last calculated LRC? needed for NPT
-    double epsilon, sigma;    //LJ
-    double r, rimg, dimg[3];  //separation and separation with nearest image
-    double d_prev[3];         //last known position
-    double rd_energy, es_real_energy, es_self_intra_energy;
+    double last_volume;     //what was the volume when we last calculated LRC? needed for NPT
+    double epsilon, sigma;  //LJ
+    double d_prev[3];       //last known position
     double sigrep;
     double c6, c8, c10;
     struct _atom *atom;
     struct _molecule *molecule;
-    struct _pair *next;
+    int atom_index;  //position of atom in atom_array, used to relink neighbor pairs
+    int nlist_id;    //last neighbor list build that included this pair
 } pair_t;
 
 typedef struct _atom {
@@ -42,12 +39,25 @@ typedef struct _atom {
     double pos[3], wrapped_pos[3];  //absolute and wrapped (into main unit cell) position
     double ef_static[3], ef_static_self[3], ef_induced[3], ef_induced_change[3];
     double mu[3], old_mu[3], new_mu[3];
+    double ef_static_old[3];               // static field of the accepted configuration while a move is tried (polar_field_incremental)
+    double mu_last[3], ef_static_last[3];  // dipole and total static field of the last accepted configuration (polar_warm_start)
     double dipole_rrms;
     double rank_metric;
     int gwp_spin;
     double gwp_alpha;
     int site_neighbor_id;  // dr fluctuations will be applied along the vector from this atom to the atom identified by this variable
-    pair_t *pairs;
+    pair_t *pairs;        // contiguous block, pairs[k] is the pair with the k-th atom after this one
+    int npairs, max_pairs;
+    /* the per-pair terms that the energy kernels stream through, in arrays parallel to pairs */
+    double *pair_r, *pair_rimg;    // separation and separation with nearest image
+    double *pair_dimg;             // nearest image displacement, pair k at [3k, 3k+2]
+    double *pair_rd_energy, *pair_es_real_energy, *pair_es_self_intra_energy;
+    double *pair_lrc;              // LJ long-range correction
+    int *pair_recalculate_energy;  // the pair moved since its energies were last computed
+    int *neighbors;                // verlet neighbor list, the indices of the pairs within cutoff + skin
+    int nneighbors;
+    double nlist_pos[3];  // position at the last neighbor list build
+    int nlist_id;         // neighbor list build that this atom belongs to
     double lrc_self, last_volume;  // currently only used in disp_expansion.c
     struct _atom *next;
 
@@ -59,6 +69,8 @@ typedef struct _molecule {
     double mass;
     int frozen, adiabatic, spectre, target;
     double com[3], wrapped_com[3];  //center of mass
+    int dirty;                      //moved since com and wrapped coords were last updated
+    int atom_index;                 //position of the first atom in system->atom_array
     double iCOM[3];                 // initial Center of Mass
     int nuclear_spin;
     double rot_partfunc_g, rot_partfunc_u, rot_partfunc;
@@ -98,6 +110,7 @@ typedef struct _pbc {
     double reciprocal_basis[3][3]; /* reciprocal space lattice (1/A) */
     double cutoff;                 /* radial cutoff (A) */
     double volume;                 /* unit cell volume (A^3) */
+    int orthorhombic;              /* lattice vectors lie along the cartesian axes */
 } pbc_t;
 
 typedef struct _cavity {
@@ -105,6 +118,160 @@ typedef struct _cavity {
     double pos[3];
 } cavity_t;
 
+//cubic hermite table of the ewald real-space kernel
+typedef struct _ewald_table {
+    double alpha, cutoff; /* the table is rebuilt if either changes */
+    double h;             /* node spacing (A) */
+    int n;                /* number of nodes */
+    double *values;       /* per node: erfc(ar), h*d/dr, exp(-a^2r^2), h*d/dr */
+    double max_error;     /* largest interpolation error found at the midpoints */
+} ewald_table_t;
+
+//k-vectors of the ewald fourier sums, and the exp(ik.r) tables of the atoms
+typedef struct _kspace {
+    int kmax, nk;
+    int version;                            /* bumped whenever the k-vectors are rebuilt */
+    double alpha, polar_alpha, basis[3][3]; /* what the k-vectors were built for */
+    int *l;                                 /* [3*nk] integer components */
+    double *k;                              /* [3*nk] k-vectors */
+    double *weight;                         /* [nk] exp(-k^2/4alpha^2)/k^2 for ewald_alpha */
+    double *polar_weight;                   /* [nk] the same for polar_ewald_alpha */
+    double *frozen_re, *frozen_im;          /* [nk] structure factor of the frozen atoms, with ewald_framework */
+    int natoms, max_natoms, width;          /* tabulated atoms, and complex entries per atom */
+    atom_t **atoms;
+    double *eikr; /* per atom: exp(i l 2pi s_q) for l[0] = 0..kmax, then l[1], l[2] = -kmax..kmax */
+    int nmoved, max_moved, moved_width;     /* tabulated atoms of the molecules a move added or removed */
+    double *moved_q;                        /* [nmoved] their charges, negated for the removed ones */
+    double *moved_eikr;                     /* [nmoved*moved_width] as eikr */
+} kspace_t;
+
+//ewald structure factor of the accepted configuration, kept between mc steps
+typedef struct _ewald_sf {
+    int nk;                   /* k-vectors, as in system->kspace */
+    int version;              /* system->kspace->version the structure factor was summed for */
+    double *re, *im;          /* [nk] structure factor */
+    double *old_re, *old_im;  /* [nk] structure factor before the last update, for restore() */
+    int valid;                /* re and im hold the accepted configuration */
+    int updates;              /* incremental updates since the last full sum */
+    int pending;              /* a move was made that the structure factor doesn't reflect yet */
+    int applied, rebuilt;     /* what the current move did to the structure factor */
+} ewald_sf_t;
+
+//static electric field of the accepted configuration, kept between mc steps
+typedef struct _ef_static_cache {
+    int valid;             /* ef_static of every atom holds the accepted configuration */
+    int updates;           /* incremental updates since the last full sum */
+    int pending;           /* a move was made that the field doesn't reflect yet */
+    int applied, rebuilt;  /* what the current move did to the field */
+} ef_static_cache_t;
+
+//dipole field tensor as 3x3 blocks of the interacting pairs, rows in compressed (CSR) form
+typedef struct _amatrix_sparse {
+    int N, max_N;     /* block rows (the sites of A_sites), and allocated */
+    int nnz, max_nnz; /* off-diagonal blocks, and allocated */
+    int *row;         /* [N+1] first block of each row */
+    int *col;         /* [nnz] column site of each block */
+    double *block;    /* [9*nnz] row-major Tij */
+    double *diag;     /* [N] 1/alpha of the diagonal blocks */
+    int *next;        /* [N] scratch of the build, the next block of a row to mirror into the rows after it */
+} amatrix_sparse_t;
+
+//atoms with rows in the dense A matrix
+typedef struct _polar_sites {
+    int n, max_atoms; /* number of sites, and the size of the arrays */
+    int *site;        /* [natoms] site of each atom of the atom_array, -1 for none */
+    int *atom;        /* [natoms] atom_array index of each site */
+} polar_sites_t;
+
+//L D L^T factor of the A matrix, for the dipoles without forming B
+typedef struct _ldlt {
+    int n, max_n;  /* size of A, and of the arrays */
+    double *a;     /* [n*n] factor, row-major */
+    double *w;     /* [n*LDLT_BLOCK] panel of L D for the blocked factorization */
+    int *ipiv;     /* [n] pivots of the LAPACK factorization */
+} ldlt_t;
+
+//smooth particle mesh ewald charge mesh and influence function
+typedef struct _spme {
+    double alpha, spacing, basis[3][3]; /* the mesh is rebuilt if any of these change */
+    int order;                          /* b-spline order */
+    int n[3], size;                     /* mesh points along each lattice vector, and in total */
+    double *influence;                  /* [size] exp(-k^2/4alpha^2)/k^2 over the b-spline moduli */
+    double *grid, *old_grid;            /* [2*size] complex charge mesh, before and after the move */
+    double *frozen_grid;                /* [2*size] transformed mesh of the frozen charges, with ewald_framework */
+} spme_t;
+
+//framework potential tabulated for each type of mobile site
+typedef struct _framework_grid {
+    int n[3];                   /* grid points along each lattice vector */
+    int ntypes;                 /* number of distinct mobile sites */
+    atom_t *sites;              /* parameters of each site type */
+    molecule_t *site_molecules; /* the molecule (mass) each site type belongs to */
+    double **rd;                /* [type][point] repulsion/dispersion (K) */
+    double **es;                /* [type][point] electrostatics (K) */
+    double *lrc;                /* [type] LJ long-range correction with the frozen atoms (K) */
+    int shared_es;              /* es of every type points at one unit-charge potential */
+} framework_grid_t;
+
+//inverse of the A matrix kept between mc steps, and updated for the moved molecule
+typedef struct _woodbury {
+    int n, n_trial, max_n;      /* size of the accepted and the trial A, and the size allocated */
+    int valid;                  /* B is the inverse of the accepted A */
+    int pending;                /* a move was made that the inverse has yet to see */
+    int applied;                /* B_trial holds the inverse of the trial configuration */
+    int updates, trial_updates; /* low-rank updates since the last full inversion */
+    int s, k;                   /* rows of A changed by the trial move */
+    double *B, *B_trial;        /* [n*n] accepted and trial inverse */
+    double *A;                  /* [n*n] accepted A */
+    double *current;            /* the inverse of the configuration the energy was last computed for */
+} woodbury_t;
+
+//frozen block of the A matrix inverted once, for the schur complement of the mobile dipoles
+typedef struct _schur {
+    int nf;                    /* 3 x frozen atoms */
+    double **Finv;             /* [nf][nf] inverse of the frozen-frozen block */
+    int max_atoms, max_ns;     /* sizes allocated */
+    int *frozen, *mobile;      /* [max_atoms] the frozen and the mobile sites */
+    int ns, ns_trial;          /* 3 x mobile atoms of the accepted and the trial configuration */
+    int valid;                 /* c, g and sigma belong to the accepted configuration */
+    int pending;               /* a move was made that they have yet to see */
+    int applied;               /* the trial ones belong to the configuration of the move */
+    double *c, *g;             /* [nf*ns] frozen-mobile block C of A, and G = Finv C */
+    double **sigma;            /* [ns][ns] schur complement S - C^T Finv C */
+    double *c_trial, *g_trial; /* the same for the trial configuration */
+    double **sigma_trial;
+    double *b, *gf;            /* [nf+2*ns+1] static field and mobile dipoles, [nf+1] Finv E_f */
+    ldlt_t *factor;            /* L D L^T factor of sigma */
+} schur_t;
+
+//graph coloring of the polarizable atoms for the multicolor gauss-seidel
+typedef struct _polar_colors {
+    int ncolors;
+    int valid;              /* made for the current pair lists, cleared when they are rebuilt */
+    int max_atoms;          /* size allocated */
+    int *color;             /* [natoms] color of each atom */
+    int *first;             /* [ncolors+1] start of each color in atoms */
+    int *atoms;             /* [natoms] atom_array indices, by color */
+    int *stamp;             /* [natoms] scratch of the coloring */
+    double *pos;            /* [3*natoms] positions the atoms were colored at */
+} polar_colors_t;
+
+//history of the anderson-mixed dipole iteration
+typedef struct _polar_anderson {
+    int n, max_n;            /* 3 x atoms, and the size allocated */
+    int count;               /* passes mixed so far in this solve */
+    double *x, *g;           /* [n] dipoles into and out of the current pass */
+    double *x_last, *f_last; /* [n] dipoles into the last pass, and its residual */
+    double **dg, **df;       /* [depth][n] differences of g and of the residual between passes */
+    double **normal;         /* [depth][depth] normal equations of the mixing coefficients */
+} polar_anderson_t;
+
+//static field of the frozen atoms tabulated for the mobile sites
+typedef struct _polar_field_grid {
+    int n[3];   /* grid points along each lattice vector */
+    double *ef; /* [3*point] field vector */
+} polar_field_grid_t;
+
 typedef struct _histogram {
     int ***grid;
     int x_dim, y_dim, z_dim;
@@ -255,7 +422,7 @@ typedef struct _message {
 
 typedef struct _checkpoint {
     int movetype, biased_move;
-    int thole_N_atom;  //used for keeping track of thole matrix size (allocated)
+    int thole_N_atom;  //polarizable sites in the thole matrices, see thole_resize_matrices()
     molecule_t *molecule_backup, *molecule_altered;
     molecule_t *head, *tail;
     observables_t *observables;
@@ -399,15 +566,48 @@ typedef struct _system {
     double ewald_alpha, polar_ewald_alpha;
     int ewald_alpha_set, polar_ewald_alpha_set;
     int ewald_kmax;
+    int ewald_lookup, ewald_lookup_density;
+    ewald_table_t *ewald_table;
+    kspace_t *kspace;
+    int ewald_sf_cache, ewald_sf_refresh;
+    ewald_sf_t *ewald_sf;
+    double ewald_precision;
+    int ewald_framework;
+    int spme, spme_order;
+    double spme_grid_spacing;
+    spme_t *spme_mesh;
     //thole options
     int polarization, polarvdw, polarizability_tensor;
     int cdvdw_exp_repulsion, cdvdw_sig_repulsion, cdvdw_9th_repulsion;
     int iter_success;  //flag set when iterative solver fails to converge (when polar_precision is used)
     int polar_iterative, polar_ewald, polar_ewald_full, polar_zodid, polar_palmo, polar_rrms;
+    int polar_gs_color;          /* sweep the gauss-seidel one graph color at a time, in parallel within each */
+    double polar_gs_color_cutoff; /* atoms closer than this get different colors */
+    polar_colors_t *polar_colors;
     int polar_gs, polar_gs_ranked, polar_sor, polar_esor, polar_max_iter, polar_wolf, polar_wolf_full, polar_wolf_alpha_lookup;
     double polar_wolf_alpha, polar_gamma, polar_damp, field_damp, polar_precision;
     int damp_type;
     double **A_matrix, **B_matrix, C_matrix[3][3]; /* A matrix, B matrix and polarizability tensor */
+    int A_max;                                     /* rows (and columns) allocated in A and B */
+    polar_sites_t *A_sites;                        /* the polarizable atoms that index the dense A */
+    int polar_sparse;                              /* keep A as sparse 3x3 blocks */
+    double polar_sparse_cutoff;                    /* pairs kept in the sparse A, pbc_cutoff if zero */
+    amatrix_sparse_t *A_sparse;
+    ldlt_t *A_ldlt;                                /* factored A of the matrix-inversion solver */
+    int polar_woodbury, polar_woodbury_refresh;    /* keep A^-1 between mc steps, full inversion every polar_woodbury_refresh updates */
+    woodbury_t *B_woodbury;
+    int polar_schur; /* eliminate the frozen dipoles through the schur complement of the A matrix */
+    schur_t *A_schur;
+    int polar_field_incremental, polar_field_refresh; /* keep the static field between mc steps, full sum every polar_field_refresh updates */
+    ef_static_cache_t *ef_static_cache;
+    int polar_field_grid; /* frozen atoms' static field interpolated from a grid */
+    double polar_field_grid_spacing;
+    polar_field_grid_t *pf_grid;
+    int polar_anderson, polar_anderson_depth; /* anderson mixing of the last polar_anderson_depth dipole passes */
+    polar_anderson_t *polar_anderson_history;
+    int polar_warm_start;                          /* start the dipole solvers from the last accepted dipoles */
+    int polar_pcg, polar_pcg_precond;              /* conjugate gradient dipole solver and its preconditioner */
+    double polar_pcg_tolerance;                    /* relative residual the conjugate gradient solver stops at */
     vdw_t *vdw_eiso_info;                          //keeps track of molecule vdw self energies
     double *polar_wolf_alpha_table, polar_wolf_alpha_lookup_cutoff;
     int polar_wolf_alpha_table_max;  //stores the total size of the array
@@ -453,10 +653,30 @@ typedef struct _system {
     double *fugacities;
     int fugacitiesCount;
 
+    //shared-memory threads for the pair and ewald sums
+    int threads;
+    double *thread_partial; /* partial sums of thread_sum(), one cache line per thread */
+    int max_thread_partial; /* threads it has room for */
+
     //atom array
-    int natoms;
+    int natoms, max_natoms;
     atom_t **atom_array;
     molecule_t **molecule_array;
+    //once on, only the molecules flagged dirty are updated, and the arrays only after an insert/remove
+    int track_dirty, arrays_dirty;
+
+    //verlet neighbor list
+    int neighbor_list, nlist_id, nlist_natoms;
+    double neighbor_skin, nlist_volume, nlist_lrc;
+
+    //incremental (delta) energy for single-molecule moves
+    int delta_energy, delta_energy_check;
+    double delta_energy_drift;
+
+    //precomputed framework energy grid
+    int framework_grid;
+    double framework_grid_spacing;
+    framework_grid_t *fw_grid;
 
     //replay option
     int calc_pressure;
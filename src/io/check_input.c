@@ -420,7 +420,7 @@ void polarization_options(system_t *system) {
             die(-1);
         }
 
-        if ((system->polar_precision == 0.0) && (system->polar_max_iter == 0)) {
+        if ((system->polar_precision == 0.0) && (system->polar_max_iter == 0) && !system->polar_pcg) {
             error(
                 "INPUT: must specify either polar_precision or polar_max_iter\n");
             die(-1);
@@ -434,7 +434,7 @@ void polarization_options(system_t *system) {
             sprintf(linebuf,
                     "INPUT: Thole iterative precision is %e A*sqrt(KA) (%e D)\n", system->polar_precision, system->polar_precision / DEBYE2SKA);
             output(linebuf);
-        } else {
+        } else if (system->polar_max_iter > 0) {
             sprintf(linebuf,
                     "INPUT: using polar max SCF iterations = %d\n", system->polar_max_iter);
             output(linebuf);
@@ -533,6 +533,512 @@ void polarization_options(system_t *system) {
     return;
 }
 
+void neighbor_list_options(system_t *system) {
+    char linebuf[MAXLINE];
+
+    if (system->ensemble == ENSEMBLE_SURF || system->ensemble == ENSEMBLE_SURF_FIT || system->ensemble == ENSEMBLE_TE) {
+        error(
+            "INPUT: neighbor_list requires a periodic ensemble\n");
+        die(-1);
+    }
+    if (system->neighbor_skin < 0) {
+        error(
+            "INPUT: neighbor_skin must be non-negative\n");
+        die(-1);
+    }
+
+    /* these terms are evaluated over every pair, regardless of the cutoff */
+    if (system->polarization || system->polarvdw || system->cuda) {
+        error(
+            "INPUT: neighbor_list is not compatible with polarization/polarvdw\n");
+        die(-1);
+    }
+    if (system->rd_anharmonic || system->sg || system->dreiding || system->lj_buffered_14_7 || system->disp_expansion || system->cdvdw_exp_repulsion || system->axilrod_teller) {
+        error(
+            "INPUT: neighbor_list is only implemented for the Lennard-Jones repulsion/dispersion potential\n");
+        die(-1);
+    }
+    if (system->rd_crystal || system->spectre || system->gwp) {
+        error(
+            "INPUT: neighbor_list is not compatible with rd_crystal, spectre or gwp\n");
+        die(-1);
+    }
+
+    sprintf(linebuf,
+            "INPUT: verlet neighbor list active with a skin of %.3f A\n", system->neighbor_skin);
+    output(linebuf);
+
+    return;
+}
+
+void delta_energy_options(system_t *system) {
+    char linebuf[MAXLINE];
+
+    if (system->ensemble != ENSEMBLE_UVT && system->ensemble != ENSEMBLE_NVT && system->ensemble != ENSEMBLE_NPT) {
+        error(
+            "INPUT: delta_energy is only implemented for the uVT, NVT and NPT ensembles\n");
+        die(-1);
+    }
+
+    /* many-body terms can't be split into the contribution of a single molecule */
+    if (system->polarization || system->polarvdw || system->cuda || system->axilrod_teller) {
+        error(
+            "INPUT: delta_energy is not compatible with polarization/polarvdw/axilrod_teller\n");
+        die(-1);
+    }
+    if (system->rd_anharmonic || system->sg || system->dreiding || system->lj_buffered_14_7 || system->disp_expansion || system->cdvdw_exp_repulsion) {
+        error(
+            "INPUT: delta_energy is only implemented for the Lennard-Jones repulsion/dispersion potential\n");
+        die(-1);
+    }
+    if (system->rd_crystal || system->spectre || system->gwp) {
+        error(
+            "INPUT: delta_energy is not compatible with rd_crystal, spectre or gwp\n");
+        die(-1);
+    }
+
+    /* the fourier sum of a move then only costs the moved atoms' terms, rather than a sum over every atom */
+    if (!(system->wolf || system->rd_only || system->spme) && !system->ewald_sf_cache) {
+        output(
+            "INPUT: delta_energy turns on ewald_sf_cache\n");
+        system->ewald_sf_cache = 1;
+    }
+
+    /* by default, check against the full energy every correlation time */
+    if (system->delta_energy_check < 0) {
+        error(
+            "INPUT: delta_energy_check must be non-negative\n");
+        die(-1);
+    } else if (!system->delta_energy_check)
+        system->delta_energy_check = system->corrtime;
+
+    sprintf(linebuf,
+            "INPUT: delta energy active, checking for drift every %d steps\n", system->delta_energy_check);
+    output(linebuf);
+
+    return;
+}
+
+void framework_grid_options(system_t *system) {
+    /* the grid is tabulated once, for a fixed cell */
+    if (system->ensemble != ENSEMBLE_UVT && system->ensemble != ENSEMBLE_NVT) {
+        error(
+            "INPUT: framework_grid is only implemented for the uVT and NVT ensembles\n");
+        die(-1);
+    }
+    if (system->framework_grid_spacing <= 0.0) {
+        error(
+            "INPUT: framework_grid_spacing must be positive\n");
+        die(-1);
+    }
+
+    /* many-body terms can't be tabulated per site */
+    if (system->polarization || system->polarvdw || system->cuda || system->axilrod_teller) {
+        error(
+            "INPUT: framework_grid is not compatible with polarization/polarvdw/axilrod_teller\n");
+        die(-1);
+    }
+    if (system->rd_anharmonic || system->sg || system->dreiding || system->lj_buffered_14_7 || system->disp_expansion || system->cdvdw_exp_repulsion) {
+        error(
+            "INPUT: framework_grid is only implemented for the Lennard-Jones repulsion/dispersion potential\n");
+        die(-1);
+    }
+    if (system->rd_crystal || system->spectre || system->gwp || system->cavity_autoreject_absolute) {
+        error(
+            "INPUT: framework_grid is not compatible with rd_crystal, spectre, gwp or cavity_autoreject_absolute\n");
+        die(-1);
+    }
+
+    /* the feynman-hibbs correction is tabulated at a single temperature */
+    if (system->feynman_hibbs && (system->simulated_annealing || system->parallel_tempering)) {
+        error(
+            "INPUT: framework_grid with feynman_hibbs requires a constant temperature\n");
+        die(-1);
+    }
+
+    return;
+}
+
+void ewald_lookup_options(system_t *system) {
+    if (system->ewald_lookup_density <= 0) {
+        error(
+            "INPUT: ewald_lookup_density must be positive\n");
+        die(-1);
+    }
+    if (system->wolf || system->spectre || system->gwp) {
+        output(
+            "INPUT: ewald_lookup only applies to the ewald real-space sum, ignoring\n");
+        system->ewald_lookup = 0;
+    }
+
+    return;
+}
+
+void ewald_sf_cache_options(system_t *system) {
+    char linebuf[MAXLINE];
+
+    if (system->ewald_sf_refresh <= 0) {
+        error(
+            "INPUT: ewald_sf_refresh must be positive\n");
+        die(-1);
+    }
+    if (system->wolf || system->spectre || system->gwp || system->sg || system->rd_only || system->spme) {
+        output(
+            "INPUT: ewald_sf_cache only applies to the ewald fourier sum, ignoring\n");
+        system->ewald_sf_cache = 0;
+        return;
+    }
+    if (system->quantum_rotation) {
+        output(
+            "INPUT: ewald_sf_cache is not used with quantum_rotation\n");
+        system->ewald_sf_cache = 0;
+        return;
+    }
+
+    sprintf(linebuf,
+            "INPUT: ewald structure factor cached between mc steps, recomputed every %d updates\n", system->ewald_sf_refresh);
+    output(linebuf);
+
+    return;
+}
+
+void polar_field_incremental_options(system_t *system) {
+    char linebuf[MAXLINE];
+
+    if (!system->polarization || system->polar_ewald || system->polar_ewald_full) {
+        output(
+            "INPUT: polar_field_incremental only applies to the polar_wolf and cutoff static fields, ignoring\n");
+        system->polar_field_incremental = 0;
+        return;
+    }
+    if (system->spectre) {
+        error(
+            "INPUT: polar_field_incremental cannot be used with spectre, which changes every charge\n");
+        die(-1);
+    }
+    if (system->polar_field_refresh <= 0) {
+        error(
+            "INPUT: polar_field_refresh must be positive\n");
+        die(-1);
+    }
+
+    sprintf(linebuf,
+            "INPUT: static field kept between mc steps, recomputed every %d updates\n", system->polar_field_refresh);
+    output(linebuf);
+
+    return;
+}
+
+void polar_field_grid_options(system_t *system) {
+    if (!system->polarization) {
+        output(
+            "INPUT: polar_field_grid requires polarization, ignoring\n");
+        system->polar_field_grid = 0;
+        return;
+    }
+    /* the plain cutoff field jumps at the cutoff, which the tricubic interpolation can't follow - */
+    /* the wolf field goes to zero there */
+    if (!(system->polar_wolf || system->polar_wolf_full)) {
+        error(
+            "INPUT: polar_field_grid requires the polar_wolf or polar_wolf_full static field\n");
+        die(-1);
+    }
+    /* the grid is tabulated once, for a fixed cell and fixed charges */
+    if (system->ensemble != ENSEMBLE_UVT && system->ensemble != ENSEMBLE_NVT) {
+        error(
+            "INPUT: polar_field_grid is only implemented for the uVT and NVT ensembles\n");
+        die(-1);
+    }
+    if (system->spectre) {
+        error(
+            "INPUT: polar_field_grid cannot be used with spectre, which changes every charge\n");
+        die(-1);
+    }
+    if (system->polar_field_grid_spacing <= 0.0) {
+        error(
+            "INPUT: polar_field_grid_spacing must be positive\n");
+        die(-1);
+    }
+
+    return;
+}
+
+void polar_woodbury_options(system_t *system) {
+    char linebuf[MAXLINE];
+
+    if (!system->polarization || system->polar_iterative || system->polar_ewald_full || system->cuda) {
+        output(
+            "INPUT: polar_woodbury only applies to the matrix inversion dipole solver, ignoring\n");
+        system->polar_woodbury = 0;
+        return;
+    }
+    if (system->polarizability_tensor || system->polarvdw) {
+        error(
+            "INPUT: polar_woodbury cannot be used with polarizability_tensor or polarvdw\n");
+        die(-1);
+    }
+    /* the inverse follows the moves made by mc() */
+    if (system->ensemble != ENSEMBLE_UVT && system->ensemble != ENSEMBLE_NVT && system->ensemble != ENSEMBLE_NVE && system->ensemble != ENSEMBLE_NPT) {
+        error(
+            "INPUT: polar_woodbury is only implemented for the uVT, NVT, NVE and NPT ensembles\n");
+        die(-1);
+    }
+    if (system->polar_woodbury_refresh <= 0) {
+        error(
+            "INPUT: polar_woodbury_refresh must be positive\n");
+        die(-1);
+    }
+
+    sprintf(linebuf,
+            "INPUT: inverse of the A matrix kept between mc steps, recomputed every %d updates\n", system->polar_woodbury_refresh);
+    output(linebuf);
+
+    return;
+}
+
+void polar_schur_options(system_t *system) {
+    if (!system->polarization || system->polar_iterative || system->polar_ewald_full || system->cuda) {
+        output(
+            "INPUT: polar_schur only applies to the matrix inversion dipole solver, ignoring\n");
+        system->polar_schur = 0;
+        return;
+    }
+    if (system->polar_woodbury || system->polarizability_tensor || system->polarvdw || system->polar_sparse) {
+        error(
+            "INPUT: polar_schur cannot be used with polar_woodbury, polar_sparse, polarizability_tensor or polarvdw\n");
+        die(-1);
+    }
+    /* the inverse of the frozen block is taken once, so the frozen atoms must stay put */
+    if (system->ensemble != ENSEMBLE_UVT && system->ensemble != ENSEMBLE_NVT && system->ensemble != ENSEMBLE_NVE) {
+        error(
+            "INPUT: polar_schur is only implemented for the uVT, NVT and NVE ensembles\n");
+        die(-1);
+    }
+
+    output(
+        "INPUT: frozen dipoles eliminated through the schur complement of the A matrix\n");
+
+    return;
+}
+
+void polar_anderson_options(system_t *system) {
+    char linebuf[MAXLINE];
+
+    if (!system->polarization || !(system->polar_iterative || system->polar_ewald_full) || system->polar_zodid || system->polar_pcg || system->cuda) {
+        output(
+            "INPUT: polar_anderson only applies to the iterative and ewald_full dipole solvers, ignoring\n");
+        system->polar_anderson = 0;
+        return;
+    }
+    if (system->polar_sor || system->polar_esor) {
+        error(
+            "INPUT: polar_anderson replaces polar_sor/polar_esor, use one or the other\n");
+        die(-1);
+    }
+    if ((system->polar_anderson_depth < 1) || (system->polar_anderson_depth > POLAR_ANDERSON_MAX_DEPTH)) {
+        sprintf(linebuf,
+                "INPUT: polar_anderson_depth must be between 1 and %d\n", POLAR_ANDERSON_MAX_DEPTH);
+        error(linebuf);
+        die(-1);
+    }
+
+    sprintf(linebuf,
+            "INPUT: anderson mixing of the last %d dipole iterations\n", system->polar_anderson_depth);
+    output(linebuf);
+
+    return;
+}
+
+void polar_gs_color_options(system_t *system) {
+    char linebuf[MAXLINE];
+
+    if (!system->polarization || !system->polar_iterative || !(system->polar_gs || system->polar_gs_ranked) || system->polar_ewald_full || system->polar_zodid || system->polar_pcg || system->cuda) {
+        output(
+            "INPUT: polar_gs_color only applies to the iterative solver with polar_gs or polar_gs_ranked, ignoring\n");
+        system->polar_gs_color = 0;
+        return;
+    }
+    if (system->polar_gs_color_cutoff <= 0.0) {
+        error(
+            "INPUT: polar_gs_color_cutoff must be positive\n");
+        die(-1);
+    }
+
+    sprintf(linebuf,
+            "INPUT: multicolor Gauss-Seidel, atoms within %.3f A of each other colored apart\n", system->polar_gs_color_cutoff);
+    output(linebuf);
+
+    return;
+}
+
+void polar_warm_start_options(system_t *system) {
+    if (!system->polarization || system->polar_zodid || system->cuda || !(system->polar_iterative || system->polar_ewald_full)) {
+        output(
+            "INPUT: polar_warm_start only applies to the iterative polarization solvers on the cpu, ignoring\n");
+        system->polar_warm_start = 0;
+        return;
+    }
+
+    output(
+        "INPUT: dipole solver starts from the dipoles of the last accepted configuration\n");
+
+    return;
+}
+
+void polar_pcg_options(system_t *system) {
+    char linebuf[MAXLINE];
+
+    if (!system->polarization) {
+        output(
+            "INPUT: polar_pcg only applies to polarization, ignoring\n");
+        system->polar_pcg = 0;
+        return;
+    }
+    if (system->cuda || system->polarvdw || system->polar_zodid || system->polar_ewald_full) {
+        error(
+            "INPUT: polar_pcg cannot be used with cuda, polarvdw, polar_zodid or polar_ewald_full\n");
+        die(-1);
+    }
+    if (system->polar_pcg_tolerance <= 0) {
+        error(
+            "INPUT: polar_pcg_tolerance must be positive\n");
+        die(-1);
+    }
+
+    sprintf(linebuf,
+            "INPUT: dipoles solved by conjugate gradient with %s preconditioner to a relative residual of %e\n",
+            (system->polar_pcg_precond == PCG_PRECOND_MOLECULE) ? "molecule block" : "atom", system->polar_pcg_tolerance);
+    output(linebuf);
+
+    return;
+}
+
+void polar_sparse_options(system_t *system) {
+    char linebuf[MAXLINE];
+
+    if (!system->polarization) {
+        output(
+            "INPUT: polar_sparse only applies to polarization, ignoring\n");
+        system->polar_sparse = 0;
+        return;
+    }
+    if (!system->polar_iterative || system->cuda || system->polarvdw) {
+        error(
+            "INPUT: polar_sparse requires the iterative solver, without cuda or polarvdw\n");
+        die(-1);
+    }
+    if (system->polar_sparse_cutoff < 0) {
+        error(
+            "INPUT: polar_sparse_cutoff must be positive\n");
+        die(-1);
+    }
+
+    if (system->polar_sparse_cutoff > 0)
+        sprintf(linebuf,
+                "INPUT: dipole field tensor stored as sparse 3x3 blocks for pairs within %.3f A\n", system->polar_sparse_cutoff);
+    else
+        sprintf(linebuf,
+                "INPUT: dipole field tensor stored as sparse 3x3 blocks for pairs within pbc_cutoff\n");
+    output(linebuf);
+
+    return;
+}
+
+void ewald_framework_options(system_t *system) {
+    if (system->wolf || system->spectre || system->gwp || system->sg || system->rd_only) {
+        output(
+            "INPUT: ewald_framework only applies to the ewald fourier sum, ignoring\n");
+        system->ewald_framework = 0;
+        return;
+    }
+
+    output(
+        "INPUT: frozen atoms enter the ewald fourier sum through a cached structure factor\n");
+
+    return;
+}
+
+void ewald_precision_options(system_t *system) {
+    char linebuf[MAXLINE];
+
+    if (system->ewald_precision < 0) {
+        error(
+            "INPUT: ewald_precision must be positive\n");
+        die(-1);
+    }
+    if (system->wolf || system->spectre || system->gwp || system->sg || system->rd_only) {
+        output(
+            "INPUT: ewald_precision only applies to the ewald sums, ignoring\n");
+        system->ewald_precision = 0;
+        return;
+    }
+    if (system->ensemble == ENSEMBLE_REPLAY) {
+        output(
+            "INPUT: ewald_precision is not used when replaying a trajectory\n");
+        system->ewald_precision = 0;
+        return;
+    }
+
+    sprintf(linebuf,
+            "INPUT: ewald parameters will be tuned for an error of %e relative to two unit charges 1 A apart\n", system->ewald_precision);
+    output(linebuf);
+
+    return;
+}
+
+void spme_options(system_t *system) {
+    char linebuf[MAXLINE];
+
+    if ((system->spme_order < 3) || (system->spme_order > SPME_MAX_ORDER)) {
+        sprintf(linebuf,
+                "INPUT: spme_order must be between 3 and %d\n", SPME_MAX_ORDER);
+        error(linebuf);
+        die(-1);
+    }
+    if (system->spme_grid_spacing <= 0) {
+        error(
+            "INPUT: spme_grid_spacing must be positive\n");
+        die(-1);
+    }
+    if (system->wolf || system->spectre || system->gwp || system->sg || system->rd_only) {
+        output(
+            "INPUT: spme only applies to the ewald fourier sum, ignoring\n");
+        system->spme = 0;
+        return;
+    }
+
+    sprintf(linebuf,
+            "INPUT: ewald fourier sum by smooth particle mesh ewald, b-spline order %d, mesh spacing <= %.3f A\n", system->spme_order, system->spme_grid_spacing);
+    output(linebuf);
+
+    return;
+}
+
+void threads_options(system_t *system) {
+    char linebuf[MAXLINE];
+
+    if (system->threads < 1) {
+        error(
+            "INPUT: threads must be positive\n");
+        die(-1);
+    }
+#ifndef _OPENMP
+    if (system->threads > 1) {
+        output(
+            "INPUT: threads requires a build with OpenMP, running serially\n");
+        system->threads = 1;
+    }
+#endif /* _OPENMP */
+
+    if (system->threads > 1) {
+        sprintf(linebuf,
+                "INPUT: pair and ewald sums split over %d threads\n", system->threads);
+        output(linebuf);
+    }
+
+    return;
+}
+
 void ensemble_te_options(system_t *system) {
     //nothing to do
 
@@ -1272,6 +1778,24 @@ int check_system(system_t *system) {
     if (system->simulated_annealing) simulated_annealing_options(system);
     if (system->calc_hist) hist_options(system);
     if (system->polarization) polarization_options(system);
+    if (system->neighbor_list) neighbor_list_options(system);
+    if (system->delta_energy) delta_energy_options(system);
+    if (system->framework_grid) framework_grid_options(system);
+    if (system->ewald_lookup) ewald_lookup_options(system);
+    if (system->polar_sparse) polar_sparse_options(system);
+    if (system->polar_pcg) polar_pcg_options(system);
+    if (system->polar_warm_start) polar_warm_start_options(system);
+    if (system->polar_field_incremental) polar_field_incremental_options(system);
+    if (system->polar_field_grid) polar_field_grid_options(system);
+    if (system->polar_woodbury) polar_woodbury_options(system);
+    if (system->polar_schur) polar_schur_options(system);
+    if (system->polar_anderson) polar_anderson_options(system);
+    if (system->polar_gs_color) polar_gs_color_options(system);
+    if (system->ewald_framework) ewald_framework_options(system);
+    if (system->ewald_precision != 0) ewald_precision_options(system);
+    if (system->spme) spme_options(system);
+    if (system->ewald_sf_cache) ewald_sf_cache_options(system);
+    threads_options(system);
 #ifdef QM_ROTATION
     if (system->quantum_rotation) qrot_options(system);
 #endif
@@ -790,6 +790,54 @@ int do_command(system_t *system, char **token) {
             return 1;
     }
 
+    // neighbor list options
+    else if (!strcasecmp(token[0],
+                         "neighbor_list")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->neighbor_list = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->neighbor_list = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "neighbor_skin")) {
+        if (safe_atof(token[1], &(system->neighbor_skin))) return 1;
+    }
+
+    // delta energy options
+    else if (!strcasecmp(token[0],
+                         "delta_energy")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->delta_energy = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->delta_energy = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "delta_energy_check")) {
+        if (safe_atoi(token[1], &(system->delta_energy_check))) return 1;
+    }
+
+    // framework grid options
+    else if (!strcasecmp(token[0],
+                         "framework_grid")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->framework_grid = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->framework_grid = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "framework_grid_spacing")) {
+        if (safe_atof(token[1], &(system->framework_grid_spacing))) return 1;
+    }
+
     // rd options
     else if (!strcasecmp(token[0],
                          "rd_lrc")) {
@@ -1044,6 +1092,74 @@ int do_command(system_t *system, char **token) {
         if (safe_atoi(token[1], &(system->ewald_kmax))) return 1;
     }
 
+    else if (!strcasecmp(token[0],
+                         "threads")) {
+        if (safe_atoi(token[1], &(system->threads))) return 1;
+    }
+
+    else if (!strcasecmp(token[0],
+                         "ewald_lookup")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->ewald_lookup = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->ewald_lookup = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "ewald_lookup_density")) {
+        if (safe_atoi(token[1], &(system->ewald_lookup_density))) return 1;
+    }
+
+    else if (!strcasecmp(token[0],
+                         "ewald_sf_cache")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->ewald_sf_cache = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->ewald_sf_cache = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "ewald_sf_refresh")) {
+        if (safe_atoi(token[1], &(system->ewald_sf_refresh))) return 1;
+    }
+
+    else if (!strcasecmp(token[0],
+                         "ewald_framework")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->ewald_framework = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->ewald_framework = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "ewald_precision")) {
+        if (safe_atof(token[1], &(system->ewald_precision))) return 1;
+    }
+
+    else if (!strcasecmp(token[0],
+                         "spme")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->spme = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->spme = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "spme_order")) {
+        if (safe_atoi(token[1], &(system->spme_order))) return 1;
+    } else if (!strcasecmp(token[0],
+                           "spme_grid_spacing")) {
+        if (safe_atof(token[1], &(system->spme_grid_spacing))) return 1;
+    }
+
     else if (!strcasecmp(token[0],
                          "pbc_cutoff")) {
         if (safe_atof(token[1], &(system->pbc->cutoff))) return 1;
@@ -1106,6 +1222,115 @@ int do_command(system_t *system, char **token) {
             system->polar_palmo = 0;
         else
             return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_sparse")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->polar_sparse = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->polar_sparse = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_sparse_cutoff")) {
+        if (safe_atof(token[1], &(system->polar_sparse_cutoff))) return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_field_incremental")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->polar_field_incremental = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->polar_field_incremental = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_field_refresh")) {
+        if (safe_atoi(token[1], &(system->polar_field_refresh))) return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_field_grid")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->polar_field_grid = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->polar_field_grid = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_field_grid_spacing")) {
+        if (safe_atof(token[1], &(system->polar_field_grid_spacing))) return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_woodbury")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->polar_woodbury = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->polar_woodbury = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_woodbury_refresh")) {
+        if (safe_atoi(token[1], &(system->polar_woodbury_refresh))) return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_schur")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->polar_schur = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->polar_schur = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_anderson")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->polar_anderson = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->polar_anderson = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_anderson_depth")) {
+        if (safe_atoi(token[1], &(system->polar_anderson_depth))) return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_warm_start")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->polar_warm_start = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->polar_warm_start = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_pcg")) {
+        if (!strcasecmp(token[1],
+                        "on")) {
+            system->polar_pcg = 1;
+            system->polar_iterative = 1;
+        } else if (!strcasecmp(token[1],
+                               "off"))
+            system->polar_pcg = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_pcg_precond")) {
+        if (!strcasecmp(token[1],
+                        "atom"))
+            system->polar_pcg_precond = PCG_PRECOND_ATOM;
+        else if (!strcasecmp(token[1],
+                             "molecule"))
+            system->polar_pcg_precond = PCG_PRECOND_MOLECULE;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_pcg_tolerance")) {
+        if (safe_atof(token[1], &(system->polar_pcg_tolerance))) return 1;
     } else if (!strcasecmp(token[0],
                            "polar_gs")) {
         if (!strcasecmp(token[1],
@@ -1126,6 +1351,19 @@ int do_command(system_t *system, char **token) {
             system->polar_gs_ranked = 0;
         else
             return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_gs_color")) {
+        if (!strcasecmp(token[1],
+                        "on"))
+            system->polar_gs_color = 1;
+        else if (!strcasecmp(token[1],
+                             "off"))
+            system->polar_gs_color = 0;
+        else
+            return 1;
+    } else if (!strcasecmp(token[0],
+                           "polar_gs_color_cutoff")) {
+        if (safe_atof(token[1], &(system->polar_gs_color_cutoff))) return 1;
     } else if (!strcasecmp(token[0],
                            "polar_sor")) {
         if (!strcasecmp(token[1],
@@ -1567,6 +1805,23 @@ void setdefaults(system_t *system) {
     /* default rd LRC flag */
     system->rd_lrc = 1;
 
+    /* serial unless asked otherwise */
+    system->threads = 1;
+
+    /* default verlet skin */
+    system->neighbor_skin = NEIGHBOR_SKIN;
+    system->framework_grid_spacing = FRAMEWORK_GRID_SPACING;
+    system->ewald_lookup_density = EWALD_LOOKUP_DENSITY;
+    system->ewald_sf_refresh = EWALD_SF_REFRESH;
+    system->polar_field_refresh = POLAR_FIELD_REFRESH;
+    system->polar_field_grid_spacing = POLAR_FIELD_GRID_SPACING;
+    system->polar_anderson_depth = POLAR_ANDERSON_DEPTH;
+    system->polar_woodbury_refresh = POLAR_WOODBURY_REFRESH;
+    system->polar_pcg_tolerance = POLAR_PCG_TOLERANCE;
+    system->polar_gs_color_cutoff = POLAR_GS_COLOR_CUTOFF;
+    system->spme_order = SPME_ORDER;
+    system->spme_grid_spacing = SPME_GRID_SPACING;
+
     // Initialize fit_input_list to reflect an empty list
     system->fit_input_list.next = 0;
     system->fit_input_list.data.count = 0;
@@ -1730,8 +1985,13 @@ system_t *setup_system(char *input_file) {
     output(
         "INPUT: finished allocating pair lists\n");
 
+    /* pick alpha and kmax now that the box and charges are known, before the grids tabulate the real-space sum */
+    if (system->ewald_precision > 0) ewald_tune(system);
+
     /* get all of the pairwise interactions, exclusions, etc. */
     if (system->cavity_bias) setup_cavity_grid(system);
+    if (system->framework_grid) setup_framework_grid(system);
+    if (system->polar_field_grid) setup_polar_field_grid(system);
     pairs(system);
 
     /* set all pairs to initially have their energies calculated */
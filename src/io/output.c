@@ -138,57 +138,61 @@ int open_surf_traj_file(system_t *system) {
     return (0);
 }
 
-/* enforce molecule wrapping around the periodic boundaries on output - keep the atoms together */
-int wrapall(molecule_t *molecules, pbc_t *pbc) {
+/* wrap a single molecule around the periodic boundaries - keep the atoms together */
+void wrap_molecule(molecule_t *molecule_ptr, pbc_t *pbc) {
     int i, j;
-    molecule_t *molecule_ptr;
     atom_t *atom_ptr;
     double d[3], dimg[3];
 
-    for (molecule_ptr = molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
-        if (!molecule_ptr->frozen) {
-            /* get the minimum imaging distance for the com */
+    if (!molecule_ptr->frozen) {
+        /* get the minimum imaging distance for the com */
+        for (i = 0; i < 3; i++) {
+            for (j = 0, d[i] = 0; j < 3; j++) {
+                d[i] += pbc->reciprocal_basis[j][i] * molecule_ptr->com[j];
+            }
+            d[i] = rint(d[i]);
+        }
+
+        for (i = 0; i < 3; i++) {
+            for (j = 0, dimg[i] = 0; j < 3; j++)
+                dimg[i] += pbc->basis[j][i] * d[j];
+
+            /* store the wrapped com coordinate */
+            molecule_ptr->wrapped_com[i] = dimg[i];
+        }
+
+        /* apply the distance to all of the atoms of this molecule */
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
+            for (i = 0; i < 3; i++)
+                atom_ptr->wrapped_pos[i] = atom_ptr->pos[i] - dimg[i];
+        }
+
+    } else {
+        /* wrap all atoms of frozen molecules into the box */
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
             for (i = 0; i < 3; i++) {
                 for (j = 0, d[i] = 0; j < 3; j++) {
-                    d[i] += pbc->reciprocal_basis[j][i] * molecule_ptr->com[j];
+                    d[i] += pbc->reciprocal_basis[j][i] * atom_ptr->pos[j];
                 }
                 d[i] = rint(d[i]);
             }
 
-            for (i = 0; i < 3; i++) {
+            for (i = 0; i < 3; i++)
                 for (j = 0, dimg[i] = 0; j < 3; j++)
                     dimg[i] += pbc->basis[j][i] * d[j];
 
-                /* store the wrapped com coordinate */
-                molecule_ptr->wrapped_com[i] = dimg[i];
-            }
-
-            /* apply the distance to all of the atoms of this molecule */
-            for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-                for (i = 0; i < 3; i++)
-                    atom_ptr->wrapped_pos[i] = atom_ptr->pos[i] - dimg[i];
-            }
-
-        } else {
-            /* wrap all atoms of frozen molecules into the box */
-            for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-                for (i = 0; i < 3; i++) {
-                    for (j = 0, d[i] = 0; j < 3; j++) {
-                        d[i] += pbc->reciprocal_basis[j][i] * atom_ptr->pos[j];
-                    }
-                    d[i] = rint(d[i]);
-                }
-
-                for (i = 0; i < 3; i++)
-                    for (j = 0, dimg[i] = 0; j < 3; j++)
-                        dimg[i] += pbc->basis[j][i] * d[j];
-
-                for (i = 0; i < 3; i++)
-                    atom_ptr->wrapped_pos[i] = atom_ptr->pos[i] - dimg[i];
-            }
+            for (i = 0; i < 3; i++)
+                atom_ptr->wrapped_pos[i] = atom_ptr->pos[i] - dimg[i];
         }
+    }
+}
+
+/* enforce molecule wrapping around the periodic boundaries on output - keep the atoms together */
+int wrapall(molecule_t *molecules, pbc_t *pbc) {
+    molecule_t *molecule_ptr;
 
-    } /* molecule */
+    for (molecule_ptr = molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        wrap_molecule(molecule_ptr, pbc);
 
     return (0);
 }
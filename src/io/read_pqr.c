@@ -727,7 +727,7 @@ void test_list(molecule_t *molecules) {
                 "DEBUG_LIST: atomtype = %s x = %f y = %f z = %f\n", atom_ptr->atomtype, atom_ptr->pos[0], atom_ptr->pos[1], atom_ptr->pos[2]);
             printf(
                 "DEBUG_LIST: atom frozen = %d mass = %f, charge = %f, alpha = %f, eps = %f, sig = %f\n", atom_ptr->frozen, atom_ptr->mass, atom_ptr->charge, atom_ptr->polarizability, atom_ptr->epsilon, atom_ptr->sigma);
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next)
+            for (pair_ptr = atom_ptr->pairs; pair_ptr < atom_ptr->pairs + atom_ptr->npairs; pair_ptr++)
                 if (!(pair_ptr->rd_excluded || pair_ptr->es_excluded || pair_ptr->frozen)) printf(
                     "DEBUG_LIST: pair = 0x%lx eps = %f sig = %f\n",
                     (long unsigned int)pair_ptr, pair_ptr->epsilon, pair_ptr->sigma);
@@ -754,7 +754,7 @@ void test_molecule(molecule_t *molecule) {
             "atomtype = %s x = %f y = %f z = %f\n", atom_ptr->atomtype, atom_ptr->pos[0], atom_ptr->pos[1], atom_ptr->pos[2]);
         printf(
             "atom frozen = %d mass = %f, charge = %f, alpha = %f, eps = %f, sig = %f\n", atom_ptr->frozen, atom_ptr->mass, atom_ptr->charge, atom_ptr->polarizability, atom_ptr->epsilon, atom_ptr->sigma);
-        for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
+        for (pair_ptr = atom_ptr->pairs; pair_ptr < atom_ptr->pairs + atom_ptr->npairs; pair_ptr++) {
             printf(
                 "pair at 0x%lx\n", (long unsigned int)pair_ptr);
             fflush(stdout);
@@ -9,30 +9,11 @@ University of South Florida
 #include <mc.h>
 
 void free_my_pairs(molecule_t *molecule) {
-    int i = 0;
-    pair_t **ptr_array = NULL;
     atom_t *aptr;
-    pair_t *pptr;
-
-    //build an array of pairs
-    for (aptr = molecule->atoms; aptr; aptr = aptr->next) {
-        for (pptr = aptr->pairs; pptr; pptr = pptr->next) {
-            ptr_array = realloc(ptr_array, sizeof(pair_t *) * (i + 1));
-            memnullcheck(ptr_array, sizeof(pair_t *) * (i + 1), __LINE__ - 1, __FILE__);
-            ptr_array[i] = pptr;
-            ++i;
-        }
-    }
 
-    //free the pairs
-    for (--i; i >= 0; i--) free(ptr_array[i]);
-
-    //zero out the heads
+    //each atom owns a single contiguous block of pairs
     for (aptr = molecule->atoms; aptr; aptr = aptr->next)
-        aptr->pairs = NULL;
-
-    //free the temp array
-    free(ptr_array);
+        resize_pairs(aptr, 0);
 
     return;
 }
@@ -81,30 +62,10 @@ void free_molecule(system_t *system, molecule_t *molecule) {
 
 // free all pairs
 void free_all_pairs(system_t *system) {
-    int i, j;
-    pair_t *pair_ptr;
-    pair_t **ptr_array = NULL;
-
-    j = 0;  //pair array index
-    //build an array of all pair pointers
-    for (i = 0; i < system->natoms; i++) {
-        for (pair_ptr = system->atom_array[i]->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
-            ptr_array = realloc(ptr_array, sizeof(pair_t *) * (j + 1));
-            memnullcheck(ptr_array, sizeof(pair_t *) * (j + 1), __LINE__ - 1, __FILE__);
-            ptr_array[j] = pair_ptr;
-            j++;
-        }
-    }
-
-    /* free the whole array of ptrs */
-    while (j--) free(ptr_array[j]);
+    int i;
 
-    /* zero out the heads */
     for (i = 0; i < system->natoms; i++)
-        system->atom_array[i]->pairs = NULL;
-
-    /* free our temporary array */
-    if (ptr_array) free(ptr_array);
+        resize_pairs(system->atom_array[i], 0);
 }
 
 // free all molecules
@@ -135,17 +96,20 @@ void free_all_molecules(molecule_t *molecules) {
 void free_matrices(system_t *system) {
     int i, N;
 
+    if (system->A_sites) {
+        free(system->A_sites->site);
+        free(system->A_sites);
+        system->A_sites = NULL;
+    }
+
     if (!system->A_matrix && !system->B_matrix)
         return;  //nothing to do
 
-    if (system->checkpoint->thole_N_atom)
-        N = 3 * system->checkpoint->thole_N_atom;
-    else
-        N = 3 * system->natoms;
+    N = system->A_max;
 
     for (i = 0; i < N; i++) {
         free(system->A_matrix[i]);
-        if (!system->polar_iterative)
+        if (!system->polar_iterative && system->polarizability_tensor)
             free(system->B_matrix[i]);
     }
 
@@ -168,6 +132,85 @@ void free_cavity_grid(system_t *system) {
     free(system->cavity_grid);
 }
 
+/* free the tabulated framework potential */
+void free_framework_grid(system_t *system) {
+    framework_grid_t *grid = system->fw_grid;
+    int t;
+
+    for (t = 0; t < grid->ntypes; t++) {
+        free(grid->rd[t]);
+        if (!grid->shared_es || !t) free(grid->es[t]);
+    }
+    free(grid->rd);
+    free(grid->es);
+    free(grid->lrc);
+    free(grid->sites);
+    free(grid->site_molecules);
+    free(grid);
+}
+
+void free_polar_field_grid(system_t *system) {
+    free(system->pf_grid->ef);
+    free(system->pf_grid);
+}
+
+void free_polar_anderson(system_t *system) {
+    polar_anderson_t *h = system->polar_anderson_history;
+    int k;
+
+    for (k = 0; k < system->polar_anderson_depth; k++) {
+        free(h->dg[k]);
+        free(h->df[k]);
+        free(h->normal[k]);
+    }
+    free(h->dg);
+    free(h->df);
+    free(h->normal);
+    free(h->x);
+    free(h);
+}
+
+void free_woodbury(system_t *system) {
+    free(system->B_woodbury->B);
+    free(system->B_woodbury->B_trial);
+    free(system->B_woodbury->A);
+    free(system->B_woodbury);
+}
+
+void free_schur(system_t *system) {
+    schur_t *sc = system->A_schur;
+    int i;
+
+    for (i = 0; i < sc->nf; i++) free(sc->Finv[i]);
+    free(sc->Finv);
+    for (i = 0; i < sc->max_ns; i++) {
+        free(sc->sigma[i]);
+        free(sc->sigma_trial[i]);
+    }
+    free(sc->sigma);
+    free(sc->sigma_trial);
+    free(sc->c);
+    free(sc->g);
+    free(sc->c_trial);
+    free(sc->g_trial);
+    free(sc->b);
+    free(sc->gf);
+    free(sc->frozen);
+    if (sc->factor) {
+        free(sc->factor->a);
+        free(sc->factor->w);
+        free(sc->factor->ipiv);
+        free(sc->factor);
+    }
+    free(sc);
+}
+
+void free_polar_colors(system_t *system) {
+    free(system->polar_colors->color);
+    free(system->polar_colors->pos);
+    free(system->polar_colors);
+}
+
 #ifdef QM_ROTATION
 /* free structures associated with quantum rotations */
 void free_rotational(system_t *system) {
@@ -218,6 +261,54 @@ void cleanup(system_t *system) {
 #endif /* QM_ROTATION */
     if (system->polarization && !system->cuda) free_matrices(system);
 
+    free(system->thread_partial);
+
+    if (system->ewald_table) {
+        free(system->ewald_table->values);
+        free(system->ewald_table);
+    }
+    if (system->kspace) {
+        free(system->kspace->l);
+        free(system->kspace->k);
+        free(system->kspace->weight);
+        free(system->kspace->polar_weight);
+        free(system->kspace->frozen_re);
+        free(system->kspace->frozen_im);
+        free(system->kspace->atoms);
+        free(system->kspace->eikr);
+        free(system->kspace->moved_q);
+        free(system->kspace->moved_eikr);
+        free(system->kspace);
+    }
+    if (system->A_sparse) {
+        free(system->A_sparse->row);
+        free(system->A_sparse->col);
+        free(system->A_sparse->block);
+        free(system->A_sparse->diag);
+        free(system->A_sparse->next);
+        free(system->A_sparse);
+    }
+    if (system->A_ldlt) {
+        free(system->A_ldlt->a);
+        free(system->A_ldlt->w);
+        free(system->A_ldlt->ipiv);
+        free(system->A_ldlt);
+    }
+    if (system->spme_mesh) {
+        free(system->spme_mesh->influence);
+        free(system->spme_mesh->grid);
+        free(system->spme_mesh->old_grid);
+        free(system->spme_mesh->frozen_grid);
+        free(system->spme_mesh);
+    }
+    if (system->ewald_sf) {
+        free(system->ewald_sf->re);
+        free(system->ewald_sf->im);
+        free(system->ewald_sf->old_re);
+        free(system->ewald_sf->old_im);
+        free(system->ewald_sf);
+    }
+    free(system->ef_static_cache);
     if (system->polar_wolf_alpha_lookup)
         if (system->polar_wolf_alpha_table)
             free(system->polar_wolf_alpha_table);
@@ -246,6 +337,12 @@ void cleanup(system_t *system) {
     if (system->frozen_output) free(system->frozen_output);
     if (system->surf_preserve_rotation_on) free(system->surf_preserve_rotation_on);
     if (system->cavity_bias) free_cavity_grid(system);
+    if (system->framework_grid) free_framework_grid(system);
+    if (system->polar_field_grid) free_polar_field_grid(system);
+    if (system->polar_anderson_history) free_polar_anderson(system);
+    if (system->B_woodbury) free_woodbury(system);
+    if (system->A_schur) free_schur(system);
+    if (system->polar_colors) free_polar_colors(system);
 
     if (system->surf_do_not_fit_list != NULL) {
         for (i = 0; i < 20; i++)
@@ -0,0 +1,58 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* sum kernel(system, i, arg, &sum) over i = 0 .. n-1, using system->threads threads */
+/* thread t takes i = t, t + nthreads, ... and the partial sums are added in thread order, */
+/* so the result depends only on the number of threads - with one thread it is the plain serial loop */
+double thread_sum(system_t *system, int n, void (*kernel)(system_t *, int, void *, double *), void *arg) {
+    double sum = 0;
+    int i;
+#ifdef _OPENMP
+    int t, nthreads;
+    double *partial;
+
+    nthreads = system->threads;
+    /* a call from inside a kernel would run serially anyway, and must not touch the outer partial sums */
+    if (nthreads > 1 && n > 1 && !omp_in_parallel()) {
+        /* keep each thread's partial sum on its own cache line - the buffer is kept between calls */
+        if (nthreads > system->max_thread_partial) {
+            free(system->thread_partial);
+            system->thread_partial = malloc(nthreads * THREAD_PAD * sizeof(double));
+            memnullcheck(system->thread_partial, nthreads * THREAD_PAD * sizeof(double), __LINE__ - 1, __FILE__);
+            system->max_thread_partial = nthreads;
+        }
+        partial = system->thread_partial;
+        for (t = 0; t < nthreads; t++) partial[t * THREAD_PAD] = 0;
+
+#pragma omp parallel num_threads(nthreads) private(i)
+        {
+            int tid = omp_get_thread_num();
+            int nth = omp_get_num_threads();
+
+            for (i = tid; i < n; i += nth)
+                kernel(system, i, arg, &partial[tid * THREAD_PAD]);
+        }
+
+        for (t = 0; t < nthreads; t++)
+            sum += partial[t * THREAD_PAD];
+
+        return (sum);
+    }
+#endif /* _OPENMP */
+
+    for (i = 0; i < n; i++)
+        kernel(system, i, arg, &sum);
+
+    return (sum);
+}
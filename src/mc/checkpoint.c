@@ -15,6 +15,15 @@ void checkpoint(system_t *system) {
     /* save the current observables */
     memcpy(system->checkpoint->observables, system->observables, sizeof(observables_t));
 
+    /* the cached structure factor now belongs to the accepted configuration */
+    if (system->ewald_sf) ewald_sf_accept(system);
+    /* and so does the static field */
+    if (system->ef_static_cache) thole_field_accept(system);
+    /* and the inverted A matrix */
+    if (system->B_woodbury) thole_woodbury_accept(system);
+    /* and the schur complement */
+    if (system->A_schur) thole_schur_accept(system);
+
     /* count exchangeable and adiabatic molecules */
     num_molecules_exchange = 0;
     num_molecules_adiabatic = 0;
@@ -34,12 +34,12 @@ This result was verified via ideal gas (non-interacting system). See tools/ideal
 #endif
 
 /* the prime quantity of interest */
-void boltzmann_factor(system_t *system, double initial_energy, double final_energy, double rot_partfunc) {
-    double delta_energy;
+void boltzmann_factor(system_t *system, double initial_energy, double delta_energy, double rot_partfunc) {
+    double final_energy;
     double v_new, v_old;
     double fugacity;
 
-    delta_energy = final_energy - initial_energy;
+    final_energy = initial_energy + delta_energy;
 
     switch (system->ensemble) {
         case ENSEMBLE_UVT:
@@ -192,10 +192,47 @@ void register_reject(system_t *system) {
     }
 }
 
+/* can the energy change of this move be had from the altered molecule alone? */
+int delta_energy_move(system_t *system, double initial_energy) {
+    if (!system->delta_energy) return 0;
+    /* nothing to build on if the last state was a bad contact */
+    if (initial_energy >= MAXVALUE) return 0;
+
+    switch (system->checkpoint->movetype) {
+        case MOVETYPE_INSERT:
+        case MOVETYPE_REMOVE:
+        case MOVETYPE_DISPLACE:
+        case MOVETYPE_ADIABATIC:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* recompute the full energy and compare it against the accumulated deltas */
+void check_delta_energy(system_t *system) {
+    double delta_sum, full, drift;
+    char linebuf[MAXLINE];
+
+    delta_sum = system->observables->energy;
+    full = energy(system);
+    drift = fabs(full - delta_sum);
+    if (drift > system->delta_energy_drift) system->delta_energy_drift = drift;
+
+    if (drift > DELTA_ENERGY_TOLERANCE * (1.0 + fabs(full))) {
+        sprintf(linebuf,
+                "MC: delta energy drifted by %.6e K from the full energy at step %d\n", full - delta_sum, system->step);
+        output(linebuf);
+    }
+
+    /* the full energy is now the one to restore upon rejection */
+    memcpy(system->checkpoint->observables, system->observables, sizeof(observables_t));
+}
+
 /* implements the Markov chain */
 int mc(system_t *system) {
     int j, msgsize;
-    double initial_energy, final_energy, current_energy;
+    double initial_energy, final_energy, current_energy, delta_energy;
     double rot_partfunc;
     observables_t *observables_mpi;
     avg_nodestats_t *avg_nodestats_mpi;
@@ -247,6 +284,9 @@ int mc(system_t *system) {
     /* set volume observable */
     system->observables->volume = system->pbc->volume;
 
+    /* the moves below flag the molecules they alter, except for the rotational levels which move them freely */
+    if (!system->quantum_rotation) start_dirty_tracking(system);
+
     /* get the initial energy of the system */
     initial_energy = energy(system);
 
@@ -288,6 +328,7 @@ int mc(system_t *system) {
     }
 
     /* save the initial state */
+    if (system->polar_warm_start) polar_warm_start_accept(system);
     checkpoint(system);
 
     /* main MC loop */
@@ -299,7 +340,13 @@ int mc(system_t *system) {
         make_move(system);
 
         /* calculate the energy change */
-        final_energy = energy(system);
+        if (delta_energy_move(system, initial_energy)) {
+            delta_energy = energy_delta(system);
+            final_energy = system->observables->energy;
+        } else {
+            final_energy = energy(system);
+            delta_energy = final_energy - initial_energy;
+        }
 
 #ifdef QM_ROTATION
         /* solve for the rotational energy levels */
@@ -316,7 +363,7 @@ int mc(system_t *system) {
             system->observables->energy = MAXVALUE;
             system->nodestats->boltzmann_factor = 0;
         } else
-            boltzmann_factor(system, initial_energy, final_energy, rot_partfunc);
+            boltzmann_factor(system, initial_energy, delta_energy, rot_partfunc);
 
         /* Metropolis function */
         if ((get_rand(system) < system->nodestats->boltzmann_factor) && (system->iter_success == 0)) {
@@ -325,6 +372,7 @@ int mc(system_t *system) {
             current_energy = final_energy;
 
             /* checkpoint */
+            if (system->polar_warm_start) polar_warm_start_accept(system);
             checkpoint(system);
             register_accept(system);
 
@@ -352,6 +400,12 @@ int mc(system_t *system) {
 
         }  // END REJECT
 
+        /* keep the accumulated energy honest */
+        if (system->delta_energy && !(system->step % system->delta_energy_check)) {
+            check_delta_energy(system);
+            current_energy = system->observables->energy;
+        }
+
         // perform parallel_tempering
         if ((system->parallel_tempering) && (system->step % system->ptemp_freq == 0))
             temper_system(system, current_energy);
@@ -520,6 +574,9 @@ int mc(system_t *system) {
 
     printf(
         "MC: Total auto-rejected moves: %i\n", system->count_autorejects);
+    if (system->delta_energy)
+        printf(
+            "MC: Largest delta energy drift: %.6e K\n", system->delta_energy_drift);
 
     return (0);
 }
@@ -193,6 +193,7 @@ void volume_change(system_t *system) {
 
     //scale molecule positions
     for (m = system->molecules; m; m = m->next) {
+        m->dirty = 1;
         for (i = 0; i < 3; i++) {
             old_com[i] = m->com[i];  //molecule ptr's com will be udated during pairs routine
             new_com[i] = m->com[i] * basis_scale_factor;
@@ -230,6 +231,7 @@ void revert_volume_change(system_t *system) {
 
     //scale molecule positions
     for (m = system->molecules; m; m = m->next) {
+        m->dirty = 1;
         for (i = 0; i < 3; i++) {
             old_com[i] = m->com[i];  //molecule ptr's com will ned to be updated since this is a revert (no energy call following)
             new_com[i] = m->com[i] * basis_scale_factor;
@@ -251,7 +253,8 @@ void revert_volume_change(system_t *system) {
 molecule_t *copy_molecule(system_t *system, molecule_t *src) {
     molecule_t *dst;
     atom_t *atom_dst_ptr, *prev_atom_dst_ptr, *atom_src_ptr;
-    pair_t *pair_dst_ptr, *prev_pair_dst_ptr, *pair_src_ptr;
+    pair_t *pair_dst_ptr, *pair_src_ptr;
+    int npairs;
 
     /* allocate the start of the new lists */
     dst = calloc(1, sizeof(molecule_t));
@@ -270,6 +273,7 @@ molecule_t *copy_molecule(system_t *system, molecule_t *src) {
     dst->rot_partfunc = src->rot_partfunc;
     memcpy(dst->com, src->com, 3 * sizeof(double));
     memcpy(dst->wrapped_com, src->wrapped_com, 3 * sizeof(double));
+    dst->dirty = src->dirty;
 
 #ifdef QM_ROTATION
     int i, j;
@@ -331,16 +335,15 @@ molecule_t *copy_molecule(system_t *system, molecule_t *src) {
         memcpy(atom_dst_ptr->mu, atom_src_ptr->mu, 3 * sizeof(double));
         memcpy(atom_dst_ptr->old_mu, atom_src_ptr->old_mu, 3 * sizeof(double));
         memcpy(atom_dst_ptr->new_mu, atom_src_ptr->new_mu, 3 * sizeof(double));
-
-        atom_dst_ptr->pairs = calloc(1, sizeof(pair_t));
-        memnullcheck(atom_dst_ptr->pairs, sizeof(pair_t), __LINE__ - 1, __FILE__);
-        pair_dst_ptr = atom_dst_ptr->pairs;
-        prev_pair_dst_ptr = pair_dst_ptr;
-        for (pair_src_ptr = atom_src_ptr->pairs; pair_src_ptr; pair_src_ptr = pair_src_ptr->next) {
-            pair_dst_ptr->rd_energy = pair_src_ptr->rd_energy;
-            pair_dst_ptr->es_real_energy = pair_src_ptr->es_real_energy;
-            pair_dst_ptr->es_self_intra_energy = pair_src_ptr->es_self_intra_energy;
-
+        memcpy(atom_dst_ptr->mu_last, atom_src_ptr->mu_last, 3 * sizeof(double));
+        memcpy(atom_dst_ptr->ef_static_last, atom_src_ptr->ef_static_last, 3 * sizeof(double));
+        memcpy(atom_dst_ptr->nlist_pos, atom_src_ptr->nlist_pos, 3 * sizeof(double));
+        atom_dst_ptr->nlist_id = atom_src_ptr->nlist_id;
+
+        /* copy the pair block */
+        npairs = atom_src_ptr->npairs;
+        resize_pairs(atom_dst_ptr, npairs);
+        for (pair_src_ptr = atom_src_ptr->pairs, pair_dst_ptr = atom_dst_ptr->pairs; pair_src_ptr < atom_src_ptr->pairs + npairs; pair_src_ptr++, pair_dst_ptr++) {
             pair_dst_ptr->frozen = pair_src_ptr->frozen;
             pair_dst_ptr->rd_excluded = pair_src_ptr->rd_excluded;
             pair_dst_ptr->es_excluded = pair_src_ptr->es_excluded;
@@ -348,20 +351,22 @@ molecule_t *copy_molecule(system_t *system, molecule_t *src) {
             //			pair_dst_ptr->gwp_alpha = pair_src_ptr->gwp_alpha;
             //			pair_dst_ptr->gwp_spin = pair_src_ptr->gwp_spin;
             pair_dst_ptr->epsilon = pair_src_ptr->epsilon;
-            pair_dst_ptr->lrc = pair_src_ptr->lrc;
             pair_dst_ptr->sigma = pair_src_ptr->sigma;
-            pair_dst_ptr->r = pair_src_ptr->r;
-            pair_dst_ptr->rimg = pair_src_ptr->rimg;
-
-            pair_dst_ptr->next = calloc(1, sizeof(pair_t));
-            memnullcheck(pair_dst_ptr->next, sizeof(pair_t), __LINE__ - 1, __FILE__);
-            prev_pair_dst_ptr = pair_dst_ptr;
-            pair_dst_ptr = pair_dst_ptr->next;
+            pair_dst_ptr->atom_index = pair_src_ptr->atom_index;
+            pair_dst_ptr->nlist_id = pair_src_ptr->nlist_id;
+        }
+        if (npairs) {
+            memcpy(atom_dst_ptr->pair_rd_energy, atom_src_ptr->pair_rd_energy, npairs * sizeof(double));
+            memcpy(atom_dst_ptr->pair_es_real_energy, atom_src_ptr->pair_es_real_energy, npairs * sizeof(double));
+            memcpy(atom_dst_ptr->pair_es_self_intra_energy, atom_src_ptr->pair_es_self_intra_energy, npairs * sizeof(double));
+            memcpy(atom_dst_ptr->pair_lrc, atom_src_ptr->pair_lrc, npairs * sizeof(double));
+            memcpy(atom_dst_ptr->pair_r, atom_src_ptr->pair_r, npairs * sizeof(double));
+            memcpy(atom_dst_ptr->pair_rimg, atom_src_ptr->pair_rimg, npairs * sizeof(double));
+
+            /* the neighbor list holds pair indices, so it carries over as is */
+            memcpy(atom_dst_ptr->neighbors, atom_src_ptr->neighbors, atom_src_ptr->nneighbors * sizeof(int));
+            atom_dst_ptr->nneighbors = atom_src_ptr->nneighbors;
         }
-        prev_pair_dst_ptr->next = NULL;
-        free(pair_dst_ptr);
-        /* handle an empty list */
-        if (!atom_src_ptr->pairs) atom_dst_ptr->pairs = NULL;
 
         prev_atom_dst_ptr = atom_dst_ptr;
         atom_dst_ptr->next = calloc(1, sizeof(atom_t));
@@ -571,9 +576,16 @@ void make_move(system_t *system) {
     cavity_t *cavities_array;
     int cavities_array_counter, random_index;
     double com[3], rand[3];
-    molecule_t *molecule_ptr;
     atom_t *atom_ptr;
-    pair_t *pair_ptr;
+
+    /* the cached structure factor has this move to catch up on */
+    if (system->ewald_sf) ewald_sf_move(system);
+    /* and so does the static field */
+    if (system->ef_static_cache) thole_field_move(system);
+    /* and the inverted A matrix */
+    if (system->B_woodbury) thole_woodbury_move(system);
+    /* and the schur complement of the frozen dipoles */
+    if (system->A_schur) thole_schur_move(system);
 
     /* update the cavity grid prior to making a move */
     if (system->cavity_bias) {
@@ -623,6 +635,11 @@ void make_move(system_t *system) {
                 /* move the molecule back to the origin and then assign it to com */
                 for (p = 0; p < 3; p++)
                     atom_ptr->pos[p] += com[p] - system->checkpoint->molecule_backup->com[p];
+                /* the copy carries the warm start of the molecule it was taken from - it has no accepted dipoles of its own */
+                for (p = 0; p < 3; p++) {
+                    atom_ptr->mu_last[p] = 0;
+                    atom_ptr->ef_static_last[p] = 0;
+                }
             }
 
             /* update the molecular com */
@@ -649,20 +666,11 @@ void make_move(system_t *system) {
             system->checkpoint->molecule_altered = system->checkpoint->molecule_backup;
             system->checkpoint->tail = system->checkpoint->molecule_altered->next;
             system->checkpoint->molecule_backup = NULL;
+            system->checkpoint->molecule_altered->dirty = 1;
+            system->arrays_dirty = 1;
 
             if (system->num_insertion_molecules) {  //multi sorbate
-                // Free all pair memory in the list
-                for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
-                    for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-                        pair_ptr = atom_ptr->pairs;
-                        while (pair_ptr) {
-                            pair_t *temp = pair_ptr;
-                            pair_ptr = pair_ptr->next;
-                            free(temp);
-                        }
-                    }
-                }
-                // Generate new pairs lists for all atoms in system
+                // Generate new pairs lists for all atoms in system, reusing the existing pair blocks
                 setup_pairs(system);
             }  // only one sorbate
             else
@@ -692,6 +700,7 @@ void make_move(system_t *system) {
             free_molecule(system, system->checkpoint->molecule_altered);
             system->checkpoint->molecule_altered = NULL; /* Insurance against memory errors */
             update_pairs_remove(system);
+            system->arrays_dirty = 1;
 
             //reset atom and molecule id's
             enumerate_particles(system);
@@ -700,6 +709,7 @@ void make_move(system_t *system) {
         case MOVETYPE_DISPLACE:
 
             /* change coords of 'altered' */
+            system->checkpoint->molecule_altered->dirty = 1;
             if (system->rd_anharmonic)
                 displace_1D(system, system->checkpoint->molecule_altered, system->move_factor);
             else if (system->spectre)
@@ -717,6 +727,7 @@ void make_move(system_t *system) {
             break;
         case MOVETYPE_ADIABATIC:
             /* change coords of 'altered' */
+            system->checkpoint->molecule_altered->dirty = 1;
             displace(system, system->checkpoint->molecule_altered, system->pbc, system->adiabatic_probability, 1.0);
 
             break;
@@ -747,6 +758,13 @@ void restore(system_t *system) {
     // restore the remaining observables
     memcpy(system->observables, system->checkpoint->observables, sizeof(observables_t));
 
+    /* roll back the static field, while the altered molecule is still in the list */
+    if (system->ef_static_cache) thole_field_restore(system);
+    /* the accepted inverse of A is still there */
+    if (system->B_woodbury) thole_woodbury_restore(system);
+    /* and the accepted schur complement */
+    if (system->A_schur) thole_schur_restore(system);
+
     /* restore state by undoing the steps of make_move() */
     switch (system->checkpoint->movetype) {
         case MOVETYPE_INSERT:
@@ -758,6 +776,7 @@ void restore(system_t *system) {
                 system->checkpoint->head->next = system->checkpoint->tail;
             }
             unupdate_pairs_insert(system);
+            system->arrays_dirty = 1;
             free_molecule(system, system->checkpoint->molecule_altered);
             system->checkpoint->molecule_altered = NULL; /* Insurance against memory errors */
 
@@ -775,6 +794,7 @@ void restore(system_t *system) {
             }
             system->checkpoint->molecule_backup->next = system->checkpoint->tail;
             unupdate_pairs_remove(system);
+            system->arrays_dirty = 1;
             system->checkpoint->molecule_backup = NULL;
 
             //reset atom and molecule id's
@@ -794,6 +814,7 @@ void restore(system_t *system) {
             else
                 system->checkpoint->head->next = system->checkpoint->molecule_backup;
             system->checkpoint->molecule_backup->next = system->checkpoint->tail;
+            update_molecule_arrays(system, system->checkpoint->molecule_altered, system->checkpoint->molecule_backup);
             free_molecule(system, system->checkpoint->molecule_altered);
             system->checkpoint->molecule_altered = NULL; /* Insurance against memory errors */
             system->checkpoint->molecule_backup = NULL;
@@ -802,6 +823,9 @@ void restore(system_t *system) {
     /* renormalize charges */
     if (system->spectre) spectre_charge_renormalize(system);
 
+    /* roll back the cached structure factor */
+    if (system->ewald_sf) ewald_sf_restore(system);
+
     /* establish the previous checkpoint again */
     checkpoint(system);
 
@@ -395,14 +395,13 @@ void read_multi_configs(system_t *system, multiConfigData_t *configs, multiParam
         system->molecules = configs->molecules[i];
         molecule_t *molecule_ptr;
         atom_t *atom_ptr;
-        pair_t *pair_ptr;
-        int n = 0;
+        int k, n = 0;
 
         for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
             for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
                 n++;
-                for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next)
-                    pair_ptr->recalculate_energy = 1;
+                for (k = 0; k < atom_ptr->npairs; k++)
+                    atom_ptr->pair_recalculate_energy[k] = 1;
             }
 
         system->natoms = n;
@@ -413,6 +412,7 @@ void read_multi_configs(system_t *system, multiConfigData_t *configs, multiParam
     }
 
     highest_n *= 3;
+    system->A_max = highest_n;
 
     // Allocate the A and B polarization matrices
     system->A_matrix = calloc(highest_n, sizeof(double *));
@@ -423,7 +423,7 @@ void read_multi_configs(system_t *system, multiConfigData_t *configs, multiParam
         memnullcheck(system->A_matrix[i], highest_n * sizeof(double), __LINE__ - 1, __FILE__);
     }
 
-    if (!system->polar_iterative) {
+    if (!system->polar_iterative && system->polarizability_tensor) {
         system->B_matrix = calloc(highest_n, sizeof(double *));
         memnullcheck(system->B_matrix, highest_n * sizeof(double *), __LINE__ - 1, __FILE__);
         for (i = 0; i < highest_n; i++) {
@@ -0,0 +1,122 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* anderson (DIIS) mixing for the iterative dipole solvers - each pass of the solver is a map mu -> g(mu), */
+/* and rather than taking g(mu) as the next dipoles, the next guess is the combination of the last */
+/* polar_anderson_depth passes whose residuals g(mu) - mu cancel best, in the least-squares sense */
+/* see Walker and Ni, SIAM J. Numer. Anal. 49 1715 (2011) */
+
+/* (re)size the history for the current system and forget the previous solve */
+void polar_anderson_reset(system_t *system) {
+    polar_anderson_t *h = system->polar_anderson_history;
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+    int n, m, k;
+
+    for (molecule_ptr = system->molecules, n = 0; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) n += 3;
+    m = system->polar_anderson_depth;
+
+    if (!h) {
+        h = system->polar_anderson_history = calloc(1, sizeof(polar_anderson_t));
+        memnullcheck(h, sizeof(polar_anderson_t), __LINE__ - 1, __FILE__);
+        h->dg = calloc(m, sizeof(double *));
+        memnullcheck(h->dg, m * sizeof(double *), __LINE__ - 1, __FILE__);
+        h->df = calloc(m, sizeof(double *));
+        memnullcheck(h->df, m * sizeof(double *), __LINE__ - 1, __FILE__);
+        h->normal = calloc(m, sizeof(double *));
+        memnullcheck(h->normal, m * sizeof(double *), __LINE__ - 1, __FILE__);
+        for (k = 0; k < m; k++) {
+            h->normal[k] = calloc(m, sizeof(double));
+            memnullcheck(h->normal[k], m * sizeof(double), __LINE__ - 1, __FILE__);
+        }
+    }
+
+    /* grow geometrically as molecules are inserted */
+    if (n > h->max_n) {
+        h->max_n = (n > 2 * h->max_n) ? n : 2 * h->max_n;
+        free(h->x);
+        h->x = calloc(4 * h->max_n, sizeof(double));
+        memnullcheck(h->x, 4 * h->max_n * sizeof(double), __LINE__ - 1, __FILE__);
+        h->g = h->x + h->max_n;
+        h->x_last = h->g + h->max_n;
+        h->f_last = h->x_last + h->max_n;
+        for (k = 0; k < m; k++) {
+            free(h->dg[k]);
+            free(h->df[k]);
+            h->dg[k] = calloc(h->max_n, sizeof(double));
+            memnullcheck(h->dg[k], h->max_n * sizeof(double), __LINE__ - 1, __FILE__);
+            h->df[k] = calloc(h->max_n, sizeof(double));
+            memnullcheck(h->df[k], h->max_n * sizeof(double), __LINE__ - 1, __FILE__);
+        }
+    }
+
+    h->n = n;
+    h->count = 0;
+}
+
+/* the dipoles old_mu went into the last pass and new_mu came out - replace mu with the mixed guess */
+void polar_anderson_mix(system_t *system) {
+    polar_anderson_t *h = system->polar_anderson_history;
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+    double *x = h->x, *g = h->g, *f, gamma[POLAR_ANDERSON_MAX_DEPTH], trace, d, sum;
+    int n = h->n, depth = system->polar_anderson_depth;
+    int i, j, k, p, m, slot, indx[POLAR_ANDERSON_MAX_DEPTH];
+
+    for (molecule_ptr = system->molecules, i = 0; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            for (p = 0; p < 3; p++, i++) {
+                x[i] = atom_ptr->old_mu[p];
+                g[i] = atom_ptr->new_mu[p];
+            }
+
+    /* the differences to the previous pass go into the oldest slot, f_last becomes the residual g - x */
+    if (h->count > 0) {
+        slot = (h->count - 1) % depth;
+        for (i = 0; i < n; i++) {
+            h->df[slot][i] = (g[i] - x[i]) - h->f_last[i];
+            h->dg[slot][i] = h->df[slot][i] + (x[i] - h->x_last[i]);
+        }
+    }
+    for (i = 0; i < n; i++) {
+        h->x_last[i] = x[i];
+        h->f_last[i] = g[i] - x[i];
+    }
+    f = h->f_last;
+    m = (h->count < depth) ? h->count : depth;
+    h->count++;
+
+    /* min |f - dF gamma| from the normal equations, lightly regularized against nearly parallel columns */
+    if (m > 0) {
+        for (j = 0, trace = 0; j < m; j++) {
+            for (k = 0; k <= j; k++) {
+                for (i = 0, sum = 0; i < n; i++) sum += h->df[j][i] * h->df[k][i];
+                h->normal[j][k] = h->normal[k][j] = sum;
+            }
+            for (i = 0, sum = 0; i < n; i++) sum += h->df[j][i] * f[i];
+            gamma[j] = sum;
+            trace += h->normal[j][j];
+        }
+
+        if (trace > 0.0) {
+            for (j = 0; j < m; j++) h->normal[j][j] += POLAR_ANDERSON_REGULARIZE * trace / m;
+            LU_decomp(h->normal, m, indx, &d);
+            LU_bksb(h->normal, m, indx, gamma);
+
+            for (j = 0; j < m; j++)
+                for (i = 0; i < n; i++) g[i] -= gamma[j] * h->dg[j][i];
+        }
+    }
+
+    for (molecule_ptr = system->molecules, i = 0; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            for (p = 0; p < 3; p++, i++) atom_ptr->mu[p] = g[i];
+}
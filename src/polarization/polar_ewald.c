@@ -39,31 +39,32 @@ void real_term(system_t *system) {
     molecule_t *mptr;
     atom_t *aptr;
     pair_t *pptr;
-    int p;
+    int p, k;
     double r, r2, factor, a;
     a = system->polar_ewald_alpha;  //some ambiguity between ea and ea^2 across the literature
 
     for (mptr = system->molecules; mptr; mptr = mptr->next) {
         for (aptr = mptr->atoms; aptr; aptr = aptr->next) {
-            for (pptr = aptr->pairs; pptr; pptr = pptr->next) {  //for each pair
-                if (pptr->frozen) continue;                      //if the pair is frozen (i.e. MOF-MOF interaction) it doesn't contribute to polar
-                r = pptr->rimg;
+            for (k = 0; k < aptr->npairs; k++) {  //for each pair
+                pptr = &aptr->pairs[k];
+                if (pptr->frozen) continue;  //if the pair is frozen (i.e. MOF-MOF interaction) it doesn't contribute to polar
+                r = aptr->pair_rimg[k];
                 if ((r > system->pbc->cutoff) || (r == 0.0)) continue;  //if outside cutoff sphere (not sure why r==0 ever) -> skip
                 r2 = r * r;
                 if (pptr->es_excluded) {
                     //need to subtract self-term (interaction between a site and a neighbor's screening charge (on the same molecule)
                     factor = (2.0 * a * OneOverSqrtPi * exp(-a * a * r2) * r - erf(a * r)) / (r * r2);
                     for (p = 0; p < 3; p++) {
-                        aptr->ef_static[p] += factor * pptr->atom->charge * pptr->dimg[p];
-                        pptr->atom->ef_static[p] -= factor * aptr->charge * pptr->dimg[p];
+                        aptr->ef_static[p] += factor * pptr->atom->charge * aptr->pair_dimg[3 * k + p];
+                        pptr->atom->ef_static[p] -= factor * aptr->charge * aptr->pair_dimg[3 * k + p];
                     }
                 }       //excluded
                 else {  //not excluded
 
                     factor = (2.0 * a * OneOverSqrtPi * exp(-a * a * r2) * r + erfc(a * r)) / (r2 * r);
                     for (p = 0; p < 3; p++) {  // for each dim, add e-field contribution for the pair
-                        aptr->ef_static[p] += factor * pptr->atom->charge * pptr->dimg[p];
-                        pptr->atom->ef_static[p] -= factor * aptr->charge * pptr->dimg[p];
+                        aptr->ef_static[p] += factor * pptr->atom->charge * aptr->pair_dimg[3 * k + p];
+                        pptr->atom->ef_static[p] -= factor * aptr->charge * aptr->pair_dimg[3 * k + p];
                     }
                 }  //excluded else
             }      //ptr
@@ -73,60 +74,45 @@ void real_term(system_t *system) {
     return;
 }
 
+//structure factor of the i-th k-vector, stored as the coefficients of sin and cos in the field
+static void recip_structure_k(system_t *system, int i, void *arg, double *unused) {
+    double *coeff = arg;
+    double float1, float2;
+
+    kspace_charges(system->kspace, i, &float1, &float2);
+    coeff[i] = float1;
+    coeff[system->kspace->nk + i] = -float2;
+}
+
+//reciprocal static field at the n-th tabulated atom
+static void recip_field_atom(system_t *system, int n, void *arg, double *unused) {
+    kspace_t *ks = system->kspace;
+    double *coeff = arg;
+    double field[3] = {0, 0, 0};
+    int p;
+
+    kspace_field(ks, n, ks->polar_weight, coeff, &coeff[ks->nk], field);
+    //factor of 2 more, since we only summed over hemisphere
+    for (p = 0; p < 3; p++)
+        ks->atoms[n]->ef_static[p] += 8.0 * M_PI / system->pbc->volume * field[p];
+}
+
 //we deviate from drexel's treatment, and instead do a trig identity to get from a pairwise sum to two atomwise rums
 //or ignore drexel, and derive this term from eq (29) in nymand and linse
 void recip_term(system_t *system) {
-    molecule_t *mptr;
-    atom_t *aptr;
-    int p, q, l[3], kmax;
-    double ea, k[3], k2, kweight[3], float1, float2;
-    ea = system->polar_ewald_alpha;  //actually sqrt(ea)
-    kmax = system->ewald_kmax;
+    double *coeff;
+    int nk;
 
     //k-space sum (symmetry for k -> -k, so we sum over hemisphere, avoiding double-counting on the face)
-    for (l[0] = 0; l[0] <= kmax; l[0]++) {
-        for (l[1] = (!l[0] ? 0 : -kmax); l[1] <= kmax; l[1]++) {
-            for (l[2] = ((!l[0] && !l[1]) ? 1 : -kmax); l[2] <= kmax; l[2]++) {
-                // if |l|^2 > kmax^2, then it doesn't contribute (outside the k-space cutoff)
-                if (iidotprod(l, l) > kmax * kmax) continue;
+    kspace_atoms(system, 0);
+    nk = system->kspace->nk;
+    coeff = malloc(2 * nk * sizeof(double));
+    memnullcheck(coeff, 2 * nk * sizeof(double), __LINE__ - 1, __FILE__);
 
-                for (p = 0; p < 3; p++) {
-                    for (q = 0, k[p] = 0; q < 3; q++)
-                        k[p] += 2.0 * M_PI * system->pbc->reciprocal_basis[p][q] * l[q];
-                }
-                k2 = dddotprod(k, k);
+    thread_sum(system, nk, recip_structure_k, coeff);
+    thread_sum(system, system->kspace->natoms, recip_field_atom, coeff);
 
-                kweight[0] = k[0] / k2 * exp(-k2 / (4.0 * ea * ea));
-                kweight[1] = k[1] / k2 * exp(-k2 / (4.0 * ea * ea));
-                kweight[2] = k[2] / k2 * exp(-k2 / (4.0 * ea * ea));
-
-                float1 = float2 = 0;
-                for (mptr = system->molecules; mptr; mptr = mptr->next)
-                    for (aptr = mptr->atoms; aptr; aptr = aptr->next) {
-                        float1 += aptr->charge * cos(dddotprod(k, aptr->pos));
-                        float2 += aptr->charge * sin(dddotprod(k, aptr->pos));
-                    }
-
-                for (mptr = system->molecules; mptr; mptr = mptr->next)
-                    for (aptr = mptr->atoms; aptr; aptr = aptr->next) {
-                        for (p = 0; p < 3; p++) {
-                            aptr->ef_static[p] += kweight[p] * sin(dddotprod(k, aptr->pos)) * float1;
-                            aptr->ef_static[p] -= kweight[p] * cos(dddotprod(k, aptr->pos)) * float2;
-                        }
-                    }
-
-            }  //l2
-        }      //l1
-    }          //l0
-
-    for (mptr = system->molecules; mptr; mptr = mptr->next) {
-        for (aptr = mptr->atoms; aptr; aptr = aptr->next) {
-            for (p = 0; p < 3; p++) {
-                //factor of 2 more, since we only summed over hemisphere
-                aptr->ef_static[p] *= 8.0 * M_PI / system->pbc->volume;
-            }
-        }
-    }
+    free(coeff);
 
     return;
 }
@@ -142,6 +128,8 @@ void init_dipoles_ewald(system_t *system) {
             for (p = 0; p < 3; p++) {
                 aptr->old_mu[p] = 0;
                 aptr->new_mu[p] = aptr->mu[p] = aptr->polarizability * aptr->ef_static[p];
+                if (system->polar_warm_start)
+                    aptr->new_mu[p] = aptr->mu[p] += aptr->mu_last[p] - aptr->polarizability * aptr->ef_static_last[p];
             }
 
     return;
@@ -177,6 +165,7 @@ void induced_real_term(system_t *system) {
     molecule_t *mptr;
     atom_t *aptr;
     pair_t *pptr;
+    int k;
     double erfcar, expa2r2, r, ir, ir3, ir5;
     double T;                              //dipole-interaction tensor component
     double s1, s2;                         //common term (s_2 via eq 10. JCP 133 243101)
@@ -186,11 +175,12 @@ void induced_real_term(system_t *system) {
 
     for (mptr = system->molecules; mptr; mptr = mptr->next) {
         for (aptr = mptr->atoms; aptr; aptr = aptr->next) {
-            for (pptr = aptr->pairs; pptr; pptr = pptr->next) {
+            for (k = 0; k < aptr->npairs; k++) {
+                pptr = &aptr->pairs[k];
                 if (aptr->polarizability == 0 || pptr->atom->polarizability == 0) continue;  //don't waste CPU time
-                if (pptr->rimg > system->pbc->cutoff) continue;                              //if outside cutoff sphere skip
+                if (aptr->pair_rimg[k] > system->pbc->cutoff) continue;                      //if outside cutoff sphere skip
                 //some things we'll need
-                r = pptr->rimg;
+                r = aptr->pair_rimg[k];
                 ir = 1.0 / r;
                 ir3 = ir * ir * ir;
                 ir5 = ir * ir * ir3;
@@ -209,7 +199,7 @@ void induced_real_term(system_t *system) {
                             s1 = 0;
 
                         //real-space dipole interaction tensor
-                        T = 3.0 * pptr->dimg[p] * pptr->dimg[q] * s2 * ir5 - s1 * ir3;
+                        T = 3.0 * aptr->pair_dimg[3 * k + p] * aptr->pair_dimg[3 * k + q] * s2 * ir5 - s1 * ir3;
 
                         aptr->ef_induced[p] += T * pptr->atom->mu[q];
                         pptr->atom->ef_induced[p] += T * aptr->mu[q];
@@ -229,66 +219,42 @@ void induced_real_term(system_t *system) {
     return;
 }
 
-void induced_recip_term(system_t *system) {
-    molecule_t *mptr;
-    atom_t *aptr;
-    atom_t **aarray = NULL;
-    int i, j, N, l[3];
-    int p, q;
-    double Psin, Pcos, kweight;
-    double a = system->polar_ewald_alpha;
-    double kmax = system->ewald_kmax;
-    double dotprod1, dotprod2, k[3], k2;
+//dipole structure factor of the i-th k-vector, stored as the coefficients of sin and cos in the field
+static void induced_structure_k(system_t *system, int i, void *arg, double *unused) {
+    double *coeff = arg;
+    double Pcos, Psin;
 
-    //make atom array
-    N = 0;
-    for (mptr = system->molecules; mptr; mptr = mptr->next) {
-        for (aptr = mptr->atoms; aptr; aptr = aptr->next) {
-            aarray = realloc(aarray, sizeof(atom_t *) * (N + 1));
-            memnullcheck(aarray, sizeof(atom_t *) * (N + 1), __LINE__ - 1, __FILE__);
-            aarray[N] = aptr;
-            N++;
-        }
-    }
+    kspace_dipoles(system->kspace, i, &Pcos, &Psin);
+    coeff[i] = -Psin;
+    coeff[system->kspace->nk + i] = -Pcos;
+}
 
-    //k-space sum (symmetry for k -> -k, so we sum over hemisphere, avoiding double-counting on the face)
-    for (l[0] = 0; l[0] <= kmax; l[0]++)
-        for (l[1] = (!l[0] ? 0 : -kmax); l[1] <= kmax; l[1]++)
-            for (l[2] = ((!l[0] && !l[1]) ? 1 : -kmax); l[2] <= kmax; l[2]++) {
-                // if |l|^2 > kmax^2, then it doesn't contribute (outside the k-space cutoff)
-                if (iidotprod(l, l) > kmax * kmax) continue;
+//reciprocal induced field at the n-th tabulated atom
+static void induced_field_atom(system_t *system, int n, void *arg, double *unused) {
+    kspace_t *ks = system->kspace;
+    double *coeff = arg;
+    double field[3] = {0, 0, 0};
+    int p;
 
-                for (p = 0; p < 3; p++) {
-                    for (q = 0, k[p] = 0; q < 3; q++)
-                        k[p] += 2.0 * M_PI * system->pbc->reciprocal_basis[p][q] * l[q];
-                }
-                k2 = dddotprod(k, k);
-
-                for (p = 0; p < 3; p++)
-                    kweight = 8.0 * M_PI / system->pbc->volume * exp(-k2 / (4.0 * a * a)) / k2 * k[p];
-
-                //calculate Pcos, Psin for this k-point
-                Pcos = Psin = 0;
-                for (j = 0; j < N; j++) {
-                    dotprod1 = dddotprod(k, aarray[j]->mu);
-                    dotprod2 = dddotprod(k, aarray[j]->pos);
-                    Pcos += dotprod1 * cos(dotprod2);
-                    Psin += dotprod1 * sin(dotprod2);
-                }
+    kspace_field(ks, n, ks->polar_weight, coeff, &coeff[ks->nk], field);
+    for (p = 0; p < 3; p++)
+        ks->atoms[n]->ef_induced[p] += 8.0 * M_PI / system->pbc->volume * field[p];
+}
 
-                //calculate ef_induced over atom array
-                for (i = 0; i < N; i++) {
-                    //for each cartesian dimension
-                    for (p = 0; p < 3; p++) {
-                        dotprod1 = dddotprod(k, aarray[i]->pos);
-                        aarray[i]->ef_induced[p] += kweight * (-sin(dotprod1) * Psin - cos(dotprod1) * Pcos);
+void induced_recip_term(system_t *system) {
+    double *coeff;
+    int nk;
 
-                    }  //dim
-                }      //ef_incuded over atom array
+    //k-space sum (symmetry for k -> -k, so we sum over hemisphere, avoiding double-counting on the face)
+    kspace_atoms(system, 0);
+    nk = system->kspace->nk;
+    coeff = malloc(2 * nk * sizeof(double));
+    memnullcheck(coeff, 2 * nk * sizeof(double), __LINE__ - 1, __FILE__);
 
-            }  //kspace
+    thread_sum(system, nk, induced_structure_k, coeff);
+    thread_sum(system, system->kspace->natoms, induced_field_atom, coeff);
 
-    free(aarray);
+    free(coeff);
 
     return;
 }
@@ -372,7 +338,8 @@ void ewald_palmo_contraction(system_t *system) {
 
 //do full polarization calculation using ewald
 //see nymand and linse jcp 112 6152 (2000)
-void ewald_full(system_t *system) {
+//returns the number of iterations required
+int ewald_full(system_t *system) {
     //int max_iter=system->polar_max_iter;  (unused variable)
     int keep_iterating, iteration_counter;
 
@@ -383,13 +350,14 @@ void ewald_full(system_t *system) {
 
     //calculate induced e-field
     init_dipoles_ewald(system);
+    if (system->polar_anderson) polar_anderson_reset(system);
 
     keep_iterating = 1;
     iteration_counter = 0;
     while (keep_iterating) {
         if (iteration_counter >= MAX_ITERATION_COUNT && system->polar_precision) {
             system->iter_success = 1;
-            return;
+            return (iteration_counter);
         }
 
         //set induced field to zero
@@ -411,8 +379,12 @@ void ewald_full(system_t *system) {
         if (system->polar_palmo && !keep_iterating)  //if last iteration
             ewald_palmo_contraction(system);
 
+        //extrapolate the next dipoles from the last few
+        if (system->polar_anderson && keep_iterating)
+            polar_anderson_mix(system);
+
         iteration_counter++;
     }
 
-    return;
+    return (iteration_counter);
 }
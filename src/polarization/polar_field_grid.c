@@ -0,0 +1,185 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* static field grid - the field of the frozen atoms is tabulated once on a periodic grid in fractional */
+/* coordinates, as framework_grid does for their potential, and read off at the mobile sites by tricubic */
+/* interpolation of each component - the field sums then only carry the field of the mobile charges */
+/* the frozen atoms never polarize each other (see pair_exclusions), so their field at the frozen sites is zero */
+/* only the wolf field is tabulated - the plain cutoff one jumps at the cutoff, and check_input turns it away */
+
+/* the frozen charges, and the scratch space of one plane of grid points */
+typedef struct _polar_field_grid_plane {
+    polar_field_grid_t *grid;
+    int nfrozen;
+    double *x, *y, *z, *q;
+} polar_field_grid_plane_t;
+
+/* tabulate the field over the points of plane x[0] = index */
+static void polar_field_grid_plane(system_t *system, int index, void *arg, double *unused) {
+    polar_field_grid_plane_t *plane = arg;
+    polar_field_grid_t *grid = plane->grid;
+    double *dx, *dy, *dz, *rimg, *ef;
+    double s[3], pos[3], term;
+    int n = plane->nfrozen;
+    int j, p, q, x[3];
+
+    dx = malloc(4 * (n + 1) * sizeof(double));
+    memnullcheck(dx, 4 * (n + 1) * sizeof(double), __LINE__ - 1, __FILE__);
+    dy = dx + (n + 1);
+    dz = dy + (n + 1);
+    rimg = dz + (n + 1);
+
+    x[0] = index;
+    for (x[1] = 0; x[1] < grid->n[1]; x[1]++) {
+        for (x[2] = 0; x[2] < grid->n[2]; x[2]++) {
+            /* cartesian position of the grid point */
+            for (p = 0; p < 3; p++)
+                s[p] = (double)x[p] / (double)grid->n[p];
+            for (p = 0; p < 3; p++)
+                for (q = 0, pos[p] = 0; q < 3; q++)
+                    pos[p] += system->pbc->basis[q][p] * s[q];
+
+            minimum_image_batch(system->pbc, pos, n, plane->x, plane->y, plane->z, dx, dy, dz, rimg);
+
+            ef = &grid->ef[3 * ((x[0] * grid->n[1] + x[1]) * grid->n[2] + x[2])];
+            for (j = 0; j < n; j++) {
+                term = thole_field_kernel(system, rimg[j]);
+                if (term == 0.0) continue;
+                ef[0] += plane->q[j] * term * dx[j];
+                ef[1] += plane->q[j] * term * dy[j];
+                ef[2] += plane->q[j] * term * dz[j];
+            }
+
+            /* keep the overlap region finite so that it can be interpolated */
+            for (p = 0; p < 3; p++) {
+                if (ef[p] > POLAR_FIELD_GRID_MAX) ef[p] = POLAR_FIELD_GRID_MAX;
+                if (ef[p] < -POLAR_FIELD_GRID_MAX) ef[p] = -POLAR_FIELD_GRID_MAX;
+            }
+        }
+    }
+
+    free(dx);
+}
+
+/* tabulate the static field of the frozen atoms */
+void setup_polar_field_grid(system_t *system) {
+    polar_field_grid_t *grid;
+    polar_field_grid_plane_t plane;
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+    int j, p, q, npoints;
+    double r;
+    char linebuf[MAXLINE];
+
+    grid = system->pf_grid = calloc(1, sizeof(polar_field_grid_t));
+    memnullcheck(grid, sizeof(polar_field_grid_t), __LINE__ - 1, __FILE__);
+
+    /* the charged frozen atoms, in flat arrays for minimum_image_batch() */
+    for (molecule_ptr = system->molecules, plane.nfrozen = 0; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            if (atom_ptr->frozen && (atom_ptr->charge != 0.0)) plane.nfrozen++;
+    plane.x = calloc(4 * (plane.nfrozen + 1), sizeof(double));
+    memnullcheck(plane.x, 4 * (plane.nfrozen + 1) * sizeof(double), __LINE__ - 1, __FILE__);
+    plane.y = plane.x + (plane.nfrozen + 1);
+    plane.z = plane.y + (plane.nfrozen + 1);
+    plane.q = plane.z + (plane.nfrozen + 1);
+    for (molecule_ptr = system->molecules, j = 0; molecule_ptr; molecule_ptr = molecule_ptr->next) {
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
+            if (!(atom_ptr->frozen && (atom_ptr->charge != 0.0))) continue;
+            plane.x[j] = atom_ptr->pos[0];
+            plane.y[j] = atom_ptr->pos[1];
+            plane.z[j] = atom_ptr->pos[2];
+            plane.q[j] = atom_ptr->charge;
+            j++;
+        }
+    }
+    plane.grid = grid;
+
+    /* enough points along each lattice vector for the requested spacing */
+    for (p = 0; p < 3; p++) {
+        for (q = 0, r = 0; q < 3; q++)
+            r += system->pbc->basis[p][q] * system->pbc->basis[p][q];
+        grid->n[p] = (int)ceil(sqrt(r) / system->polar_field_grid_spacing);
+        if (grid->n[p] < 4) grid->n[p] = 4;
+    }
+    npoints = grid->n[0] * grid->n[1] * grid->n[2];
+    grid->ef = calloc(3 * npoints, sizeof(double));
+    memnullcheck(grid->ef, 3 * npoints * sizeof(double), __LINE__ - 1, __FILE__);
+
+    sprintf(linebuf,
+            "INPUT: tabulating the static field of %d frozen charges on a %dx%dx%d grid\n",
+            plane.nfrozen, grid->n[0], grid->n[1], grid->n[2]);
+    output(linebuf);
+
+    if (system->polar_wolf_alpha_lookup && !(system->polar_wolf_alpha_table))
+        system->polar_wolf_alpha_table = polar_wolf_alpha_lookup_init(system);
+
+    thread_sum(system, grid->n[0], polar_field_grid_plane, &plane);
+
+    free(plane.x);
+
+    output(
+        "INPUT: finished tabulating the static field\n");
+}
+
+/* add the frozen atoms' field at a mobile site to its ef_static */
+/* each component is bounded by the enclosing cell's corners, as in framework_grid */
+void polar_field_grid_site(system_t *system, atom_t *atom_ptr) {
+    polar_field_grid_t *grid = system->pf_grid;
+    int a, b, c, p, q, g, idx[3][4];
+    double s[3], w[3][4], wabc, v, sum[3], vmin[3], vmax[3];
+
+    /* fractional coordinates, wrapped into the unit cell */
+    for (p = 0; p < 3; p++) {
+        for (q = 0, s[p] = 0; q < 3; q++)
+            s[p] += system->pbc->reciprocal_basis[q][p] * atom_ptr->pos[q];
+        s[p] -= floor(s[p]);
+    }
+
+    grid_catmull_rom(grid->n, s, w, idx);
+
+    for (p = 0; p < 3; p++) {
+        sum[p] = 0;
+        vmin[p] = MAXVALUE;
+        vmax[p] = -MAXVALUE;
+    }
+    for (a = 0; a < 4; a++) {
+        for (b = 0; b < 4; b++) {
+            for (c = 0; c < 4; c++) {
+                wabc = w[0][a] * w[1][b] * w[2][c];
+                g = 3 * ((idx[0][a] * grid->n[1] + idx[1][b]) * grid->n[2] + idx[2][c]);
+                for (p = 0; p < 3; p++) {
+                    v = grid->ef[g + p];
+                    sum[p] += wabc * v;
+                    if ((a == 1 || a == 2) && (b == 1 || b == 2) && (c == 1 || c == 2)) {
+                        if (v < vmin[p]) vmin[p] = v;
+                        if (v > vmax[p]) vmax[p] = v;
+                    }
+                }
+            }
+        }
+    }
+
+    for (p = 0; p < 3; p++) {
+        if (sum[p] < vmin[p]) sum[p] = vmin[p];
+        if (sum[p] > vmax[p]) sum[p] = vmax[p];
+        atom_ptr->ef_static[p] += sum[p];
+    }
+}
+
+/* the frozen atoms' field at every mobile site */
+void polar_field_grid_field(system_t *system) {
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+
+    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            if (!atom_ptr->frozen) polar_field_grid_site(system, atom_ptr);
+}
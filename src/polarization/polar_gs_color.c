@@ -0,0 +1,101 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* multicolor gauss-seidel - the polarizable atoms closer than polar_gs_color_cutoff are joined in a graph, */
+/* which is colored greedily so that no two neighbors share a color */
+/* the sweep then goes color by color: the atoms of one color only see each other's old dipoles, and are */
+/* updated together across the threads, while every color sees the new dipoles of the colors before it */
+/* the strong, short-range couplings are thus always gauss-seidel, and convergence stays close to it */
+/* between solves only the atoms that have moved since (those of the molecule of an mc move, or of a */
+/* rejected move put back) are colored again, against their neighbors in the new configuration, in */
+/* O(moved x natoms) - all of them are, in the ranked order of the moment, once the pair lists are rebuilt */
+/* (an insertion or removal, or a new neighbor list) */
+
+/* the atoms or their pairs changed, color them again at the next solve */
+void polar_gs_color_invalidate(system_t *system) {
+    if (system->polar_colors) system->polar_colors->valid = 0;
+}
+
+/* the lowest color that none of the colored neighbors of atom i has */
+static int polar_gs_color_atom(system_t *system, int i) {
+    polar_colors_t *pc = system->polar_colors;
+    atom_t **aa = system->atom_array;
+    int j, c, N = system->natoms;
+    double cutoff = system->polar_gs_color_cutoff;
+
+    if (aa[i]->polarizability != 0.0) {
+        for (j = 0; j < i; j++)
+            if ((pc->color[j] >= 0) && (aa[j]->polarizability != 0.0) && (aa[j]->pair_rimg[i - j - 1] <= cutoff)) pc->stamp[pc->color[j]] = i;
+        for (j = (i + 1); j < N; j++)
+            if ((pc->color[j] >= 0) && (aa[j]->polarizability != 0.0) && (aa[i]->pair_rimg[j - i - 1] <= cutoff)) pc->stamp[pc->color[j]] = i;
+    }
+    for (c = 0; pc->stamp[c] == i; c++)
+        ;
+
+    return (c);
+}
+
+/* color the atoms that need it, taken in the given order (the ranked one, with polar_gs_ranked) */
+void polar_gs_color_setup(system_t *system, int *order) {
+    polar_colors_t *pc = system->polar_colors;
+    atom_t **aa = system->atom_array;
+    int N = system->natoms;
+    int i, k, c, nmoved;
+
+    if (!pc) {
+        pc = system->polar_colors = calloc(1, sizeof(polar_colors_t));
+        memnullcheck(pc, sizeof(polar_colors_t), __LINE__ - 1, __FILE__);
+    }
+
+    /* grow geometrically as atoms are inserted */
+    if (N > pc->max_atoms) {
+        pc->max_atoms = (N > 2 * pc->max_atoms) ? N : 2 * pc->max_atoms;
+        free(pc->color);
+        pc->color = malloc(4 * (pc->max_atoms + 1) * sizeof(int));
+        memnullcheck(pc->color, 4 * (pc->max_atoms + 1) * sizeof(int), __LINE__ - 1, __FILE__);
+        pc->first = pc->color + (pc->max_atoms + 1);
+        pc->atoms = pc->first + (pc->max_atoms + 1);
+        pc->stamp = pc->atoms + (pc->max_atoms + 1);
+        free(pc->pos);
+        pc->pos = malloc(3 * pc->max_atoms * sizeof(double));
+        memnullcheck(pc->pos, 3 * pc->max_atoms * sizeof(double), __LINE__ - 1, __FILE__);
+        pc->valid = 0;
+    }
+
+    /* the atoms to color, the others keep theirs */
+    for (i = 0, nmoved = 0; i < N; i++)
+        if (!pc->valid || (aa[i]->pos[0] != pc->pos[3 * i]) || (aa[i]->pos[1] != pc->pos[3 * i + 1]) || (aa[i]->pos[2] != pc->pos[3 * i + 2])) {
+            pc->color[i] = -1;
+            memcpy(&pc->pos[3 * i], aa[i]->pos, 3 * sizeof(double));
+            nmoved++;
+        }
+    if (!nmoved) return;
+
+    /* greedy coloring - each atom takes the lowest color none of its colored neighbors has */
+    for (c = 0; c <= N; c++) pc->stamp[c] = -1;
+    for (k = 0; k < N; k++) {
+        i = order[k];
+        if (pc->color[i] < 0) pc->color[i] = polar_gs_color_atom(system, i);
+    }
+    for (i = 0, pc->ncolors = 0; i < N; i++)
+        if (pc->color[i] >= pc->ncolors) pc->ncolors = pc->color[i] + 1;
+
+    /* the atoms of each color, in order */
+    for (c = 0; c <= pc->ncolors; c++) pc->first[c] = 0;
+    for (i = 0; i < N; i++) pc->first[pc->color[i] + 1]++;
+    for (c = 0; c < pc->ncolors; c++) pc->first[c + 1] += pc->first[c];
+    for (c = 0; c < pc->ncolors; c++) pc->stamp[c] = pc->first[c];
+    for (k = 0; k < N; k++) {
+        i = order[k];
+        pc->atoms[pc->stamp[pc->color[i]]++] = i;
+    }
+
+    pc->valid = 1;
+}
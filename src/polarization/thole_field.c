@@ -9,6 +9,183 @@ University of South Florida
 #include <mc.h>
 #define OneOverSqrtPi 0.56418958354
 
+/* with polar_field_incremental, the static field of the accepted configuration is kept between mc steps */
+/* a move only changes the field from and at the altered molecule, so the old molecule's field is taken off */
+/* the other atoms and the new one's added - a rejected move puts the accepted field back */
+
+/* radial part of the wolf field, E_i += q_j * term * d_ij / r */
+static double thole_field_wolf_term(system_t *system, double r) {
+    double R = system->pbc->cutoff;
+    double rR = 1. / R;
+    double rr = 1. / r;
+    double a = system->polar_wolf_alpha;
+    double cutoffterm, bigmess;
+
+    //see JCP 124 (234104)
+    if (a == 0) return (rr * rr - rR * rR);
+
+    cutoffterm = (erfc(a * R) * rR * rR + 2.0 * a * OneOverSqrtPi * exp(-a * a * R * R) * rR);
+    if (system->polar_wolf_alpha_lookup)
+        bigmess = polar_wolf_alpha_getval(system, r);
+    else
+        bigmess = (erfc(a * r) * rr * rr + 2.0 * a * OneOverSqrtPi * exp(-a * a * r * r) * rr);
+
+    return (bigmess - cutoffterm);
+}
+
+/* E_i += q_j * kernel * d_ij, for the wolf or the cutoff field - zero beyond the cutoff */
+double thole_field_kernel(system_t *system, double r) {
+    if (!((r - SMALL_dR < system->pbc->cutoff) && (r != 0.))) return (0);
+
+    if (system->polar_wolf || system->polar_wolf_full)
+        return (thole_field_wolf_term(system, r) / r);
+    else
+        return (1.0 / (r * r * r));
+}
+
+/* with polar_field_grid, the field of a frozen atom at a mobile one comes off the grid, and a frozen */
+/* atom only needs the field of the mobile ones if it polarizes - returns 1 if neither end needs the pair */
+static int thole_field_grid_ends(system_t *system, atom_t *atom_i, atom_t *atom_j, int *field_i, int *field_j) {
+    *field_i = *field_j = 1;
+    if (!system->polar_field_grid || (atom_i->frozen == atom_j->frozen)) return (0);
+
+    if (atom_j->frozen) {
+        *field_i = 0;
+        *field_j = (atom_j->polarizability != 0.0);
+    } else {
+        *field_j = 0;
+        *field_i = (atom_i->polarizability != 0.0);
+    }
+
+    return (!(*field_i || *field_j));
+}
+
+/* sign * the field between atom_i and atom_j, added at atom_j and, if field_i is set, at atom_i */
+static void thole_field_pair(system_t *system, molecule_t *molecule_i, atom_t *atom_i, molecule_t *molecule_j, atom_t *atom_j, double sign, int field_i) {
+    pair_t pair;
+    double r, rimg, dimg[3], term;
+    int p, grid_i, grid_j;
+
+    if (thole_field_grid_ends(system, atom_i, atom_j, &grid_i, &grid_j)) return;
+    field_i = field_i && grid_i;
+
+    memset(&pair, 0, sizeof(pair_t));
+    pair_exclusions(system, molecule_i, molecule_j, atom_i, atom_j, &pair);
+    if (pair.frozen) return;
+    minimum_image_separation(system, atom_i, atom_j, &r, &rimg, dimg);
+
+    term = thole_field_kernel(system, rimg);
+    if (term == 0.0) return;
+
+    for (p = 0; p < 3; p++) {
+        if (field_i) atom_i->ef_static[p] += sign * atom_j->charge * term * dimg[p];
+        if (grid_j) atom_j->ef_static[p] -= sign * atom_i->charge * term * dimg[p];
+    }
+}
+
+/* sign * the field of molecule_ptr at every atom of the list except those of skip */
+/* with field_self set, the field of the others at molecule_ptr is summed as well */
+static void thole_field_molecule(system_t *system, molecule_t *molecule_ptr, molecule_t *skip, double sign, int field_self) {
+    molecule_t *molecule_j;
+    atom_t *atom_ptr, *atom_j;
+
+    for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+        for (molecule_j = system->molecules; molecule_j; molecule_j = molecule_j->next) {
+            if ((molecule_j == molecule_ptr) || (molecule_j == skip)) continue;
+            for (atom_j = molecule_j->atoms; atom_j; atom_j = atom_j->next)
+                thole_field_pair(system, molecule_ptr, atom_ptr, molecule_j, atom_j, sign, field_self);
+        }
+}
+
+/* returns 1 if the pending move could be applied to the accepted field */
+static int thole_field_update(system_t *system) {
+    ef_static_cache_t *cache = system->ef_static_cache;
+    checkpoint_t *checkpoint = system->checkpoint;
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+    int p;
+
+    if (!(cache->pending && cache->valid) || (cache->updates >= system->polar_field_refresh)) return (0);
+    switch (checkpoint->movetype) {
+        case MOVETYPE_INSERT:
+        case MOVETYPE_REMOVE:
+        case MOVETYPE_DISPLACE:
+        case MOVETYPE_ADIABATIC:
+            break;
+        default:
+            return (0);
+    }
+
+    /* keep the accepted field of the atoms that stay, for restore() */
+    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
+        if (molecule_ptr == checkpoint->molecule_altered) continue;
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            for (p = 0; p < 3; p++) atom_ptr->ef_static_old[p] = atom_ptr->ef_static[p];
+    }
+
+    /* the backup holds the old coordinates, but the altered molecule is the one in the list */
+    if (checkpoint->movetype != MOVETYPE_INSERT)
+        thole_field_molecule(system, checkpoint->molecule_backup, checkpoint->molecule_altered, -1.0, 0);
+    if (checkpoint->movetype != MOVETYPE_REMOVE) {
+        for (atom_ptr = checkpoint->molecule_altered->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
+            for (p = 0; p < 3; p++) atom_ptr->ef_static[p] = 0;
+            if (system->polar_field_grid) polar_field_grid_site(system, atom_ptr);
+        }
+        thole_field_molecule(system, checkpoint->molecule_altered, NULL, 1.0, 1);
+    }
+
+    cache->pending = 0;
+    cache->applied = 1;
+
+    return (1);
+}
+
+/* a move was made, the field has yet to see it */
+void thole_field_move(system_t *system) {
+    ef_static_cache_t *cache = system->ef_static_cache;
+
+    /* a spin flip leaves the charges where they are */
+    cache->pending = (system->checkpoint->movetype != MOVETYPE_SPINFLIP);
+    cache->applied = 0;
+    cache->rebuilt = 0;
+}
+
+/* the move was rejected - called while the altered molecule is still in the list */
+void thole_field_restore(system_t *system) {
+    ef_static_cache_t *cache = system->ef_static_cache;
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+    int p;
+
+    /* the backup that goes back in carries its accepted field */
+    if (cache->applied) {
+        for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
+            if (molecule_ptr == system->checkpoint->molecule_altered) continue;
+            for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+                for (p = 0; p < 3; p++) atom_ptr->ef_static[p] = atom_ptr->ef_static_old[p];
+        }
+    } else if (cache->rebuilt)
+        cache->valid = 0; /* nothing to go back to, start over */
+
+    cache->pending = 0;
+    cache->applied = 0;
+    cache->rebuilt = 0;
+}
+
+/* the move was accepted, the field as it stands belongs to the new configuration */
+void thole_field_accept(system_t *system) {
+    ef_static_cache_t *cache = system->ef_static_cache;
+
+    /* the move never reached the field (e.g. a bad contact), so it can't be trusted */
+    if (cache->pending) cache->valid = 0;
+    /* only the accepted updates stay in the field, so only they count towards the refresh */
+    if (cache->applied) cache->updates++;
+
+    cache->pending = 0;
+    cache->applied = 0;
+    cache->rebuilt = 0;
+}
+
 //called from energy/polar.c
 /* calculate the field with periodic boundaries */
 void thole_field(system_t *system) {
@@ -16,6 +193,20 @@ void thole_field(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
 
+    if (system->polar_field_incremental) {
+        if (!system->ef_static_cache) {
+            system->ef_static_cache = calloc(1, sizeof(ef_static_cache_t));
+            memnullcheck(system->ef_static_cache, sizeof(ef_static_cache_t), __LINE__ - 1, __FILE__);
+        }
+        if (thole_field_update(system)) return;
+
+        /* a full sum below, which a rejected move can't undo */
+        if (system->ef_static_cache->pending) system->ef_static_cache->rebuilt = 1;
+        system->ef_static_cache->pending = 0;
+        system->ef_static_cache->valid = 1;
+        system->ef_static_cache->updates = 0;
+    }
+
     /* zero the field vectors */
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
@@ -26,6 +217,9 @@ void thole_field(system_t *system) {
         }
     }
 
+    /* the frozen atoms' field at the mobile ones */
+    if (system->polar_field_grid) polar_field_grid_field(system);
+
     /* calculate the electrostatic field */
     if (system->polar_ewald)
         ewald_estatic(system);
@@ -40,22 +234,25 @@ void thole_field_nopbc(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
     pair_t *pair_ptr;
-    int p;
+    int k;
+    int p, field_atom, field_pair;
     double r;
 
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
                 if (pair_ptr->frozen) continue;
                 if (molecule_ptr == pair_ptr->molecule) continue;  //don't let molecules polarize themselves
+                if (thole_field_grid_ends(system, atom_ptr, pair_ptr->atom, &field_atom, &field_pair)) continue;
 
-                r = pair_ptr->rimg;
+                r = atom_ptr->pair_rimg[k];
 
                 //inclusive near the cutoff
                 if ((r - SMALL_dR < system->pbc->cutoff) && (r != 0.)) {
                     for (p = 0; p < 3; p++) {
-                        atom_ptr->ef_static[p] += pair_ptr->atom->charge * pair_ptr->dimg[p] / (r * r * r);
-                        pair_ptr->atom->ef_static[p] -= atom_ptr->charge * pair_ptr->dimg[p] / (r * r * r);
+                        if (field_atom) atom_ptr->ef_static[p] += pair_ptr->atom->charge * atom_ptr->pair_dimg[3 * k + p] / (r * r * r);
+                        if (field_pair) pair_ptr->atom->ef_static[p] -= atom_ptr->charge * atom_ptr->pair_dimg[3 * k + p] / (r * r * r);
                     }
 
                 } /* cutoff */
@@ -72,7 +269,9 @@ void thole_field_wolf(system_t *system) {
     molecule_t *molecule_ptr;
     atom_t *atom_ptr;
     pair_t *pair_ptr;
+    int k;
     int p;         //dimensionality
+    int field_atom, field_pair;
     double r, rr;  //r and 1/r (reciprocal of r)
     double R = system->pbc->cutoff;
     double rR = 1. / R;
@@ -89,11 +288,13 @@ void thole_field_wolf(system_t *system) {
 
     for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next) {
         for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) {
-            for (pair_ptr = atom_ptr->pairs; pair_ptr; pair_ptr = pair_ptr->next) {
+            for (k = 0; k < atom_ptr->npairs; k++) {
+                pair_ptr = &atom_ptr->pairs[k];
                 if (molecule_ptr == pair_ptr->molecule) continue;  //don't let molecules polarize themselves
                 if (pair_ptr->frozen) continue;                    //don't let the MOF polarize itself
+                if (thole_field_grid_ends(system, atom_ptr, pair_ptr->atom, &field_atom, &field_pair)) continue;
 
-                r = pair_ptr->rimg;
+                r = atom_ptr->pair_rimg[k];
 
                 if ((r - SMALL_dR < system->pbc->cutoff) && (r != 0.)) {
                     rr = 1. / r;
@@ -107,11 +308,11 @@ void thole_field_wolf(system_t *system) {
                     for (p = 0; p < 3; p++) {
                         //see JCP 124 (234104)
                         if (a == 0) {
-                            atom_ptr->ef_static[p] += (pair_ptr->atom->charge) * (rr * rr - rR * rR) * pair_ptr->dimg[p] * rr;
-                            pair_ptr->atom->ef_static[p] -= (atom_ptr->charge) * (rr * rr - rR * rR) * pair_ptr->dimg[p] * rr;
+                            if (field_atom) atom_ptr->ef_static[p] += (pair_ptr->atom->charge) * (rr * rr - rR * rR) * atom_ptr->pair_dimg[3 * k + p] * rr;
+                            if (field_pair) pair_ptr->atom->ef_static[p] -= (atom_ptr->charge) * (rr * rr - rR * rR) * atom_ptr->pair_dimg[3 * k + p] * rr;
                         } else {
-                            atom_ptr->ef_static[p] += pair_ptr->atom->charge * (bigmess - cutoffterm) * pair_ptr->dimg[p] * rr;
-                            pair_ptr->atom->ef_static[p] -= atom_ptr->charge * (bigmess - cutoffterm) * pair_ptr->dimg[p] * rr;
+                            if (field_atom) atom_ptr->ef_static[p] += pair_ptr->atom->charge * (bigmess - cutoffterm) * atom_ptr->pair_dimg[3 * k + p] * rr;
+                            if (field_pair) pair_ptr->atom->ef_static[p] -= atom_ptr->charge * (bigmess - cutoffterm) * atom_ptr->pair_dimg[3 * k + p] * rr;
                         }
                     }
 
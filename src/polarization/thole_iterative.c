@@ -16,33 +16,209 @@ void init_dipoles(system_t *system) {
 
     for (i = 0; i < system->natoms; i++) {
         for (p = 0; p < 3; p++) {
+            // with polar_warm_start, only the change of the static field since the last accept is added in
+            // atoms that were never accepted (inserted molecules have both zeroed in make_move) get alpha*E_static
             aa[i]->mu[p] = aa[i]->polarizability * (aa[i]->ef_static[p] + aa[i]->ef_static_self[p]);
+            if (system->polar_warm_start) aa[i]->mu[p] -= aa[i]->polarizability * aa[i]->ef_static_last[p];
             // should improve convergence since mu's typically grow as induced fields are added in
             if (!system->polar_sor && !system->polar_esor) aa[i]->mu[p] *= system->polar_gamma;
+            if (system->polar_warm_start) aa[i]->mu[p] += aa[i]->mu_last[p];
         }
     }
     return;
 }
 
+/* the configuration was accepted, keep its dipoles as the starting point of the next solve */
+/* must come before checkpoint(), so that the backup of the next move carries them */
+void polar_warm_start_accept(system_t *system) {
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+    int p;
+
+    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            for (p = 0; p < 3; p++) {
+                atom_ptr->mu_last[p] = atom_ptr->mu[p];
+                atom_ptr->ef_static_last[p] = atom_ptr->ef_static[p] + atom_ptr->ef_static_self[p];
+            }
+
+    return;
+}
+
+/* subtract the field of the other dipoles at atom index, from the row of the sparse tensor */
+static void sparse_row_field(system_t *system, int index, double *field) {
+    amatrix_sparse_t *A = system->A_sparse;
+    polar_sites_t *sites = system->A_sites;
+    atom_t **aa = system->atom_array;
+    double *T, *mu;
+    int b, row = sites->site[index];
+
+    for (b = A->row[row]; b < A->row[row + 1]; b++) {
+        T = &A->block[9 * b];
+        mu = aa[sites->atom[A->col[b]]]->mu;
+        field[0] -= T[0] * mu[0] + T[1] * mu[1] + T[2] * mu[2];
+        field[1] -= T[3] * mu[0] + T[4] * mu[1] + T[5] * mu[2];
+        field[2] -= T[6] * mu[0] + T[7] * mu[1] + T[8] * mu[2];
+    }
+}
+
+/* the rows of the A matrix, or the sparse tensor, against the dipoles of the sites packed into one vector */
+/* every atom's field only reads the packed dipoles, so the atoms are spread over the threads */
+typedef struct _contraction {
+    double *mu;  /* [3 sites] dipoles as they were when the contraction started */
+    int change;  /* palmo: the field goes to ef_induced_change, and the dipoles are left alone */
+    int *atoms;  /* the atoms of the color being updated, with polar_gs_color */
+} contraction_t;
+
+/* f = sum_k a_k x_k for three rows of A at once, so each x_k is loaded once */
+/* two independent partial sums per row let the compiler keep the loop in vector registers */
+static void contract_rows(double *a0, double *a1, double *a2, double *x, int n, double *f) {
+    double s00 = 0, s01 = 0, s10 = 0, s11 = 0, s20 = 0, s21 = 0;
+    int k;
+
+    for (k = 0; k + 1 < n; k += 2) {
+        s00 += a0[k] * x[k];
+        s01 += a0[k + 1] * x[k + 1];
+        s10 += a1[k] * x[k];
+        s11 += a1[k + 1] * x[k + 1];
+        s20 += a2[k] * x[k];
+        s21 += a2[k + 1] * x[k + 1];
+    }
+    if (k < n) {
+        s00 += a0[k] * x[k];
+        s10 += a1[k] * x[k];
+        s20 += a2[k] * x[k];
+    }
+
+    f[0] += s00 + s01;
+    f[1] += s10 + s11;
+    f[2] += s20 + s21;
+}
+
+/* the field of the other dipoles at atom i */
+static void contract_atom(system_t *system, int i, void *arg, double *unused) {
+    contraction_t *c = arg;
+    atom_t *atom_ptr = system->atom_array[i];
+    amatrix_sparse_t *A;
+    double **a = system->A_matrix;
+    double f[3] = {0, 0, 0}, *T, *mu, *field;
+    int b, p, ii, N, si = system->A_sites->site[i];
+
+    if (!c->change && (atom_ptr->polarizability == 0)) {
+        atom_ptr->new_mu[0] = atom_ptr->new_mu[1] = atom_ptr->new_mu[2] = 0;
+        atom_ptr->mu[0] = atom_ptr->mu[1] = atom_ptr->mu[2] = 0;
+        return;
+    }
+
+    /* an atom without a site has no rows, and no field from the other dipoles */
+    if ((si >= 0) && system->polar_sparse) {
+        A = system->A_sparse;
+        for (b = A->row[si]; b < A->row[si + 1]; b++) {
+            T = &A->block[9 * b];
+            mu = &c->mu[3 * A->col[b]];
+            f[0] += T[0] * mu[0] + T[1] * mu[1] + T[2] * mu[2];
+            f[1] += T[3] * mu[0] + T[4] * mu[1] + T[5] * mu[2];
+            f[2] += T[6] * mu[0] + T[7] * mu[1] + T[8] * mu[2];
+        }
+    } else if (si >= 0) {
+        /* skip the diagonal block */
+        ii = 3 * si;
+        N = 3 * system->A_sites->n;
+        contract_rows(a[ii], a[ii + 1], a[ii + 2], c->mu, ii, f);
+        contract_rows(a[ii] + ii + 3, a[ii + 1] + ii + 3, a[ii + 2] + ii + 3, c->mu + ii + 3, N - ii - 3, f);
+    }
+
+    field = c->change ? atom_ptr->ef_induced_change : atom_ptr->ef_induced;
+    for (p = 0; p < 3; p++) field[p] -= f[p];
+
+    if (!c->change)
+        for (p = 0; p < 3; p++)
+            atom_ptr->new_mu[p] = atom_ptr->polarizability * (atom_ptr->ef_static[p] + atom_ptr->ef_static_self[p] + atom_ptr->ef_induced[p]);
+}
+
+static void contract_packed(system_t *system, int change) {
+    contraction_t c;
+    atom_t **aa = system->atom_array;
+    int i, N = system->natoms;
+
+    c.mu = malloc(3 * N * sizeof(double));
+    memnullcheck(c.mu, 3 * N * sizeof(double), __LINE__ - 1, __FILE__);
+    for (i = 0; i < system->A_sites->n; i++) memcpy(&c.mu[3 * i], aa[system->A_sites->atom[i]]->mu, 3 * sizeof(double));
+    c.change = change;
+
+    thread_sum(system, N, contract_atom, &c);
+
+    free(c.mu);
+}
+
+static void contract_color_atom(system_t *system, int k, void *arg, double *unused) {
+    contraction_t *c = arg;
+
+    contract_atom(system, c->atoms[k], arg, unused);
+}
+
+/* multicolor gauss-seidel, see polar_gs_color.c - one color at a time, its atoms over the threads */
+static void contract_colored(system_t *system) {
+    polar_colors_t *pc = system->polar_colors;
+    contraction_t c;
+    atom_t **aa = system->atom_array;
+    int i, k, p, n, N = system->natoms;
+
+    c.mu = malloc(3 * N * sizeof(double));
+    memnullcheck(c.mu, 3 * N * sizeof(double), __LINE__ - 1, __FILE__);
+    for (i = 0; i < system->A_sites->n; i++) memcpy(&c.mu[3 * i], aa[system->A_sites->atom[i]]->mu, 3 * sizeof(double));
+    c.change = 0;
+
+    for (k = 0; k < pc->ncolors; k++) {
+        c.atoms = &pc->atoms[pc->first[k]];
+        thread_sum(system, pc->first[k + 1] - pc->first[k], contract_color_atom, &c);
+
+        /* the colors that follow see the new dipoles */
+        for (n = pc->first[k]; n < pc->first[k + 1]; n++) {
+            i = pc->atoms[n];
+            for (p = 0; p < 3; p++) aa[i]->mu[p] = aa[i]->new_mu[p];
+            if (system->A_sites->site[i] >= 0)
+                memcpy(&c.mu[3 * system->A_sites->site[i]], aa[i]->mu, 3 * sizeof(double));
+        }
+    }
+
+    free(c.mu);
+}
+
 void contract_dipoles(system_t *system, int *ranked_array) {
-    int i, j, ii, jj, p, index;
+    int i, j, ii, s, p, index;
     atom_t **aa = system->atom_array;
+    polar_sites_t *sites = system->A_sites;
+
+    /* without gauss-seidel, every dipole is updated from the old ones */
+    if (!(system->polar_gs || system->polar_gs_ranked)) {
+        contract_packed(system, 0);
+        return;
+    }
+    if (system->polar_gs_color) {
+        contract_colored(system);
+        return;
+    }
 
     for (i = 0; i < system->natoms; i++) {
         index = ranked_array[i];  //do them in the order of the ranked index
-        ii = index * 3;
         if (aa[index]->polarizability == 0) {  //if not polar
             //aa[index]->ef_induced[p] is already 0
             aa[index]->new_mu[0] = aa[index]->new_mu[1] = aa[index]->new_mu[2] = 0;  //might be redundant?
             aa[index]->mu[0] = aa[index]->mu[1] = aa[index]->mu[2] = 0;              //might be redundant?
             continue;
         }
-        for (j = 0; j < system->natoms; j++) {
-            jj = j * 3;
-            if (index != j)
-                for (p = 0; p < 3; p++)
-                    aa[index]->ef_induced[p] -= dddotprod((system->A_matrix[ii + p] + jj), aa[j]->mu);
-        } /* end j */
+        if (system->polar_sparse)
+            sparse_row_field(system, index, aa[index]->ef_induced);
+        else {
+            ii = 3 * sites->site[index];
+            for (s = 0; s < sites->n; s++) {
+                j = sites->atom[s];
+                if (index != j)
+                    for (p = 0; p < 3; p++)
+                        aa[index]->ef_induced[p] -= dddotprod((system->A_matrix[ii + p] + 3 * s), aa[j]->mu);
+            } /* end j */
+        }
 
         /* dipole is the sum of the static and induced parts */
         for (p = 0; p < 3; p++) {
@@ -117,47 +293,50 @@ int are_we_done_yet(system_t *system, int iteration_counter) {
 }
 
 void palmo_contraction(system_t *system, int *ranked_array) {
-    int i, j, ii, jj, index, p;
+    int i, p;
     int N = system->natoms;
     atom_t **aa = system->atom_array;
 
     /* calculate change in induced field due to this iteration */
-    for (i = 0; i < N; i++) {
-        index = ranked_array[i];
-        ii = index * 3;
-
+    for (i = 0; i < N; i++)
         for (p = 0; p < 3; p++)
-            aa[index]->ef_induced_change[p] = -aa[index]->ef_induced[p];
+            aa[i]->ef_induced_change[p] = -aa[i]->ef_induced[p];
 
-        for (j = 0; j < N; j++) {
-            jj = j * 3;
-            if (index != j)
-                for (p = 0; p < 3; p++)
-                    aa[index]->ef_induced_change[p] -= dddotprod(system->A_matrix[ii + p] + jj, aa[j]->mu);
-        }
-    }
+    contract_packed(system, 1);
 
     return;
 }
 
+/* descending rank_metric, ties kept in atom order */
+typedef struct _rank {
+    double metric;
+    int index;
+} rank_t;
+
+static int compare_rank(const void *a, const void *b) {
+    const rank_t *ra = a, *rb = b;
+
+    if (ra->metric != rb->metric) return ((ra->metric < rb->metric) ? 1 : -1);
+    return (ra->index - rb->index);
+}
+
+/* rank_metric is fixed for the configuration (see pairs.c), so the ranking is sorted once per solve */
 void update_ranking(system_t *system, int *ranked_array) {
-    int i, j, sorted, tmp;
+    int i;
     int N = system->natoms;
     atom_t **aa = system->atom_array;
+    rank_t *rank;
 
-    /* rank the dipoles by bubble sort */
     if (system->polar_gs_ranked) {
+        rank = malloc(N * sizeof(rank_t));
+        memnullcheck(rank, N * sizeof(rank_t), __LINE__ - 1, __FILE__);
         for (i = 0; i < N; i++) {
-            for (j = 0, sorted = 1; j < (N - 1); j++) {
-                if (aa[ranked_array[j]]->rank_metric < aa[ranked_array[j + 1]]->rank_metric) {
-                    sorted = 0;
-                    tmp = ranked_array[j];
-                    ranked_array[j] = ranked_array[j + 1];
-                    ranked_array[j + 1] = tmp;
-                }
-            }
-            if (sorted) break;
+            rank[i].metric = aa[ranked_array[i]]->rank_metric;
+            rank[i].index = ranked_array[i];
         }
+        qsort(rank, N, sizeof(rank_t), compare_rank);
+        for (i = 0; i < N; i++) ranked_array[i] = rank[i].index;
+        free(rank);
     }
 
     return;
@@ -167,7 +346,7 @@ void update_ranking(system_t *system, int *ranked_array) {
 /* returns the number of iterations required */
 int thole_iterative(system_t *system) {
     int i, N, p;
-    int iteration_counter, keep_iterating;
+    int iteration_counter, keep_iterating, ranked;
     atom_t **aa;  //atom array
     int *ranked_array;
 
@@ -181,6 +360,7 @@ int thole_iterative(system_t *system) {
 
     //set all dipoles to alpha*E_static * polar_gamma
     init_dipoles(system);
+    if (system->polar_anderson) polar_anderson_reset(system);
 
     /* if ZODID is enabled, then stop here and just return the alpha*E dipoles */
     if (system->polar_zodid) {
@@ -188,6 +368,16 @@ int thole_iterative(system_t *system) {
         return (0);
     }
 
+    /* the atoms colored for this solve are taken in its ranking, which is then fixed for the solve */
+    ranked = 0;
+    if (system->polar_gs_color) {
+        if (system->polar_gs_ranked) {
+            update_ranking(system, ranked_array);
+            ranked = 1;
+        }
+        polar_gs_color_setup(system, ranked_array);
+    }
+
     /* iterative solver of the dipole field equations */
     keep_iterating = 1;
     iteration_counter = 0;
@@ -215,7 +405,7 @@ int thole_iterative(system_t *system) {
                 aa[i]->ef_induced[p] = 0;
 
         //save the current dipole information if we want to calculate precision (or if needed for relaxation)
-        if (system->polar_rrms || system->polar_precision > 0 || system->polar_sor || system->polar_esor) {
+        if (system->polar_rrms || system->polar_precision > 0 || system->polar_sor || system->polar_esor || system->polar_anderson) {
             for (i = 0; i < N; i++)
                 for (p = 0; p < 3; p++)
                     aa[i]->old_mu[p] = aa[i]->mu[p];
@@ -234,11 +424,17 @@ int thole_iterative(system_t *system) {
         if (system->polar_palmo && !keep_iterating)
             palmo_contraction(system, ranked_array);
 
-        //new gs_ranking if needed
-        if (system->polar_gs_ranked && keep_iterating)
+        //gs_ranking after the first pass, if needed
+        if (system->polar_gs_ranked && keep_iterating && !ranked) {
             update_ranking(system, ranked_array);
+            ranked = 1;
+        }
 
-        /* save the dipoles for the next pass */
+        /* save the dipoles for the next pass - extrapolated from the last few with anderson mixing */
+        if (system->polar_anderson && keep_iterating) {
+            polar_anderson_mix(system);
+            continue;
+        }
         for (i = 0; i < N; i++) {
             for (p = 0; p < 3; p++) {
                 /* allow for different successive over-relaxation schemes */
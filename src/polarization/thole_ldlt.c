@@ -0,0 +1,185 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* the matrix-inversion solver only needs B E, so rather than forming B = A^-1 the symmetric A is factored */
+/* as L D L^T and the dipoles follow from two triangular solves - about a sixth of the flops of the LU inverse */
+/* the factor is kept in its own contiguous array so that A stays intact */
+/* with LAPACK linked in (VDW or QM_ROTATION builds) the Bunch-Kaufman dsytrf/dsytrs pair is used, */
+/* otherwise a cache-blocked factorization without pivoting, which A (positive definite short of a */
+/* polarization catastrophe) does not need */
+
+#if defined(VDW) || defined(QM_ROTATION)
+extern void dsytrf_(char *, int *, double *, int *, int *, double *, int *, int *);
+extern void dsytrs_(char *, int *, int *, double *, int *, int *, double *, int *, int *);
+#endif
+
+/* (re)allocate the factor for an n x n matrix */
+static void ldlt_setup(ldlt_t **factor, int n) {
+    ldlt_t *f = *factor;
+
+    if (!f) {
+        f = *factor = calloc(1, sizeof(ldlt_t));
+        memnullcheck(f, sizeof(ldlt_t), __LINE__ - 1, __FILE__);
+    }
+
+    if (n > f->max_n) {
+        free(f->a);
+        free(f->w);
+        free(f->ipiv);
+        f->max_n = n;
+        f->a = malloc(n * n * sizeof(double));
+        memnullcheck(f->a, n * n * sizeof(double), __LINE__ - 1, __FILE__);
+        f->w = malloc(n * LDLT_BLOCK * sizeof(double));
+        memnullcheck(f->w, n * LDLT_BLOCK * sizeof(double), __LINE__ - 1, __FILE__);
+        f->ipiv = malloc(n * sizeof(int));
+        memnullcheck(f->ipiv, n * sizeof(int), __LINE__ - 1, __FILE__);
+    }
+    f->n = n;
+}
+
+#if !(defined(VDW) || defined(QM_ROTATION))
+/* panel of the block being eliminated, for the update of the rows below it */
+typedef struct _ldlt_block {
+    double *a, *w;
+    int n, k0, k1;
+} ldlt_block_t;
+
+/* take the block columns k0..k1 out of row i >= k1 of the trailing matrix */
+static void thole_ldlt_update_row(system_t *system, int index, void *arg, double *unused) {
+    ldlt_block_t *b = arg;
+    int i = b->k1 + index;
+    int nb = b->k1 - b->k0;
+    double *wi = &b->w[i * LDLT_BLOCK];
+    double *ai = &b->a[i * b->n];
+    double *lj, sum;
+    int j, k;
+
+    for (j = b->k1; j <= i; j++) {
+        lj = &b->a[j * b->n + b->k0];
+        for (k = 0, sum = 0; k < nb; k++) sum += wi[k] * lj[k];
+        ai[j] -= sum;
+    }
+}
+
+/* right-looking blocked L D L^T of the lower triangle of a, L (unit diagonal) and D overwrite it */
+static void thole_ldlt_blocked(system_t *system, ldlt_t *f) {
+    ldlt_block_t b;
+    double *a = f->a, *w = f->w;
+    double d, sum;
+    int n = f->n;
+    int i, j, k;
+
+    b.a = a;
+    b.w = w;
+    b.n = n;
+
+    for (b.k0 = 0; b.k0 < n; b.k0 += LDLT_BLOCK) {
+        b.k1 = (b.k0 + LDLT_BLOCK < n) ? b.k0 + LDLT_BLOCK : n;
+
+        /* the panel, one column at a time - w holds L D for the trailing update */
+        for (j = b.k0; j < b.k1; j++) {
+            for (k = b.k0, d = a[j * n + j]; k < j; k++) d -= w[j * LDLT_BLOCK + k - b.k0] * a[j * n + k];
+            if (d == 0.0) {
+                /* singular - go on with a tiny pivot, as LU_decomp() does for the inversion */
+                output(
+                    "THOLE_LDLT: zero pivot, the matrix is singular\n");
+                d = 1.0e-20;
+            }
+            a[j * n + j] = d;
+
+            for (i = j + 1; i < n; i++) {
+                for (k = b.k0, sum = a[i * n + j]; k < j; k++) sum -= w[i * LDLT_BLOCK + k - b.k0] * a[j * n + k];
+                w[i * LDLT_BLOCK + j - b.k0] = sum;
+                a[i * n + j] = sum / d;
+            }
+        }
+
+        /* the rows below the panel */
+        if (b.k1 < n) thread_sum(system, n - b.k1, thole_ldlt_update_row, &b);
+    }
+}
+#endif /* !(VDW || QM_ROTATION) */
+
+/* factor the symmetric n x n matrix a into *factor */
+void ldlt_factor(system_t *system, ldlt_t **factor, double **a, int n) {
+    ldlt_t *f;
+    int i;
+#if defined(VDW) || defined(QM_ROTATION)
+    char uplo = 'L';
+    int lwork, info;
+    double *work, size;
+#endif
+
+    ldlt_setup(factor, n);
+    f = *factor;
+    for (i = 0; i < n; i++)
+        memcpy(&f->a[i * n], a[i], n * sizeof(double));
+
+#if defined(VDW) || defined(QM_ROTATION)
+    /* a is symmetric, so row-major is column-major */
+    lwork = -1;
+    dsytrf_(&uplo, &n, f->a, &n, f->ipiv, &size, &lwork, &info);
+    lwork = (int)size;
+    work = malloc(lwork * sizeof(double));
+    memnullcheck(work, lwork * sizeof(double), __LINE__ - 1, __FILE__);
+    dsytrf_(&uplo, &n, f->a, &n, f->ipiv, work, &lwork, &info);
+    free(work);
+    if (info < 0) {
+        error(
+            "THOLE_LDLT: LAPACK dsytrf failed\n");
+        die(-1);
+    } else if (info > 0) {
+        /* D(info,info) is exactly zero - go on with a tiny pivot, as LU_decomp() does for the inversion */
+        output(
+            "THOLE_LDLT: zero pivot, the matrix is singular\n");
+        f->a[(info - 1) * n + (info - 1)] = 1.0e-20;
+    }
+#else
+    thole_ldlt_blocked(system, f);
+#endif
+}
+
+/* overwrite b with a^-1 b, from the factor */
+void ldlt_solve(ldlt_t *f, double *b) {
+    double *a = f->a;
+    int n = f->n;
+#if defined(VDW) || defined(QM_ROTATION)
+    char uplo = 'L';
+    int nrhs = 1, info;
+
+    dsytrs_(&uplo, &n, &nrhs, a, &n, f->ipiv, b, &n, &info);
+#else
+    double sum;
+    int i, j;
+
+    /* L y = b */
+    for (i = 0; i < n; i++) {
+        for (j = 0, sum = b[i]; j < i; j++) sum -= a[i * n + j] * b[j];
+        b[i] = sum;
+    }
+
+    /* D z = y */
+    for (i = 0; i < n; i++) b[i] /= a[i * n + i];
+
+    /* L^T x = z, a row of L at a time */
+    for (j = n - 1; j > 0; j--)
+        for (i = 0; i < j; i++) b[i] -= a[j * n + i] * b[j];
+#endif
+}
+
+/* factor the n x n A matrix */
+void thole_ldlt_factor(system_t *system, int n) {
+    ldlt_factor(system, &system->A_ldlt, system->A_matrix, n);
+}
+
+/* overwrite b with A^-1 b */
+void thole_ldlt_solve(system_t *system, double *b) {
+    ldlt_solve(system->A_ldlt, b);
+}
@@ -34,11 +34,24 @@ void zero_out_amatrix(system_t *system, int N) {
     return;
 }
 
-/* calculate the dipole field tensor */
-void thole_amatrix(system_t *system) {
-    int i, j, ii, jj, N, p, q;
-    atom_t **atom_array;
-    pair_t *pair_ptr;
+/* with polar_schur, the frozen-frozen block isn't rebuilt - only the rows and columns of the mobile sites are cleared */
+static void zero_out_amatrix_mobile(system_t *system) {
+    polar_sites_t *sites = system->A_sites;
+    double **A = system->A_matrix;
+    int s, i, j, p, n = 3 * sites->n;
+
+    for (s = 0; s < sites->n; s++) {
+        if (system->atom_array[sites->atom[s]]->frozen) continue;
+        for (p = 0; p < 3; p++)
+            for (j = 0; j < n; j++) A[3 * s + p][j] = 0;
+        for (i = 0; i < n; i++)
+            for (p = 0; p < 3; p++) A[i][3 * s + p] = 0;
+    }
+}
+
+/* the damped dipole field tensor Tij of atom i and atom j, its k-th pair */
+static void thole_tensor(system_t *system, atom_t *atom_i, atom_t *atom_j, int k, double T[3][3]) {
+    int p, q;
     double damp1 = 0, damp2 = 0, wdamp1 = 0, wdamp2 = 0, v, s;
     double r, r2, ir3, ir5, ir = 0;
     double rcut, rcut2, rcut3;
@@ -51,16 +64,214 @@ void thole_amatrix(system_t *system) {
     l3 = l2 * l;
     double explr;  //exp(-l*r)
     double explrcut = exp(-l * rcut);
+    double *dimg = &atom_i->pair_dimg[3 * k];
+
+    r = atom_i->pair_rimg[k];
+    r2 = r * r;
+
+    /* inverse displacements */
+    if (r == 0.)
+        ir3 = ir5 = MAXVALUE;
+    else {
+        ir = 1.0 / r;
+        ir3 = ir * ir * ir;
+        ir5 = ir3 * ir * ir;
+    }
+
+    //evaluate damping factors
+    switch (system->damp_type) {
+        case DAMPING_OFF:
+            if (atom_i->pairs[k].es_excluded)
+                damp1 = damp2 = wdamp1 = wdamp2 = 0.0;
+            else
+                damp1 = damp2 = wdamp1 = wdamp2 = 1.0;
+            break;
+        case DAMPING_LINEAR:
+            s = l * pow(atom_i->polarizability * atom_j->polarizability, 1.0 / 6.0);
+            v = r / s;
+            if (r < s) {
+                damp1 = (4.0 - 3.0 * v) * v * v * v;
+                damp2 = v * v * v * v;
+            } else {
+                damp1 = damp2 = 1.0;
+            }
+            break;
+        case DAMPING_EXPONENTIAL:
+            explr = exp(-l * r);
+            damp1 = 1.0 - explr * (0.5 * l2 * r2 + l * r + 1.0);
+            damp2 = damp1 - explr * (l3 * r2 * r / 6.0);
+            if (system->polar_wolf_full) {  //subtract off damped interaction at r_cutoff
+                wdamp1 = 1.0 - explrcut * (0.5 * l2 * rcut2 + l * rcut + 1.0);
+                wdamp2 = wdamp1 - explrcut * (l3 * rcut3 / 6.0);
+            }
+            break;
+        default:
+            error(
+                "error: something unexpected happened in thole_matrix.c");
+    }
+
+    /* build the tensor */
+    for (p = 0; p < 3; p++) {
+        for (q = 0; q < 3; q++) {
+            T[p][q] = -3.0 * dimg[p] * dimg[q] * damp2 * ir5;
+            if (system->polar_wolf_full)
+                T[p][q] -= -3.0 * dimg[p] * dimg[q] * wdamp2 * ir * ir / rcut3;
+
+            /* additional diagonal term */
+            if (p == q) {
+                T[p][q] += damp1 * ir3;
+                if (system->polar_wolf_full) T[p][q] -= wdamp1 / (rcut3);
+            }
+        }
+    }
+}
+
+/* make room for nnz blocks in the sparse tensor, keeping those already filled */
+static void thole_amatrix_sparse_grow(amatrix_sparse_t *A, int nnz) {
+    A->max_nnz = (nnz > 2 * A->max_nnz) ? nnz : 2 * A->max_nnz;
+    A->col = realloc(A->col, A->max_nnz * sizeof(int));
+    memnullcheck(A->col, A->max_nnz * sizeof(int), __LINE__ - 1, __FILE__);
+    A->block = realloc(A->block, 9 * A->max_nnz * sizeof(double));
+    memnullcheck(A->block, 9 * A->max_nnz * sizeof(double), __LINE__ - 1, __FILE__);
+}
+
+/* calculate the dipole field tensor as 3x3 blocks, keeping only the pairs of polarizable sites within polar_sparse_cutoff */
+/* both Tij and Tji are stored, so that every row holds all of its blocks in order of the column - the rows and */
+/* columns are those of A_sites, and the rows are filled in a single pass over the pairs: row i computes its blocks */
+/* with the sites after it, and takes those with the sites before it from their rows, where they are already */
+static void thole_amatrix_sparse(system_t *system) {
+    amatrix_sparse_t *A;
+    atom_t **atom_array, *atom_i, *atom_j;
+    int i, j, k, b, n, *atom;
+    double cutoff, T[3][3];
+
+    atom_array = system->atom_array;
+    n = system->A_sites->n;
+    atom = system->A_sites->atom;
+    cutoff = (system->polar_sparse_cutoff > 0) ? system->polar_sparse_cutoff : system->pbc->cutoff;
+
+    if (!system->A_sparse) {
+        system->A_sparse = calloc(1, sizeof(amatrix_sparse_t));
+        memnullcheck(system->A_sparse, sizeof(amatrix_sparse_t), __LINE__ - 1, __FILE__);
+    }
+    A = system->A_sparse;
+
+    /* grow the row arrays geometrically as atoms are inserted */
+    if (n > A->max_N) {
+        A->max_N = (n > 2 * A->max_N) ? n : 2 * A->max_N;
+        free(A->row);
+        free(A->diag);
+        free(A->next);
+        A->row = malloc((A->max_N + 1) * sizeof(int));
+        memnullcheck(A->row, (A->max_N + 1) * sizeof(int), __LINE__ - 1, __FILE__);
+        A->diag = malloc(A->max_N * sizeof(double));
+        memnullcheck(A->diag, A->max_N * sizeof(double), __LINE__ - 1, __FILE__);
+        A->next = malloc(A->max_N * sizeof(int));
+        memnullcheck(A->next, A->max_N * sizeof(int), __LINE__ - 1, __FILE__);
+    }
+    A->N = n;
+
+    for (i = 0, b = 0; i < n; i++) {
+        atom_i = atom_array[atom[i]];
+        A->row[i] = b;
+
+        /* the diagonal blocks are 1/alpha times the identity, a site without polarizability has no others */
+        if (atom_i->polarizability == 0.0) {
+            A->diag[i] = MAXVALUE;
+            A->next[i] = b;
+            continue;
+        }
+        A->diag[i] = 1.0 / atom_i->polarizability;
+
+        /* Tji of the sites before, the tensor is symmetric in i and j */
+        for (j = 0; j < i; j++) {
+            if ((A->next[j] == A->row[j + 1]) || (A->col[A->next[j]] != i)) continue;
+            if (b == A->max_nnz) thole_amatrix_sparse_grow(A, b + 1);
+            A->col[b] = j;
+            memcpy(&A->block[9 * b++], &A->block[9 * A->next[j]++], 9 * sizeof(double));
+        }
+        A->next[i] = b;
+
+        /* and Tij of those after, in the pairs of atom i */
+        for (j = (i + 1); j < n; j++) {
+            atom_j = atom_array[atom[j]];
+            k = atom[j] - atom[i] - 1;
+            if ((atom_j->polarizability == 0.0) || (atom_i->pair_rimg[k] > cutoff)) continue;
+            thole_tensor(system, atom_i, atom_j, k, T);
+
+            if (b == A->max_nnz) thole_amatrix_sparse_grow(A, b + 1);
+            A->col[b] = j;
+            memcpy(&A->block[9 * b++], T, 9 * sizeof(double));
+        }
+    }
+    A->row[n] = b;
+    A->nnz = b;
+}
+
+/* whether the atom has rows in the dense A matrix - only the polarizable ones, unless */
+/* the whole tensor is wanted (polarizability_tensor, and the coupled-dipole vdw) */
+int thole_site(system_t *system, atom_t *atom_ptr) {
+    return ((atom_ptr->polarizability != 0.0) || system->polarizability_tensor || system->polarvdw || system->disp_expansion_mbvdw);
+}
+
+/* map the atom array onto the sites, in the same order */
+static void thole_sites(system_t *system) {
+    polar_sites_t *sites;
+    int i;
+
+    if (!system->A_sites) {
+        system->A_sites = calloc(1, sizeof(polar_sites_t));
+        memnullcheck(system->A_sites, sizeof(polar_sites_t), __LINE__ - 1, __FILE__);
+    }
+    sites = system->A_sites;
+
+    if (system->natoms > sites->max_atoms) {
+        sites->max_atoms = (system->natoms > 2 * sites->max_atoms) ? system->natoms : 2 * sites->max_atoms;
+        free(sites->site);
+        sites->site = malloc(2 * sites->max_atoms * sizeof(int));
+        memnullcheck(sites->site, 2 * sites->max_atoms * sizeof(int), __LINE__ - 1, __FILE__);
+        sites->atom = sites->site + sites->max_atoms;
+    }
+
+    for (i = 0, sites->n = 0; i < system->natoms; i++) {
+        if (thole_site(system, system->atom_array[i])) {
+            sites->atom[sites->n] = i;
+            sites->site[i] = sites->n++;
+        } else
+            sites->site[i] = -1;
+    }
+}
+
+/* calculate the dipole field tensor, over the polarizable sites */
+void thole_amatrix(system_t *system) {
+    int i, j, k, ii, jj, N, p, q, skip_frozen;
+    atom_t **atom_array;
+    int *site;
+    double T[3][3];
+
+    if (system->polar_sparse) {
+        thole_sites(system);
+        thole_amatrix_sparse(system);
+        return;
+    }
 
     //array of atoms generated in pairs.c
     atom_array = system->atom_array;
     N = system->natoms;
+    thole_sites(system);
+    site = system->A_sites->site;
+    /* with polar_schur, the frozen-frozen block is only needed the first time */
+    skip_frozen = system->polar_schur && system->A_schur;
 
-    zero_out_amatrix(system, N);
+    if (skip_frozen)
+        zero_out_amatrix_mobile(system);
+    else
+        zero_out_amatrix(system, system->A_sites->n);
 
     /* set the diagonal blocks */
     for (i = 0; i < N; i++) {
-        ii = i * 3;
+        if (site[i] < 0) continue;
+        ii = site[i] * 3;
         for (p = 0; p < 3; p++) {
             if (atom_array[i]->polarizability != 0.0)
                 system->A_matrix[ii + p][ii + p] = 1.0 / atom_array[i]->polarizability;
@@ -71,73 +282,19 @@ void thole_amatrix(system_t *system) {
 
     /* calculate each Tij tensor component for each dipole pair */
     for (i = 0; i < (N - 1); i++) {
-        ii = i * 3;
-        for (j = (i + 1), pair_ptr = atom_array[i]->pairs; j < N; j++, pair_ptr = pair_ptr->next) {
-            jj = j * 3;
-
-            r = pair_ptr->rimg;
-            r2 = r * r;
-
-            /* inverse displacements */
-            if (pair_ptr->rimg == 0.)
-                ir3 = ir5 = MAXVALUE;
-            else {
-                ir = 1.0 / r;
-                ir3 = ir * ir * ir;
-                ir5 = ir3 * ir * ir;
-            }
+        if (site[i] < 0) continue;
+        ii = site[i] * 3;
+        for (j = (i + 1), k = 0; j < N; j++, k++) {
+            if (site[j] < 0) continue;
+            jj = site[j] * 3;
+            if (skip_frozen && atom_array[i]->frozen && atom_array[j]->frozen) continue;
 
-            //evaluate damping factors
-            switch (system->damp_type) {
-                case DAMPING_OFF:
-                    if (pair_ptr->es_excluded)
-                        damp1 = damp2 = wdamp1 = wdamp2 = 0.0;
-                    else
-                        damp1 = damp2 = wdamp1 = wdamp2 = 1.0;
-                    break;
-                case DAMPING_LINEAR:
-                    s = l * pow(atom_array[i]->polarizability * atom_array[j]->polarizability, 1.0 / 6.0);
-                    v = r / s;
-                    if (r < s) {
-                        damp1 = (4.0 - 3.0 * v) * v * v * v;
-                        damp2 = v * v * v * v;
-                    } else {
-                        damp1 = damp2 = 1.0;
-                    }
-                    break;
-                case DAMPING_EXPONENTIAL:
-                    explr = exp(-l * r);
-                    damp1 = 1.0 - explr * (0.5 * l2 * r2 + l * r + 1.0);
-                    damp2 = damp1 - explr * (l3 * r2 * r / 6.0);
-                    if (system->polar_wolf_full) {  //subtract off damped interaction at r_cutoff
-                        wdamp1 = 1.0 - explrcut * (0.5 * l2 * rcut2 + l * rcut + 1.0);
-                        wdamp2 = wdamp1 - explrcut * (l3 * rcut3 / 6.0);
-                    }
-                    break;
-                default:
-                    error(
-                        "error: something unexpected happened in thole_matrix.c");
-            }
+            thole_tensor(system, atom_array[i], atom_array[j], k, T);
 
-            /* build the tensor */
-            for (p = 0; p < 3; p++) {
-                for (q = 0; q < 3; q++) {
-                    system->A_matrix[ii + p][jj + q] = -3.0 * pair_ptr->dimg[p] * pair_ptr->dimg[q] * damp2 * ir5;
-                    if (system->polar_wolf_full)
-                        system->A_matrix[ii + p][jj + q] -= -3.0 * pair_ptr->dimg[p] * pair_ptr->dimg[q] * wdamp2 * ir * ir / rcut3;
-
-                    /* additional diagonal term */
-                    if (p == q) {
-                        system->A_matrix[ii + p][jj + q] += damp1 * ir3;
-                        if (system->polar_wolf_full) system->A_matrix[ii + p][jj + q] -= wdamp1 / (rcut3);
-                    }
-                }
-            }
-
-            /* set the lower half of the tensor component */
+            /* set the upper and lower half of the tensor component */
             for (p = 0; p < 3; p++)
                 for (q = 0; q < 3; q++)
-                    system->A_matrix[jj + p][ii + q] = system->A_matrix[ii + p][jj + q];
+                    system->A_matrix[ii + p][jj + q] = system->A_matrix[jj + p][ii + q] = T[p][q];
 
         } /* end j */
     }     /* end i */
@@ -146,24 +303,32 @@ void thole_amatrix(system_t *system) {
 }
 
 /* for uvt runs, resize the A (and B) matrices */
+/* they only grow, doubling when the sites outgrow them, so that uvt does not reallocate at every step */
 void thole_resize_matrices(system_t *system) {
-    int i, N, dN, oldN;
+    int i, N, oldN;
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
 
-    /* determine how the number of atoms has changed and realloc matrices */
-    oldN = 3 * system->checkpoint->thole_N_atom;  //will be set to zero if first time called
-    system->checkpoint->thole_N_atom = countNatoms(system);
+    /* count the polarizable sites */
+    system->checkpoint->thole_N_atom = 0;
+    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
+        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
+            if (thole_site(system, atom_ptr)) system->checkpoint->thole_N_atom++;
     N = 3 * system->checkpoint->thole_N_atom;
-    dN = N - oldN;
+    oldN = system->A_max;  //zero the first time
 
-    if (!dN) return;
+    /* the sparse tensor is sized as it is built */
+    if ((N <= oldN) || system->polar_sparse) return;
+    N = (N > 2 * oldN) ? N : 2 * oldN;
+    system->A_max = N;
 
     // grow A matricies by free/malloc (to prevent fragmentation)
     //free the A matrix
     for (i = 0; i < oldN; i++) free(system->A_matrix[i]);
     free(system->A_matrix);
 
-    //if not iterative, free the B matrix
-    if (!system->polar_iterative) {
+    //if the polarizability tensor is wanted, free the B matrix
+    if (!system->polar_iterative && system->polarizability_tensor) {
         for (i = 0; i < oldN; i++) free(system->B_matrix[i]);
         free(system->B_matrix);
     }
@@ -177,8 +342,8 @@ void thole_resize_matrices(system_t *system) {
         memnullcheck(system->A_matrix[i], N * sizeof(double), __LINE__ - 1, __FILE__);
     }
 
-    //(RE)allocate the B matrix if not iterative
-    if (!system->polar_iterative) {
+    //(RE)allocate the B matrix for the polarizability tensor, the dipoles alone come from the factored A
+    if (!system->polar_iterative && system->polarizability_tensor) {
         system->B_matrix = calloc(N, sizeof(double *));
         memnullcheck(system->B_matrix, N * sizeof(double *), __LINE__ - 1, __FILE__);
         for (i = 0; i < N; i++) {
@@ -190,29 +355,26 @@ void thole_resize_matrices(system_t *system) {
     return;
 }
 
-/* invert the A matrix */
+/* invert the A matrix, or just factor it if B itself isn't needed */
 void thole_bmatrix(system_t *system) {
-    int N;
-    molecule_t *molecule_ptr;
-    atom_t *atom_ptr;
-
-    /* count the number of atoms */
-    N = 0;
-    for (molecule_ptr = system->molecules; molecule_ptr; molecule_ptr = molecule_ptr->next)
-        for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next)
-            ++N;
-
-    invert_matrix(3 * N, system->A_matrix, system->B_matrix);
+    int N = system->A_sites->n;
+
+    if (system->polar_woodbury)
+        thole_woodbury(system, 3 * N);
+    else if (!system->polarizability_tensor)
+        thole_ldlt_factor(system, 3 * N);
+    else
+        invert_matrix(3 * N, system->A_matrix, system->B_matrix);
 }
 
 /* get the dipoles by vector matrix multiply */
 void thole_bmatrix_dipoles(system_t *system) {
     int i, j, ii, p, N;
-    atom_t **atom_array;
+    atom_t **atom_array, *atom_ptr;
     double *mu_array, *field_array;
 
     atom_array = system->atom_array;
-    N = system->natoms;
+    N = system->A_sites->n;
 
     /* allocate working arrays */
     mu_array = calloc(3 * N, sizeof(double));
@@ -223,22 +385,34 @@ void thole_bmatrix_dipoles(system_t *system) {
     /* copy the field in */
     for (i = 0; i < N; i++) {
         ii = i * 3;
+        atom_ptr = atom_array[system->A_sites->atom[i]];
 
         for (p = 0; p < 3; p++)
-            field_array[ii + p] = atom_array[i]->ef_static[p] + atom_array[i]->ef_static_self[p];
+            field_array[ii + p] = atom_ptr->ef_static[p] + atom_ptr->ef_static_self[p];
     }
 
-    /* multiply the supervector with the B matrix */
-    for (i = 0; i < 3 * N; i++)
-        for (j = 0; j < 3 * N; j++)
-            mu_array[i] += system->B_matrix[i][j] * field_array[j];
-
-    /* copy the dipoles out */
+    /* multiply the supervector with the B matrix, or solve with the factored A */
+    if (system->polar_woodbury) {
+        for (i = 0; i < 3 * N; i++)
+            for (j = 0; j < 3 * N; j++)
+                mu_array[i] += system->B_woodbury->current[i * 3 * N + j] * field_array[j];
+    } else if (!system->polarizability_tensor) {
+        memcpy(mu_array, field_array, 3 * N * sizeof(double));
+        thole_ldlt_solve(system, mu_array);
+    } else
+        for (i = 0; i < 3 * N; i++)
+            for (j = 0; j < 3 * N; j++)
+                mu_array[i] += system->B_matrix[i][j] * field_array[j];
+
+    /* copy the dipoles out, the atoms without a site have none */
+    for (i = 0; i < system->natoms; i++)
+        for (p = 0; p < 3; p++) atom_array[i]->mu[p] = 0;
     for (i = 0; i < N; i++) {
         ii = i * 3;
+        atom_ptr = atom_array[system->A_sites->atom[i]];
 
         for (p = 0; p < 3; p++)
-            atom_array[i]->mu[p] = mu_array[ii + p];
+            atom_ptr->mu[p] = mu_array[ii + p];
     }
 
     /* free the working arrays */
@@ -0,0 +1,285 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* preconditioned conjugate gradient solution of A mu = E for the induced dipoles, on the dense or the sparse A */
+/* the atoms without polarizability keep mu = 0, so their rows and columns are masked out of the system */
+/* the preconditioner inverts the diagonal 3x3 block of each atom (alpha times the identity), or the */
+/* block of each molecule of up to POLAR_PCG_BLOCK_MAX atoms */
+
+/* block-jacobi preconditioner */
+typedef struct _pcg_precond {
+    int nblocks;
+    int *first, *size; /* [nblocks] first atom and number of atoms of each molecule block */
+    double ***lu;      /* [nblocks] LU factors of the 3size x 3size block */
+    int **indx;        /* [nblocks] row permutation of the LU factors */
+} pcg_precond_t;
+
+/* y = A x for the atoms in arg, with the masked rows left at zero */
+typedef struct _pcg_matvec {
+    double *x, *y;
+} pcg_matvec_t;
+
+/* A_ij, from the dense A or a row of the sparse one */
+static void pcg_block(system_t *system, int i, int j, double T[3][3]) {
+    amatrix_sparse_t *A = system->A_sparse;
+    int b, p, q, si, sj;
+
+    si = system->A_sites->site[i];
+    sj = system->A_sites->site[j];
+    /* an atom without a site only has its MAXVALUE diagonal */
+    if ((si < 0) || (sj < 0)) {
+        memset(T, 0, 9 * sizeof(double));
+        if (i == j)
+            for (p = 0; p < 3; p++) T[p][p] = MAXVALUE;
+        return;
+    }
+
+    if (!system->polar_sparse) {
+        for (p = 0; p < 3; p++)
+            for (q = 0; q < 3; q++)
+                T[p][q] = system->A_matrix[3 * si + p][3 * sj + q];
+        return;
+    }
+
+    memset(T, 0, 9 * sizeof(double));
+    if (i == j) {
+        for (p = 0; p < 3; p++) T[p][p] = A->diag[si];
+        return;
+    }
+    for (b = A->row[si]; b < A->row[si + 1]; b++)
+        if (A->col[b] == sj) {
+            memcpy(T, &A->block[9 * b], 9 * sizeof(double));
+            return;
+        }
+}
+
+/* row i of y = A x */
+static void pcg_matvec_atom(system_t *system, int i, void *arg, double *unused) {
+    pcg_matvec_t *mv = arg;
+    amatrix_sparse_t *A;
+    double *x = mv->x, *y = &mv->y[3 * i];
+    double *T, *xj, *a;
+    int b, p, q, s, si;
+
+    y[0] = y[1] = y[2] = 0;
+    if (system->atom_array[i]->polarizability == 0.0) return;
+
+    si = system->A_sites->site[i];
+    if (system->polar_sparse) {
+        A = system->A_sparse;
+        for (p = 0; p < 3; p++) y[p] = A->diag[si] * x[3 * i + p];
+        for (b = A->row[si]; b < A->row[si + 1]; b++) {
+            T = &A->block[9 * b];
+            xj = &x[3 * system->A_sites->atom[A->col[b]]];
+            y[0] += T[0] * xj[0] + T[1] * xj[1] + T[2] * xj[2];
+            y[1] += T[3] * xj[0] + T[4] * xj[1] + T[5] * xj[2];
+            y[2] += T[6] * xj[0] + T[7] * xj[1] + T[8] * xj[2];
+        }
+    } else {
+        /* the columns of the sites, the rest of x is masked to zero */
+        for (p = 0; p < 3; p++) {
+            a = system->A_matrix[3 * si + p];
+            for (s = 0; s < system->A_sites->n; s++) {
+                xj = &x[3 * system->A_sites->atom[s]];
+                for (q = 0; q < 3; q++) y[p] += a[3 * s + q] * xj[q];
+            }
+        }
+    }
+}
+
+static void pcg_matvec(system_t *system, double *x, double *y) {
+    pcg_matvec_t mv;
+
+    mv.x = x;
+    mv.y = y;
+    thread_sum(system, system->natoms, pcg_matvec_atom, &mv);
+}
+
+/* factor the molecule blocks, the remaining atoms use their diagonal */
+static void pcg_precond_setup(system_t *system, pcg_precond_t *M) {
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+    double T[3][3], d;
+    int n, a, b, p, q, i, size, first;
+
+    M->nblocks = 0;
+    M->first = M->size = NULL;
+    M->lu = NULL;
+    M->indx = NULL;
+    if (system->polar_pcg_precond != PCG_PRECOND_MOLECULE) return;
+
+    M->first = malloc(system->natoms * sizeof(int));
+    memnullcheck(M->first, system->natoms * sizeof(int), __LINE__ - 1, __FILE__);
+    M->size = malloc(system->natoms * sizeof(int));
+    memnullcheck(M->size, system->natoms * sizeof(int), __LINE__ - 1, __FILE__);
+    M->lu = malloc(system->natoms * sizeof(double **));
+    memnullcheck(M->lu, system->natoms * sizeof(double **), __LINE__ - 1, __FILE__);
+    M->indx = malloc(system->natoms * sizeof(int *));
+    memnullcheck(M->indx, system->natoms * sizeof(int *), __LINE__ - 1, __FILE__);
+
+    /* the atom array follows the molecule list */
+    for (molecule_ptr = system->molecules, first = 0; molecule_ptr; molecule_ptr = molecule_ptr->next, first += size) {
+        for (atom_ptr = molecule_ptr->atoms, size = 0; atom_ptr; atom_ptr = atom_ptr->next) size++;
+        if ((size < 2) || (size > POLAR_PCG_BLOCK_MAX)) continue;
+
+        n = M->nblocks++;
+        M->first[n] = first;
+        M->size[n] = size;
+        M->lu[n] = malloc(3 * size * sizeof(double *));
+        memnullcheck(M->lu[n], 3 * size * sizeof(double *), __LINE__ - 1, __FILE__);
+        for (i = 0; i < 3 * size; i++) {
+            M->lu[n][i] = malloc(3 * size * sizeof(double));
+            memnullcheck(M->lu[n][i], 3 * size * sizeof(double), __LINE__ - 1, __FILE__);
+        }
+        M->indx[n] = malloc(3 * size * sizeof(int));
+        memnullcheck(M->indx[n], 3 * size * sizeof(int), __LINE__ - 1, __FILE__);
+
+        for (a = 0; a < size; a++)
+            for (b = 0; b < size; b++) {
+                pcg_block(system, first + a, first + b, T);
+                for (p = 0; p < 3; p++)
+                    for (q = 0; q < 3; q++)
+                        M->lu[n][3 * a + p][3 * b + q] = T[p][q];
+            }
+        LU_decomp(M->lu[n], 3 * size, M->indx[n], &d);
+    }
+}
+
+static void pcg_precond_free(pcg_precond_t *M) {
+    int n, i;
+
+    for (n = 0; n < M->nblocks; n++) {
+        for (i = 0; i < 3 * M->size[n]; i++) free(M->lu[n][i]);
+        free(M->lu[n]);
+        free(M->indx[n]);
+    }
+    free(M->first);
+    free(M->size);
+    free(M->lu);
+    free(M->indx);
+}
+
+/* z = M^-1 r */
+static void pcg_precond_apply(system_t *system, pcg_precond_t *M, double *r, double *z) {
+    atom_t **aa = system->atom_array;
+    int i, n, p;
+
+    for (i = 0; i < system->natoms; i++)
+        for (p = 0; p < 3; p++)
+            z[3 * i + p] = aa[i]->polarizability * r[3 * i + p];
+
+    for (n = 0; n < M->nblocks; n++) {
+        memcpy(&z[3 * M->first[n]], &r[3 * M->first[n]], 3 * M->size[n] * sizeof(double));
+        LU_bksb(M->lu[n], 3 * M->size[n], M->indx[n], &z[3 * M->first[n]]);
+        for (i = M->first[n]; i < M->first[n] + M->size[n]; i++)
+            if (aa[i]->polarizability == 0.0)
+                for (p = 0; p < 3; p++) z[3 * i + p] = 0;
+    }
+}
+
+static double pcg_dot(int n, double *a, double *b) {
+    double sum = 0;
+    int i;
+
+    for (i = 0; i < n; i++) sum += a[i] * b[i];
+
+    return (sum);
+}
+
+/* returns the number of iterations required */
+int thole_pcg(system_t *system) {
+    atom_t **aa = system->atom_array;
+    int N = system->natoms;
+    int i, p, iteration_counter, max_iter;
+    double *b, *x, *r, *z, *d, *Ad;
+    double rz, rz_new, step, b_norm, tolerance;
+    pcg_precond_t M;
+
+    b = calloc(3 * N, sizeof(double));
+    memnullcheck(b, 3 * N * sizeof(double), __LINE__ - 1, __FILE__);
+    x = calloc(3 * N, sizeof(double));
+    memnullcheck(x, 3 * N * sizeof(double), __LINE__ - 1, __FILE__);
+    r = calloc(3 * N, sizeof(double));
+    memnullcheck(r, 3 * N * sizeof(double), __LINE__ - 1, __FILE__);
+    z = calloc(3 * N, sizeof(double));
+    memnullcheck(z, 3 * N * sizeof(double), __LINE__ - 1, __FILE__);
+    d = calloc(3 * N, sizeof(double));
+    memnullcheck(d, 3 * N * sizeof(double), __LINE__ - 1, __FILE__);
+    Ad = calloc(3 * N, sizeof(double));
+    memnullcheck(Ad, 3 * N * sizeof(double), __LINE__ - 1, __FILE__);
+
+    /* the static field, and alpha*E to start from - or the last accepted dipoles, with the change of alpha*E */
+    for (i = 0; i < N; i++) {
+        if (aa[i]->polarizability == 0.0) continue;
+        for (p = 0; p < 3; p++) {
+            b[3 * i + p] = aa[i]->ef_static[p] + aa[i]->ef_static_self[p];
+            x[3 * i + p] = aa[i]->polarizability * b[3 * i + p];
+            if (system->polar_warm_start) x[3 * i + p] += aa[i]->mu_last[p] - aa[i]->polarizability * aa[i]->ef_static_last[p];
+        }
+    }
+
+    pcg_precond_setup(system, &M);
+
+    pcg_matvec(system, x, Ad);
+    for (i = 0; i < 3 * N; i++) r[i] = b[i] - Ad[i];
+    pcg_precond_apply(system, &M, r, z);
+    memcpy(d, z, 3 * N * sizeof(double));
+    rz = pcg_dot(3 * N, r, z);
+
+    b_norm = sqrt(pcg_dot(3 * N, b, b));
+    tolerance = system->polar_pcg_tolerance * b_norm;
+    max_iter = (system->polar_max_iter > 0) ? system->polar_max_iter : POLAR_PCG_MAX_ITER;
+
+    system->iter_success = 0;
+    for (iteration_counter = 0; sqrt(pcg_dot(3 * N, r, r)) > tolerance; iteration_counter++) {
+        if (iteration_counter >= max_iter) {
+            /* with a fixed iteration count, stopping there is not a failure */
+            if (!(system->polar_max_iter > 0)) system->iter_success = 1;
+            break;
+        }
+
+        pcg_matvec(system, d, Ad);
+        step = rz / pcg_dot(3 * N, d, Ad);
+        for (i = 0; i < 3 * N; i++) {
+            x[i] += step * d[i];
+            r[i] -= step * Ad[i];
+        }
+
+        pcg_precond_apply(system, &M, r, z);
+        rz_new = pcg_dot(3 * N, r, z);
+        for (i = 0; i < 3 * N; i++) d[i] = z[i] + rz_new / rz * d[i];
+        rz = rz_new;
+    }
+
+    /* the induced field of the final dipoles, and the true residual for palmo */
+    pcg_matvec(system, x, Ad);
+    for (i = 0; i < N; i++) {
+        for (p = 0; p < 3; p++) {
+            aa[i]->mu[p] = aa[i]->new_mu[p] = x[3 * i + p];
+            if (aa[i]->polarizability == 0.0) {
+                aa[i]->ef_induced[p] = aa[i]->ef_induced_change[p] = 0;
+                continue;
+            }
+            aa[i]->ef_induced[p] = x[3 * i + p] / aa[i]->polarizability - Ad[3 * i + p];
+            aa[i]->ef_induced_change[p] = b[3 * i + p] - Ad[3 * i + p];
+        }
+        aa[i]->dipole_rrms = 0;
+    }
+
+    pcg_precond_free(&M);
+    free(b);
+    free(x);
+    free(r);
+    free(z);
+    free(d);
+    free(Ad);
+
+    return (iteration_counter);
+}
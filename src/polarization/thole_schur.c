@@ -0,0 +1,377 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* with polar_schur, the dipoles of the frozen atoms are eliminated from A mu = E */
+/* ordering the frozen atoms (f) ahead of the mobile ones (s), A = [F C; C^T S] with F fixed for the run, */
+/* so F^-1 is formed once, and each step only builds C and S and solves the schur complement */
+/* (S - C^T F^-1 C) mu_s = E_s - C^T F^-1 E_f, after which mu_f = F^-1 (E_f - C mu_s) */
+/* thole_amatrix() neither builds nor clears the frozen-frozen block once F^-1 is known */
+/* G = F^-1 C and sigma = S - C^T G of the accepted configuration are kept between mc steps - a move of one */
+/* molecule of m mobile sites only changes its k = 3m columns of C, so the trial G needs those k columns */
+/* (f^2 k) and sigma the matching k rows and columns (f s k), the rest is copied over from the accepted ones */
+/* an inserted molecule adds k new columns, a removed one drops its k, and the trial copy becomes the */
+/* accepted one on accept and is dropped on reject, as with polar_woodbury - what is left per step is */
+/* s^3/3 for the factor of sigma, against (f + s)^3/3 for the plain solve */
+
+/* the products spread over the threads, by row */
+typedef struct _schur_rows {
+    schur_t *sc;
+    int ns;
+    int lo, hi; /* the columns of G and rows of sigma to compute */
+} schur_rows_t;
+
+/* G = F^-1 C for row i, columns [lo, hi) */
+static void thole_schur_g_row(system_t *system, int i, void *arg, double *unused) {
+    schur_rows_t *u = arg;
+    schur_t *sc = u->sc;
+    double *g = &sc->g_trial[i * u->ns], *c, f;
+    int j, b, ns = u->ns;
+
+    for (b = u->lo; b < u->hi; b++) g[b] = 0;
+    for (j = 0; j < sc->nf; j++) {
+        f = sc->Finv[i][j];
+        c = &sc->c_trial[j * ns];
+        for (b = u->lo; b < u->hi; b++) g[b] += f * c[b];
+    }
+}
+
+/* sigma = S - C^T G for row lo + a */
+static void thole_schur_sigma_row(system_t *system, int a, void *arg, double *unused) {
+    schur_rows_t *u = arg;
+    schur_t *sc = u->sc;
+    double *sigma = sc->sigma_trial[u->lo + a], *A, *g, c;
+    int i, b, ns = u->ns;
+
+    A = system->A_matrix[3 * sc->mobile[(u->lo + a) / 3] + (u->lo + a) % 3];
+    for (b = 0; b < ns; b++) sigma[b] = A[3 * sc->mobile[b / 3] + b % 3];
+    for (i = 0; i < sc->nf; i++) {
+        c = sc->c_trial[i * ns + u->lo + a];
+        g = &sc->g_trial[i * ns];
+        for (b = 0; b < ns; b++) sigma[b] -= c * g[b];
+    }
+}
+
+/* sort the sites into frozen and mobile, returns the number of frozen ones */
+static int thole_schur_index(system_t *system, schur_t *sc) {
+    polar_sites_t *sites = system->A_sites;
+    int s, nfrozen, nmobile;
+
+    if (sites->n > sc->max_atoms) {
+        sc->max_atoms = (sites->n > 2 * sc->max_atoms) ? sites->n : 2 * sc->max_atoms;
+        free(sc->frozen);
+        sc->frozen = malloc(2 * sc->max_atoms * sizeof(int));
+        memnullcheck(sc->frozen, 2 * sc->max_atoms * sizeof(int), __LINE__ - 1, __FILE__);
+        sc->mobile = sc->frozen + sc->max_atoms;
+    }
+
+    for (s = 0, nfrozen = nmobile = 0; s < sites->n; s++) {
+        if (system->atom_array[sites->atom[s]]->frozen)
+            sc->frozen[nfrozen++] = s;
+        else
+            sc->mobile[nmobile++] = s;
+    }
+
+    return (nfrozen);
+}
+
+/* invert the frozen block of the A matrix just built */
+static void thole_schur_setup(system_t *system) {
+    schur_t *sc;
+    double **F;
+    int i, j, nfrozen;
+    char linebuf[MAXLINE];
+
+    sc = system->A_schur = calloc(1, sizeof(schur_t));
+    memnullcheck(sc, sizeof(schur_t), __LINE__ - 1, __FILE__);
+    nfrozen = thole_schur_index(system, sc);
+    sc->nf = 3 * nfrozen;
+
+    sprintf(linebuf,
+            "POLAR: inverting the %d x %d frozen block of the A matrix\n", sc->nf, sc->nf);
+    output(linebuf);
+
+    F = calloc(sc->nf, sizeof(double *));
+    memnullcheck(F, sc->nf * sizeof(double *), __LINE__ - 1, __FILE__);
+    sc->Finv = calloc(sc->nf, sizeof(double *));
+    memnullcheck(sc->Finv, sc->nf * sizeof(double *), __LINE__ - 1, __FILE__);
+    for (i = 0; i < sc->nf; i++) {
+        F[i] = malloc(sc->nf * sizeof(double));
+        memnullcheck(F[i], sc->nf * sizeof(double), __LINE__ - 1, __FILE__);
+        sc->Finv[i] = malloc(sc->nf * sizeof(double));
+        memnullcheck(sc->Finv[i], sc->nf * sizeof(double), __LINE__ - 1, __FILE__);
+        for (j = 0; j < sc->nf; j++)
+            F[i][j] = system->A_matrix[3 * sc->frozen[i / 3] + i % 3][3 * sc->frozen[j / 3] + j % 3];
+    }
+
+    if (sc->nf) invert_matrix(sc->nf, F, sc->Finv);
+
+    for (i = 0; i < sc->nf; i++) free(F[i]);
+    free(F);
+
+    /* the field and F^-1 E_f, the field is resized with the mobile rows */
+    sc->b = malloc((sc->nf + 1) * sizeof(double));
+    memnullcheck(sc->b, (sc->nf + 1) * sizeof(double), __LINE__ - 1, __FILE__);
+    sc->gf = malloc((sc->nf + 1) * sizeof(double));
+    memnullcheck(sc->gf, (sc->nf + 1) * sizeof(double), __LINE__ - 1, __FILE__);
+}
+
+/* grow a [max_ns][max_ns] matrix to [n][n], keeping what is in it */
+static double **thole_schur_resize_square(double **a, int max_ns, int n) {
+    int i;
+
+    a = realloc(a, n * sizeof(double *));
+    memnullcheck(a, n * sizeof(double *), __LINE__ - 1, __FILE__);
+    for (i = 0; i < n; i++) {
+        a[i] = realloc((i < max_ns) ? a[i] : NULL, n * sizeof(double));
+        memnullcheck(a[i], n * sizeof(double), __LINE__ - 1, __FILE__);
+    }
+
+    return (a);
+}
+
+/* size the arrays for ns mobile rows, the accepted ones are kept as they grow */
+static void thole_schur_resize(schur_t *sc, int ns) {
+    int max_ns;
+
+    if (ns <= sc->max_ns) return;
+
+    max_ns = (ns > 2 * sc->max_ns) ? ns : 2 * sc->max_ns;
+    sc->c = realloc(sc->c, (sc->nf * max_ns + 1) * sizeof(double));
+    memnullcheck(sc->c, (sc->nf * max_ns + 1) * sizeof(double), __LINE__ - 1, __FILE__);
+    sc->g = realloc(sc->g, (sc->nf * max_ns + 1) * sizeof(double));
+    memnullcheck(sc->g, (sc->nf * max_ns + 1) * sizeof(double), __LINE__ - 1, __FILE__);
+    sc->c_trial = realloc(sc->c_trial, (sc->nf * max_ns + 1) * sizeof(double));
+    memnullcheck(sc->c_trial, (sc->nf * max_ns + 1) * sizeof(double), __LINE__ - 1, __FILE__);
+    sc->g_trial = realloc(sc->g_trial, (sc->nf * max_ns + 1) * sizeof(double));
+    memnullcheck(sc->g_trial, (sc->nf * max_ns + 1) * sizeof(double), __LINE__ - 1, __FILE__);
+    sc->sigma = thole_schur_resize_square(sc->sigma, sc->max_ns, max_ns);
+    sc->sigma_trial = thole_schur_resize_square(sc->sigma_trial, sc->max_ns, max_ns);
+    sc->b = realloc(sc->b, (sc->nf + 2 * max_ns + 1) * sizeof(double));
+    memnullcheck(sc->b, (sc->nf + 2 * max_ns + 1) * sizeof(double), __LINE__ - 1, __FILE__);
+    sc->max_ns = max_ns;
+}
+
+/* the trial C, G and sigma for ns mobile rows - G and sigma are computed for the columns [lo, hi) */
+/* and the others are copied from the accepted ones, where column a >= hi was a + shift */
+static void thole_schur_trial(system_t *system, int ns, int lo, int hi, int shift) {
+    schur_t *sc = system->A_schur;
+    schur_rows_t u;
+    double **A = system->A_matrix, *old;
+    int nf = sc->nf, ns0 = sc->ns, i, a, b, row;
+
+    u.sc = sc;
+    u.ns = ns;
+    u.lo = lo;
+    u.hi = hi;
+
+    /* the coupling C is read in full, it costs no more than the copy */
+    for (i = 0; i < nf; i++) {
+        row = 3 * sc->frozen[i / 3] + i % 3;
+        for (a = 0; a < ns; a++) sc->c_trial[i * ns + a] = A[row][3 * sc->mobile[a / 3] + a % 3];
+    }
+
+    /* what the move left alone */
+    for (i = 0; i < nf; i++) {
+        memcpy(&sc->g_trial[i * ns], &sc->g[i * ns0], lo * sizeof(double));
+        memcpy(&sc->g_trial[i * ns + hi], &sc->g[i * ns0 + hi + shift], (ns - hi) * sizeof(double));
+    }
+    for (a = 0; a < ns; a++) {
+        if ((a >= lo) && (a < hi)) continue;
+        old = sc->sigma[(a < lo) ? a : a + shift];
+        memcpy(sc->sigma_trial[a], old, lo * sizeof(double));
+        memcpy(&sc->sigma_trial[a][hi], &old[hi + shift], (ns - hi) * sizeof(double));
+    }
+
+    /* the columns of G and the rows of sigma for the sites that moved, and the columns of sigma by symmetry */
+    if (hi > lo) {
+        thread_sum(system, nf, thole_schur_g_row, &u);
+        thread_sum(system, hi - lo, thole_schur_sigma_row, &u);
+        for (a = lo; a < hi; a++)
+            for (b = 0; b < ns; b++)
+                if ((b < lo) || (b >= hi)) sc->sigma_trial[b][a] = sc->sigma_trial[a][b];
+    }
+
+    sc->ns_trial = ns;
+}
+
+/* the mobile columns [a, a+k) of the molecule of the move, returns 0 if the move is not a single molecule's */
+static int thole_schur_columns(system_t *system, int *a, int *k) {
+    checkpoint_t *checkpoint = system->checkpoint;
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+    int first, size;
+
+    switch (checkpoint->movetype) {
+        case MOVETYPE_DISPLACE:
+        case MOVETYPE_ADIABATIC:
+        case MOVETYPE_INSERT:
+            break;
+        case MOVETYPE_REMOVE:
+            /* the removed molecule was in front of the tail */
+            for (atom_ptr = checkpoint->molecule_backup->atoms, size = 0; atom_ptr; atom_ptr = atom_ptr->next) size += thole_site(system, atom_ptr) && !atom_ptr->frozen;
+            for (molecule_ptr = system->molecules, first = 0; molecule_ptr != checkpoint->tail; molecule_ptr = molecule_ptr->next)
+                for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) first += thole_site(system, atom_ptr) && !atom_ptr->frozen;
+            *a = 3 * first;
+            *k = 3 * size;
+            return (1);
+        default:
+            return (0);
+    }
+
+    /* the mobile sites follow the molecule list */
+    for (molecule_ptr = system->molecules, first = 0; molecule_ptr; molecule_ptr = molecule_ptr->next) {
+        for (atom_ptr = molecule_ptr->atoms, size = 0; atom_ptr; atom_ptr = atom_ptr->next) size += thole_site(system, atom_ptr) && !atom_ptr->frozen;
+        if (molecule_ptr == checkpoint->molecule_altered) {
+            *a = 3 * first;
+            *k = 3 * size;
+            return (1);
+        }
+        first += size;
+    }
+
+    return (0);
+}
+
+/* the trial from the accepted G and sigma, for the move's columns [a, a+k) - returns 0 if they do not match it */
+static int thole_schur_update(system_t *system, int ns, int a, int k) {
+    schur_t *sc = system->A_schur;
+
+    switch (system->checkpoint->movetype) {
+        case MOVETYPE_INSERT:
+            if (ns != sc->ns + k) return (0);
+            thole_schur_trial(system, ns, a, a + k, -k);
+            break;
+        case MOVETYPE_REMOVE:
+            if (ns != sc->ns - k) return (0);
+            thole_schur_trial(system, ns, a, a, k);
+            break;
+        default:
+            if (ns != sc->ns) return (0);
+            thole_schur_trial(system, ns, a, a + k, 0);
+    }
+
+    return (1);
+}
+
+/* the trial C, G and sigma become the accepted ones */
+static void thole_schur_promote(schur_t *sc) {
+    double *swap, **swap_sigma;
+
+    swap = sc->c;
+    sc->c = sc->c_trial;
+    sc->c_trial = swap;
+    swap = sc->g;
+    sc->g = sc->g_trial;
+    sc->g_trial = swap;
+    swap_sigma = sc->sigma;
+    sc->sigma = sc->sigma_trial;
+    sc->sigma_trial = swap_sigma;
+    sc->ns = sc->ns_trial;
+    sc->valid = 1;
+}
+
+/* the dipoles from the static field, with the frozen ones eliminated */
+void thole_schur_dipoles(system_t *system) {
+    schur_t *sc;
+    atom_t **aa = system->atom_array;
+    int *atom = system->A_sites->atom;
+    double *b, *gf, *mu_s, *c, *g, **sigma, sum;
+    int nf, ns, i, a, k, p, nfrozen;
+    char linebuf[MAXLINE];
+
+    if (!system->A_schur) thole_schur_setup(system);
+    sc = system->A_schur;
+
+    nfrozen = thole_schur_index(system, sc);
+    if (3 * nfrozen != sc->nf) {
+        sprintf(linebuf,
+                "POLAR: polar_schur found %d frozen sites where there were %d\n", nfrozen, sc->nf / 3);
+        error(linebuf);
+        die(-1);
+    }
+    nf = sc->nf;
+    ns = 3 * (system->A_sites->n - nfrozen);
+    thole_schur_resize(sc, ns);
+
+    if (sc->pending && sc->valid && thole_schur_columns(system, &a, &k) && thole_schur_update(system, ns, a, k))
+        sc->applied = 1; /* the trial from the accepted one */
+    else {
+        thole_schur_trial(system, ns, 0, ns, 0);
+        if (sc->pending)
+            sc->applied = 1; /* a trial from scratch, the accepted one stays for a reject */
+        else
+            thole_schur_promote(sc); /* no move to go by, so this is the accepted configuration */
+    }
+    sc->pending = 0;
+
+    c = sc->applied ? sc->c_trial : sc->c;
+    g = sc->applied ? sc->g_trial : sc->g;
+    sigma = sc->applied ? sc->sigma_trial : sc->sigma;
+    b = sc->b;
+    gf = sc->gf;
+    mu_s = b + nf + ns;
+
+    /* the static field, frozen rows first */
+    for (i = 0; i < nf; i++) b[i] = aa[atom[sc->frozen[i / 3]]]->ef_static[i % 3] + aa[atom[sc->frozen[i / 3]]]->ef_static_self[i % 3];
+    for (a = 0; a < ns; a++) b[nf + a] = aa[atom[sc->mobile[a / 3]]]->ef_static[a % 3] + aa[atom[sc->mobile[a / 3]]]->ef_static_self[a % 3];
+
+    /* gf = F^-1 E_f */
+    for (i = 0; i < nf; i++) {
+        for (k = 0, sum = 0; k < nf; k++) sum += sc->Finv[i][k] * b[k];
+        gf[i] = sum;
+    }
+
+    /* sigma mu_s = E_s - C^T gf */
+    if (ns) {
+        for (a = 0; a < ns; a++) mu_s[a] = b[nf + a];
+        for (i = 0; i < nf; i++)
+            for (a = 0; a < ns; a++) mu_s[a] -= c[i * ns + a] * gf[i];
+        ldlt_factor(system, &sc->factor, sigma, ns);
+        ldlt_solve(sc->factor, mu_s);
+    }
+
+    /* mu_f = gf - G mu_s, the atoms without a site have no dipole */
+    for (i = 0; i < system->natoms; i++)
+        for (p = 0; p < 3; p++) aa[i]->mu[p] = 0;
+    for (i = 0; i < nf; i++) {
+        for (a = 0, sum = 0; a < ns; a++) sum += g[i * ns + a] * mu_s[a];
+        aa[atom[sc->frozen[i / 3]]]->mu[i % 3] = gf[i] - sum;
+    }
+    for (a = 0; a < ns; a++) aa[atom[sc->mobile[a / 3]]]->mu[a % 3] = mu_s[a];
+}
+
+/* a move was made, G and sigma have yet to see it */
+void thole_schur_move(system_t *system) {
+    schur_t *sc = system->A_schur;
+
+    sc->pending = 1;
+    sc->applied = 0;
+}
+
+/* the move was rejected, the accepted G and sigma are untouched */
+void thole_schur_restore(system_t *system) {
+    schur_t *sc = system->A_schur;
+
+    sc->pending = 0;
+    sc->applied = 0;
+}
+
+/* the move was accepted, the trial G and sigma become the accepted ones */
+void thole_schur_accept(system_t *system) {
+    schur_t *sc = system->A_schur;
+
+    if (sc->applied)
+        thole_schur_promote(sc);
+    else if (sc->pending)
+        sc->valid = 0; /* the move never reached the dipoles (e.g. a bad contact) */
+
+    sc->pending = 0;
+    sc->applied = 0;
+}
@@ -0,0 +1,504 @@
+/*
+
+Space Research Group
+Department of Chemistry
+University of South Florida
+
+*/
+
+#include <mc.h>
+
+/* with polar_woodbury, B = A^-1 of the accepted configuration is kept between mc steps */
+/* moving one molecule of m polarizable sites only changes the k = 3m rows and columns S of A that belong to it, */
+/* so the change is written as dA = U V^T of rank 2k, U = [E_S | Y], V = [X^T | E_S], with X the */
+/* changed rows of A and Y their transpose without the S rows, and the inverse follows from */
+/* B' = B - B U (I + V^T B U)^-1 V^T B in O(n^2 k) rather than the O(n^3) of a full factorization */
+/* an inserted molecule borders A with k rows and columns, a removed one takes them out, and the */
+/* inverse follows from the k x k schur complement of those rows, again in O(n^2 k) */
+/* the trial inverse is built next to the accepted one, so a rejected move simply leaves it unused, */
+/* and every polar_woodbury_refresh updates the inverse is formed from scratch to shed the round-off */
+
+/* the parts of the updates that are spread over the threads, by row of the n x n matrices */
+typedef struct _woodbury_rows {
+    woodbury_t *w;
+    int n, k, m;
+    double *X; /* [k][n] rows to contract with B */
+    double *R; /* [n][k] B X^T */
+    double *P; /* [n][m] left factor of the low-rank term */
+    double *W; /* [n][m] right factor of the low-rank term */
+    /* rows and columns of B from cut + skip on move up by skip - shift in B_trial, of size n_out */
+    int n_out, cut, skip, shift;
+} woodbury_rows_t;
+
+/* (re)allocate for an n x n A, the accepted inverse and A are kept if they still fit */
+static void thole_woodbury_setup(system_t *system, int n) {
+    woodbury_t *w = system->B_woodbury;
+    double *B, *B_trial, *A;
+
+    if (!w) {
+        w = system->B_woodbury = calloc(1, sizeof(woodbury_t));
+        memnullcheck(w, sizeof(woodbury_t), __LINE__ - 1, __FILE__);
+    }
+
+    /* grow geometrically as molecules are inserted */
+    if (n > w->max_n) {
+        w->max_n = (n > 2 * w->max_n) ? n : 2 * w->max_n;
+        B = malloc(w->max_n * w->max_n * sizeof(double));
+        memnullcheck(B, w->max_n * w->max_n * sizeof(double), __LINE__ - 1, __FILE__);
+        B_trial = malloc(w->max_n * w->max_n * sizeof(double));
+        memnullcheck(B_trial, w->max_n * w->max_n * sizeof(double), __LINE__ - 1, __FILE__);
+        A = malloc(w->max_n * w->max_n * sizeof(double));
+        memnullcheck(A, w->max_n * w->max_n * sizeof(double), __LINE__ - 1, __FILE__);
+        if (w->valid) {
+            memcpy(B, w->B, w->n * w->n * sizeof(double));
+            memcpy(A, w->A, w->n * w->n * sizeof(double));
+        }
+        free(w->B);
+        free(w->B_trial);
+        free(w->A);
+        w->B = B;
+        w->B_trial = B_trial;
+        w->A = A;
+    }
+}
+
+/* column j of the inverse of the factored A, which is also row j */
+static void thole_woodbury_column(system_t *system, int j, void *arg, double *unused) {
+    woodbury_t *w = system->B_woodbury;
+    double *b = (double *)arg + j * w->n_trial;
+
+    memset(b, 0, w->n_trial * sizeof(double));
+    b[j] = 1.0;
+    thole_ldlt_solve(system, b);
+}
+
+/* invert A from scratch into inverse */
+static void thole_woodbury_full(system_t *system, int n, double *inverse) {
+    woodbury_t *w = system->B_woodbury;
+
+    thole_ldlt_factor(system, n);
+    w->n_trial = n;
+    thread_sum(system, n, thole_woodbury_column, inverse);
+}
+
+/* R = B X^T for row i */
+static void thole_woodbury_r_row(system_t *system, int i, void *arg, double *unused) {
+    woodbury_rows_t *u = arg;
+    double *b = &u->w->B[i * u->n], *r = &u->R[i * u->k], *x, sum;
+    int c, j;
+
+    for (c = 0; c < u->k; c++) {
+        x = &u->X[c * u->n];
+        for (j = 0, sum = 0; j < u->n; j++) sum += b[j] * x[j];
+        r[c] = sum;
+    }
+}
+
+/* B_trial = B - P W^T for row i, with the rows and columns moved as set in u */
+static void thole_woodbury_b_row(system_t *system, int i, void *arg, double *unused) {
+    woodbury_rows_t *u = arg;
+    double *b = &u->w->B[i * u->n], *bt, *p = &u->P[i * u->m], *wj, sum;
+    int c, j, m = u->m, offset = u->shift - u->skip;
+
+    if ((i >= u->cut) && (i < u->cut + u->skip)) return;
+    bt = &u->w->B_trial[(i < u->cut ? i : i + offset) * u->n_out];
+
+    for (j = 0; j < u->cut; j++) {
+        wj = &u->W[j * m];
+        for (c = 0, sum = 0; c < m; c++) sum += p[c] * wj[c];
+        bt[j] = b[j] - sum;
+    }
+    for (j = u->cut + u->skip; j < u->n; j++) {
+        wj = &u->W[j * m];
+        for (c = 0, sum = 0; c < m; c++) sum += p[c] * wj[c];
+        bt[j + offset] = b[j] - sum;
+    }
+}
+
+/* k x k matrix as row pointers */
+static double **thole_woodbury_small(int k) {
+    double **a;
+    int c;
+
+    a = malloc(k * sizeof(double *));
+    memnullcheck(a, k * sizeof(double *), __LINE__ - 1, __FILE__);
+    for (c = 0; c < k; c++) {
+        a[c] = malloc(k * sizeof(double));
+        memnullcheck(a[c], k * sizeof(double), __LINE__ - 1, __FILE__);
+    }
+
+    return (a);
+}
+
+static void thole_woodbury_small_free(double **a, int k) {
+    int c;
+
+    for (c = 0; c < k; c++) free(a[c]);
+    free(a);
+}
+
+/* overwrite the k x k a with its inverse */
+static void thole_woodbury_small_invert(double **a, int k) {
+    double **lu, *col, d;
+    int *indx, c, e;
+
+    lu = thole_woodbury_small(k);
+    col = malloc(k * sizeof(double));
+    memnullcheck(col, k * sizeof(double), __LINE__ - 1, __FILE__);
+    indx = malloc(k * sizeof(int));
+    memnullcheck(indx, k * sizeof(int), __LINE__ - 1, __FILE__);
+
+    for (c = 0; c < k; c++) memcpy(lu[c], a[c], k * sizeof(double));
+    LU_decomp(lu, k, indx, &d);
+    for (c = 0; c < k; c++) {
+        for (e = 0; e < k; e++) col[e] = (c == e) ? 1.0 : 0.0;
+        LU_bksb(lu, k, indx, col);
+        for (e = 0; e < k; e++) a[e][c] = col[e];
+    }
+
+    thole_woodbury_small_free(lu, k);
+    free(col);
+    free(indx);
+}
+
+/* the inverse of the trial A from the accepted one, for the displaced molecule's rows [s, s+k) */
+static void thole_woodbury_update(system_t *system, int n, int s, int k) {
+    woodbury_t *w = system->B_woodbury;
+    woodbury_rows_t u;
+    double **A = system->A_matrix, **M, *T, *q, d, sum;
+    int *indx, i, j, c, e, k2 = 2 * k;
+
+    u.w = w;
+    u.n = u.n_out = u.cut = n;
+    u.skip = u.shift = 0;
+    u.k = k;
+    u.m = k2;
+    u.X = malloc(k * n * sizeof(double));
+    memnullcheck(u.X, k * n * sizeof(double), __LINE__ - 1, __FILE__);
+    u.R = malloc(n * k * sizeof(double));
+    memnullcheck(u.R, n * k * sizeof(double), __LINE__ - 1, __FILE__);
+    u.P = malloc(n * k2 * sizeof(double));
+    memnullcheck(u.P, n * k2 * sizeof(double), __LINE__ - 1, __FILE__);
+    u.W = malloc(n * k2 * sizeof(double));
+    memnullcheck(u.W, n * k2 * sizeof(double), __LINE__ - 1, __FILE__);
+    T = malloc(n * k * sizeof(double));
+    memnullcheck(T, n * k * sizeof(double), __LINE__ - 1, __FILE__);
+    q = malloc(k2 * sizeof(double));
+    memnullcheck(q, k2 * sizeof(double), __LINE__ - 1, __FILE__);
+    indx = malloc(k2 * sizeof(int));
+    memnullcheck(indx, k2 * sizeof(int), __LINE__ - 1, __FILE__);
+    M = thole_woodbury_small(k2);
+
+    /* the change of the S rows */
+    for (c = 0; c < k; c++)
+        for (j = 0; j < n; j++) u.X[c * n + j] = A[s + c][j] - w->A[(s + c) * n + j];
+
+    /* R = B X^T, and T = the part of it from the S columns, so that B Y = R - T */
+    thread_sum(system, n, thole_woodbury_r_row, &u);
+    for (i = 0; i < n; i++)
+        for (c = 0; c < k; c++) {
+            for (j = 0, sum = 0; j < k; j++) sum += w->B[i * n + s + j] * u.X[c * n + s + j];
+            T[i * k + c] = sum;
+        }
+
+    /* P = B U = [B E_S | B Y] */
+    for (i = 0; i < n; i++)
+        for (c = 0; c < k; c++) {
+            u.P[i * k2 + c] = w->B[i * n + s + c];
+            u.P[i * k2 + k + c] = u.R[i * k + c] - T[i * k + c];
+        }
+
+    /* M = I + V^T P, with V^T = [X ; E_S^T] */
+    for (c = 0; c < k2; c++) {
+        for (e = 0; e < k; e++) {
+            for (j = 0, sum = 0; j < n; j++) sum += u.X[e * n + j] * u.P[j * k2 + c];
+            M[e][c] = sum;
+            M[k + e][c] = u.P[(s + e) * k2 + c];
+        }
+        M[c][c] += 1.0;
+    }
+    LU_decomp(M, k2, indx, &d);
+
+    /* W = M^-1 V^T B, one column at a time - column i of V^T B is row i of B V = [R | B E_S] */
+    for (i = 0; i < n; i++) {
+        for (c = 0; c < k; c++) {
+            q[c] = u.R[i * k + c];
+            q[k + c] = w->B[i * n + s + c];
+        }
+        LU_bksb(M, k2, indx, q);
+        memcpy(&u.W[i * k2], q, k2 * sizeof(double));
+    }
+
+    /* B' = B - P W^T */
+    thread_sum(system, n, thole_woodbury_b_row, &u);
+    w->n_trial = n;
+
+    thole_woodbury_small_free(M, k2);
+    free(indx);
+    free(q);
+    free(T);
+    free(u.X);
+    free(u.R);
+    free(u.P);
+    free(u.W);
+}
+
+/* the trial A is the accepted one bordered by the inserted molecule's rows [s, s+k) */
+static void thole_woodbury_insert(system_t *system, int n, int s, int k) {
+    woodbury_t *w = system->B_woodbury;
+    woodbury_rows_t u;
+    double **A = system->A_matrix, **Si, *G, sum;
+    int n0 = n - k, i, j, c, e, jj;
+
+    u.w = w;
+    u.n = n0;
+    u.n_out = n;
+    u.cut = s;
+    u.skip = 0;
+    u.shift = k;
+    u.k = u.m = k;
+    u.X = malloc(k * n0 * sizeof(double));
+    memnullcheck(u.X, k * n0 * sizeof(double), __LINE__ - 1, __FILE__);
+    u.R = malloc(n0 * k * sizeof(double));
+    memnullcheck(u.R, n0 * k * sizeof(double), __LINE__ - 1, __FILE__);
+    G = malloc(n0 * k * sizeof(double));
+    memnullcheck(G, n0 * k * sizeof(double), __LINE__ - 1, __FILE__);
+    Si = thole_woodbury_small(k);
+
+    /* X = C^T, the new columns at the old rows */
+    for (c = 0; c < k; c++)
+        for (j = 0; j < n0; j++) {
+            jj = (j < s) ? j : j + k;
+            u.X[c * n0 + j] = A[jj][s + c];
+        }
+
+    /* R = B C, and the schur complement D - C^T B C of the new block */
+    thread_sum(system, n0, thole_woodbury_r_row, &u);
+    for (c = 0; c < k; c++)
+        for (e = 0; e < k; e++) {
+            for (j = 0, sum = 0; j < n0; j++) sum += u.X[c * n0 + j] * u.R[j * k + e];
+            Si[c][e] = A[s + c][s + e] - sum;
+        }
+    thole_woodbury_small_invert(Si, k);
+
+    /* G = B C S^-1 */
+    for (i = 0; i < n0; i++)
+        for (c = 0; c < k; c++) {
+            for (e = 0, sum = 0; e < k; e++) sum += u.R[i * k + e] * Si[e][c];
+            G[i * k + c] = sum;
+        }
+
+    /* the old block is B + G (B C)^T */
+    for (i = 0; i < n0 * k; i++) G[i] = -G[i];
+    u.P = G;
+    u.W = u.R;
+    thread_sum(system, n0, thole_woodbury_b_row, &u);
+
+    /* and the border is -G, with S^-1 in the corner */
+    for (i = 0; i < n0; i++) {
+        jj = (i < s) ? i : i + k;
+        for (c = 0; c < k; c++) w->B_trial[jj * n + s + c] = w->B_trial[(s + c) * n + jj] = G[i * k + c];
+    }
+    for (c = 0; c < k; c++)
+        for (e = 0; e < k; e++) w->B_trial[(s + c) * n + s + e] = Si[c][e];
+    w->n_trial = n;
+
+    thole_woodbury_small_free(Si, k);
+    free(G);
+    free(u.X);
+    free(u.R);
+}
+
+/* the trial A is the accepted one without the removed molecule's rows [s, s+k) */
+static void thole_woodbury_remove(system_t *system, int n, int s, int k) {
+    woodbury_t *w = system->B_woodbury;
+    woodbury_rows_t u;
+    double **Hi, sum;
+    int n0 = n + k, i, c, e;
+
+    u.w = w;
+    u.n = n0;
+    u.n_out = n;
+    u.cut = s;
+    u.skip = k;
+    u.shift = 0;
+    u.k = u.m = k;
+    u.P = malloc(n0 * k * sizeof(double));
+    memnullcheck(u.P, n0 * k * sizeof(double), __LINE__ - 1, __FILE__);
+    u.W = malloc(n0 * k * sizeof(double));
+    memnullcheck(u.W, n0 * k * sizeof(double), __LINE__ - 1, __FILE__);
+    Hi = thole_woodbury_small(k);
+
+    /* B' = B - B_{:,S} B_SS^-1 B_{S,:}, outside of S */
+    for (c = 0; c < k; c++)
+        for (e = 0; e < k; e++) Hi[c][e] = w->B[(s + c) * n0 + s + e];
+    thole_woodbury_small_invert(Hi, k);
+
+    for (i = 0; i < n0; i++)
+        for (c = 0; c < k; c++) {
+            u.W[i * k + c] = w->B[i * n0 + s + c];
+            for (e = 0, sum = 0; e < k; e++) sum += w->B[i * n0 + s + e] * Hi[e][c];
+            u.P[i * k + c] = sum;
+        }
+    thread_sum(system, n0, thole_woodbury_b_row, &u);
+    w->n_trial = n;
+
+    thole_woodbury_small_free(Hi, k);
+    free(u.P);
+    free(u.W);
+}
+
+/* the rows of A that belong to the altered molecule, returns 0 if the move is not a single molecule's */
+static int thole_woodbury_rows(system_t *system, int *s, int *k) {
+    checkpoint_t *checkpoint = system->checkpoint;
+    molecule_t *molecule_ptr;
+    atom_t *atom_ptr;
+    int first, size;
+
+    switch (checkpoint->movetype) {
+        case MOVETYPE_DISPLACE:
+        case MOVETYPE_ADIABATIC:
+        case MOVETYPE_INSERT:
+            break;
+        case MOVETYPE_REMOVE:
+            /* the removed molecule was in front of the tail */
+            for (atom_ptr = checkpoint->molecule_backup->atoms, size = 0; atom_ptr; atom_ptr = atom_ptr->next) size += thole_site(system, atom_ptr);
+            for (molecule_ptr = system->molecules, first = 0; molecule_ptr != checkpoint->tail; molecule_ptr = molecule_ptr->next)
+                for (atom_ptr = molecule_ptr->atoms; atom_ptr; atom_ptr = atom_ptr->next) first += thole_site(system, atom_ptr);
+            *s = 3 * first;
+            *k = 3 * size;
+            return (1);
+        default:
+            return (0);
+    }
+
+    /* the sites follow the molecule list */
+    for (molecule_ptr = system->molecules, first = 0; molecule_ptr; molecule_ptr = molecule_ptr->next) {
+        for (atom_ptr = molecule_ptr->atoms, size = 0; atom_ptr; atom_ptr = atom_ptr->next) size += thole_site(system, atom_ptr);
+        if (molecule_ptr == checkpoint->molecule_altered) {
+            *s = 3 * first;
+            *k = 3 * size;
+            return (1);
+        }
+        first += size;
+    }
+
+    return (0);
+}
+
+/* the trial inverse by a low-rank update for the move, returns 0 if A does not match it */
+static int thole_woodbury_low_rank(system_t *system, int n, int s, int k) {
+    woodbury_t *w = system->B_woodbury;
+
+    /* a molecule without polarizable sites leaves A as it was */
+    if (k == 0) {
+        if (n != w->n) return (0);
+        memcpy(w->B_trial, w->B, n * n * sizeof(double));
+        w->n_trial = n;
+        w->s = w->k = 0;
+        return (1);
+    }
+
+    switch (system->checkpoint->movetype) {
+        case MOVETYPE_INSERT:
+            if (n != w->n + k) return (0);
+            thole_woodbury_insert(system, n, s, k);
+            /* the accepted A is copied whole */
+            w->s = 0;
+            w->k = n;
+            break;
+        case MOVETYPE_REMOVE:
+            if (n != w->n - k) return (0);
+            thole_woodbury_remove(system, n, s, k);
+            w->s = 0;
+            w->k = n;
+            break;
+        default:
+            if (n != w->n) return (0);
+            thole_woodbury_update(system, n, s, k);
+            w->s = s;
+            w->k = k;
+    }
+
+    return (1);
+}
+
+/* the inverse of the A matrix of the current configuration - called from thole_bmatrix() */
+void thole_woodbury(system_t *system, int n) {
+    woodbury_t *w;
+    int s, k, i;
+
+    thole_woodbury_setup(system, n);
+    w = system->B_woodbury;
+
+    if (w->pending && w->valid && (w->updates < system->polar_woodbury_refresh) && thole_woodbury_rows(system, &s, &k) && thole_woodbury_low_rank(system, n, s, k)) {
+        /* the trial inverse from the accepted one */
+        w->trial_updates = w->updates + 1;
+        w->applied = 1;
+    } else if (w->pending) {
+        /* a trial inverse from scratch, the accepted one stays for a reject */
+        thole_woodbury_full(system, n, w->B_trial);
+        w->s = 0;
+        w->k = n;
+        w->trial_updates = 0;
+        w->applied = 1;
+    } else {
+        /* no move to go by, so this is the accepted configuration */
+        thole_woodbury_full(system, n, w->B);
+        for (i = 0; i < n; i++)
+            memcpy(&w->A[i * n], system->A_matrix[i], n * sizeof(double));
+        w->n = n;
+        w->updates = 0;
+        w->valid = 1;
+        w->applied = 0;
+    }
+    w->pending = 0;
+
+    w->current = w->applied ? w->B_trial : w->B;
+}
+
+/* a move was made, the inverse has yet to see it */
+void thole_woodbury_move(system_t *system) {
+    woodbury_t *w = system->B_woodbury;
+
+    w->pending = 1;
+    w->applied = 0;
+}
+
+/* the move was rejected, the accepted inverse is untouched */
+void thole_woodbury_restore(system_t *system) {
+    woodbury_t *w = system->B_woodbury;
+
+    w->pending = 0;
+    w->applied = 0;
+    w->current = w->B;
+}
+
+/* the move was accepted, the trial inverse and A become the accepted ones */
+void thole_woodbury_accept(system_t *system) {
+    woodbury_t *w = system->B_woodbury;
+    double *swap;
+    int i, n;
+
+    if (w->applied) {
+        swap = w->B;
+        w->B = w->B_trial;
+        w->B_trial = swap;
+        n = w->n = w->n_trial;
+        w->updates = w->trial_updates;
+
+        /* only the S rows and columns of A changed */
+        for (i = 0; i < n; i++) {
+            if ((i >= w->s) && (i < w->s + w->k))
+                memcpy(&w->A[i * n], system->A_matrix[i], n * sizeof(double));
+            else
+                memcpy(&w->A[i * n + w->s], &system->A_matrix[i][w->s], w->k * sizeof(double));
+        }
+        w->valid = 1;
+    } else if (w->pending)
+        w->valid = 0; /* the move never reached the inverse (e.g. a bad contact) */
+
+    w->pending = 0;
+    w->applied = 0;
+    w->current = w->B;
+}